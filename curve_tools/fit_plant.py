@@ -0,0 +1,221 @@
+"""
+fit_plant.py – fit the pump + fluidics plant model used by the host simulator
+(pid_controller/host/plant_sim.*) to the recorded runs, and write the result
+to pid_controller/host/plant_params.h.
+
+Model (raw sensor flow y in mL/min, pump drive u in V):
+
+    target(t) = K · (1 − drift · t_h) · max(u(t − L) − V0, 0)
+    dy/dt     = (target − y) / tau
+
+K (gain), V0 (dead band), tau (fluidic lag), L (transport delay) and drift
+(gain loss per hour of pumping) are fitted per run: tau/L/V0 on a grid,
+K and drift by linear least squares for each grid point. The logged flow is
+compensated by errorPct, so it is converted back to the raw sensor reading
+first. The residual spread gives the sensor noise.
+
+Only the standard library is used, so this runs wherever the host build does:
+
+    python curve_tools/fit_plant.py            # fit + rewrite plant_params.h
+    python curve_tools/fit_plant.py --dry-run  # print the fits only
+"""
+
+import csv
+import glob
+import math
+import os
+import statistics
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+RUN_GLOBS = [
+    "volume_calc_test/*/raw/data/*.csv",
+    "data_demo_1/*/raw/data/*.csv",
+]
+OUT_HEADER = os.path.join(ROOT, "pid_controller", "host", "plant_params.h")
+
+# ── Fit grid ──────────────────────────────────────────────────────────────────
+TAU_GRID   = [0.1 * 1.35 ** i for i in range(14)]        # 0.1 … 4.9 s
+DELAY_GRID = [0.0, 0.15, 0.3, 0.5, 0.8, 1.2, 1.8]        # s
+V0_GRID    = [2.5 * i for i in range(17)]                # 0 … 40 V
+
+MIN_SAMPLES = 200      # runs shorter than this (pump on) are skipped
+MIN_VOLT    = 5.0      # runs that never drive the pump are skipped
+MIN_R2      = 0.7      # runs the model cannot explain are reported, not used
+
+# Pump pulsation is at BARTELS_FREQ (300 Hz); the logs are sampled at ~6 Hz,
+# so it only shows up as part of the residual. Its share is assumed here.
+PULSE_REL_AMPLITUDE = 0.10
+
+
+# ── Loading ───────────────────────────────────────────────────────────────────
+def load_run(path):
+    """Returns (t_s, u_V, y_raw) for the pump-on part of a run."""
+    t, u, y = [], [], []
+    with open(path, newline="") as fh:
+        for r in csv.DictReader(fh):
+            if r.get("on") != "True":
+                continue
+            try:
+                ts   = float(r["timeMs"]) / 1000.0
+                volt = float(r["volt"])
+                flow = float(r["flow"])
+                err  = float(r["errorPct"])
+            except (KeyError, ValueError):
+                continue
+            if r.get("bubble") == "True":
+                continue
+            t.append(ts)
+            u.append(volt)
+            y.append(flow * (1.0 - err / 100.0))   # undo compensateFlow()
+    if t:
+        t0 = t[0]
+        t = [x - t0 for x in t]
+    return t, u, y
+
+
+# ── Model ─────────────────────────────────────────────────────────────────────
+def unit_response(t, u, tau, delay, v0):
+    """Unit-gain lag response to max(u(t − delay) − v0, 0)."""
+    x, out, j = 0.0, [], 0
+    for i in range(len(t)):
+        while j + 1 < len(t) and t[j + 1] <= t[i] - delay:
+            j += 1
+        drive = u[j] - v0 if t[i] - delay >= 0.0 else 0.0
+        if drive < 0.0:
+            drive = 0.0
+        if i:
+            a = 1.0 - math.exp(-(t[i] - t[i - 1]) / tau)
+            x += a * (drive - x)
+        out.append(x)
+    return out
+
+
+def solve_gain(t, x, y):
+    """Least squares for y ≈ a·x + b·(t_h·x); returns (K, drift, sse)."""
+    sxx = sxz = szz = sxy = szy = 0.0
+    for ti, xi, yi in zip(t, x, y):
+        zi = xi * ti / 3600.0
+        sxx += xi * xi; sxz += xi * zi; szz += zi * zi
+        sxy += xi * yi; szy += zi * yi
+    det = sxx * szz - sxz * sxz
+    if sxx <= 0.0:
+        return 0.0, 0.0, float("inf")
+    if abs(det) < 1e-12 * sxx * max(szz, 1e-12):
+        a, b = sxy / sxx, 0.0
+    else:
+        a = (sxy * szz - szy * sxz) / det
+        b = (szy * sxx - sxy * sxz) / det
+    sse = sum((yi - (a + b * ti / 3600.0) * xi) ** 2 for ti, xi, yi in zip(t, x, y))
+    drift = -b / a if a > 0.0 else 0.0
+    return a, drift, sse
+
+
+def fit_run(t, u, y):
+    best = None
+    for tau in TAU_GRID:
+        for delay in DELAY_GRID:
+            for v0 in V0_GRID:
+                x = unit_response(t, u, tau, delay, v0)
+                k, drift, sse = solve_gain(t, x, y)
+                if k <= 0.0:
+                    continue
+                if best is None or sse < best["sse"]:
+                    best = dict(tau=tau, delay=delay, v0=v0, k=k, drift=drift, sse=sse)
+    if best is None:
+        return None
+    mean = sum(y) / len(y)
+    sst = sum((yi - mean) ** 2 for yi in y)
+    best["r2"] = 1.0 - best["sse"] / sst if sst > 0 else 0.0
+    best["rms"] = math.sqrt(best["sse"] / len(y))
+    best["mean_flow"] = mean
+    best["n"] = len(y)
+    return best
+
+
+# ── Output ────────────────────────────────────────────────────────────────────
+def write_header(params, fits):
+    lines = [
+        "#pragma once",
+        "",
+        "/*",
+        " * File: plant_params.h",
+        " * Brief: Plant model parameters fitted from the recorded runs.",
+        " *",
+        " *   GENERATED by curve_tools/fit_plant.py – rerun it after adding runs",
+        " *   instead of editing by hand. Median over the runs marked '*':",
+        " *",
+        " *   run                                         n     K       V0    tau   L     drift/h  R2",
+    ]
+    for name, f, used in fits:
+        lines.append(" *   %s %-42s %5d %.5f %5.1f %5.2f %4.2f %7.3f %5.2f" % (
+            "*" if used else " ", name[:42], f["n"], f["k"], f["v0"], f["tau"],
+            f["delay"], f["drift"], f["r2"]))
+    lines += [
+        " *",
+        " *   Pulsation at BARTELS_FREQ is not visible in ~6 Hz logs; its amplitude",
+        " *   is an assumption and the sensor noise is what remains of the residual.",
+        " */",
+        "",
+        "static const float PLANT_GAIN_MLMIN_PER_V = %.6ff;   // K" % params["k"],
+        "static const float PLANT_DEADBAND_V       = %.2ff;      // V0" % params["v0"],
+        "static const float PLANT_TAU_S            = %.3ff;     // fluidic lag" % params["tau"],
+        "static const float PLANT_DELAY_S          = %.3ff;     // transport delay" % params["delay"],
+        "static const float PLANT_DRIFT_PER_HOUR   = %.4ff;    // gain loss while pumping" % params["drift"],
+        "static const float PLANT_GAIN_SPREAD      = %.4ff;    // run-to-run std of K / K" % params["k_spread"],
+        "static const float PLANT_PULSE_REL        = %.3ff;     // ripple amplitude / mean flow (assumed)" % params["pulse"],
+        "static const float PLANT_SENSOR_NOISE     = %.5ff;   // mL/min, 1 sigma per read" % params["noise"],
+        "",
+    ]
+    with open(OUT_HEADER, "w", newline="\n") as fh:
+        fh.write("\n".join(lines))
+
+
+def main():
+    dry_run = "--dry-run" in sys.argv
+    paths = sorted(p for g in RUN_GLOBS for p in glob.glob(os.path.join(ROOT, g)))
+
+    fits, used = [], []
+    for path in paths:
+        name = os.path.splitext(os.path.basename(path))[0].replace("raw_", "")
+        t, u, y = load_run(path)
+        if len(t) < MIN_SAMPLES or max(u) < MIN_VOLT:
+            print("skip %-50s (pump not driven)" % name)
+            continue
+        f = fit_run(t, u, y)
+        if f is None:
+            print("skip %-50s (no fit)" % name)
+            continue
+        ok = f["r2"] >= MIN_R2
+        fits.append((name, f, ok))
+        if ok:
+            used.append(f)
+        print("%s %-50s K=%.5f V0=%4.1f tau=%.2f L=%.2f drift=%.3f/h R2=%.2f rms=%.4f" % (
+            "*" if ok else " ", name, f["k"], f["v0"], f["tau"], f["delay"],
+            f["drift"], f["r2"], f["rms"]))
+
+    if not used:
+        print("no usable runs")
+        return 1
+
+    med = lambda key: statistics.median(f[key] for f in used)
+    k = med("k")
+    k_spread = statistics.pstdev([f["k"] for f in used]) / k if len(used) > 1 else 0.0
+    mean_flow = med("mean_flow")
+    resid = med("rms")
+    pulse_share = (PULSE_REL_AMPLITUDE * mean_flow) ** 2 / 2.0
+    noise = math.sqrt(max(resid * resid - pulse_share, (0.25 * resid) ** 2))
+
+    params = dict(k=k, v0=med("v0"), tau=med("tau"), delay=med("delay"),
+                  drift=max(med("drift"), 0.0), k_spread=k_spread,
+                  pulse=PULSE_REL_AMPLITUDE, noise=noise)
+    print("median: " + ", ".join("%s=%.5g" % kv for kv in params.items()))
+
+    if not dry_run:
+        write_header(params, fits)
+        print("wrote " + os.path.relpath(OUT_HEADER, ROOT))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <EEPROM.h>
+#include <atomic>
 
 // Project headers
 #include "config.h"
@@ -16,196 +17,462 @@
 #include "exp_control.h"  // Exponential-based control
 #include "constant_voltage_control.h"
 #include "filter.h"
+#include "scheduler.h"
+#include "state_snapshot.h"
+#include "sample_ring.h"
+#include "bench.h"
+#include "tx_buffer.h"
+#include "telemetry.h"
+#include "log.h"
+#include "profiler.h"
+#include "i2c_bus.h"
+#include "trend.h"
+#include "settings.h"
+#include "control_cycle.h"
 
 // Combined runtime state
 #include "system_state.h"
 
-// Global system state
+/*
+ * Threading model (ESP32-S3):
+ *   core 1, highest       : acquisition   – SLF3S read every base tick → flow ring
+ *   core 1, high priority : control task  – latest sample, filter, PID, pump
+ *   core 0, low priority  : I/O task      – button events/EEPROM, serial, telemetry, display
+ *   esp_timer task        : button sampling + debounce (buttons.cpp), 1 kHz
+ *
+ *   acquisition → readers : SampleRing (lock-free, zero-copy, one cursor per reader)
+ *   button timer → I/O : event queue, also a SampleRing
+ *   control → I/O : SystemState snapshot through a seqlock (never blocks the writer)
+ *   I/O → control : operator inputs through atomics (buttons.cpp, s_requestedMode)
+ *   tasks → serial : each task prints into its own TxBuffer; only the I/O
+ *                    task writes to Serial, never more than it accepts
+ *   tasks → I2C    : bus manager (i2c_bus.h); sensor, then pump, then the
+ *                    display in chunks that never delay the other two
+ */
+
+// Control-core working state (only the control task touches it)
 static SystemState g_systemState;
 
+// Published copy for the I/O core
+static SeqlockSnapshot<SystemState> s_stateSnapshot;
+
+// Timestamped flow samples from the acquisition task
+static FlowRing s_flowRing;
+
+// Operator-selected control mode (written by I/O, read by control)
+static std::atomic<uint8_t> s_requestedMode{CONTROL_MODE_EXP};
+
+// Serial output of the control and I/O tasks (drained by the I/O task)
+static TxBuffer<TX_CONTROL_BUFFER_SIZE> s_controlTx;
+static TxBuffer<TX_IO_BUFFER_SIZE>      s_ioTx;
+
 // Timing and reporting flags
 static unsigned long startTime = 0;
 static bool timeReportingEnabled = false;
+static bool binaryTelemetry = TELEMETRY_BINARY_DEFAULT;   // I/O task only
+static uint32_t telemetryRuns = 0;
+
+// Fields the host asked for ('S' command); the default follows the encoding
+static TelemetrySubscription s_subscription;
+static bool s_customSubscription = false;
+
+// 'S' command line being received (I/O task)
+static char    s_cmdLine[128];
+static uint8_t s_cmdLen = 0;
+static bool    s_cmdActive = false;
 
-// Track systemOn transitions in the main loop
-static bool previousSystemOn = false;
+// Scheduled activities (rates in config.h)
+enum {
+    TASK_SENSOR = 0,      // acquisition task (control core)
+    TASK_CONTROL,         // control core
+    TASK_BUTTONS,         // I/O core
+    TASK_TELEMETRY,       // I/O core
+    TASK_DISPLAY,         // I/O core
+    TASK_COUNT
+};
+static SchedTask s_tasks[TASK_COUNT];
+
+// Hot-path benchmark ('B'): control-path cases run in the control task
+// while the system is off, then the I/O task adds its cases and prints
+enum { BENCH_IDLE = 0, BENCH_REQUESTED, BENCH_REFUSED, BENCH_CONTROL_DONE };
+static std::atomic<uint8_t> s_benchStage{BENCH_IDLE};
+static BenchReport s_benchReport;
+
+// Control-rate measurement (printed every 2 s)
+static std::atomic<uint32_t> controlCount{0};
+static unsigned long lastFreqCheckMs = 0;
+
+static void acquisitionTask(void *);
+static void controlTask(void *);
+static void ioTask(void *);
+static void subscribeDefaultTelemetry();
 
 void setup() {
     Serial.begin(115200);
     Wire.begin();
-    EEPROM.begin(512);
+    Wire.setClock(I2C_CLOCK_HZ);
+    initI2cBus();
+    EEPROM.begin(SETTINGS_EEPROM_SIZE);
+    if (!initSettings()) {
+        LOG_INFO(LOG_CAT_MAIN, "No saved settings, using defaults.");
+    }
 
     initButtons();
     initBartels();
     initDisplay();
-
-    // Default control mode => EXP
-    g_systemState.controlMode = CONTROL_MODE_EXP;
+    initTrend();
 
     // Initialize control modules
     initExpController(g_systemState); 
     initConstantVoltageControl();
 
+    // Control mode as last saved (EXP on a fresh unit)
+    s_requestedMode.store(currentSettings().controlMode);
+    g_systemState.controlMode = (ControlMode)s_requestedMode.load();
+    s_stateSnapshot.publish(g_systemState);
+    subscribeDefaultTelemetry();
+
     // Start flow measurement
     bool ok = startFlowMeasurement();
     if (!ok) {
-        Serial.println("[MAIN DEBUG] startFlowMeasurement() failed (I2C error?).");
+        LOG_ERROR(LOG_CAT_FLOW, "startFlowMeasurement() failed (I2C error?), retrying.");
+    }
+
+    initSchedTask(s_tasks[TASK_SENSOR],    "sensor",    SENSOR_DIVIDER);
+    initSchedTask(s_tasks[TASK_CONTROL],   "control",   CONTROL_DIVIDER);
+    initSchedTask(s_tasks[TASK_BUTTONS],   "buttons",   BUTTONS_DIVIDER);
+    initSchedTask(s_tasks[TASK_TELEMETRY], "telemetry", TELEMETRY_BINARY_DIVIDER);
+    initSchedTask(s_tasks[TASK_DISPLAY],   "display",   DISPLAY_DIVIDER);
+    if (!initScheduler(SCHED_TICK_US)) {
+        LOG_ERROR(LOG_CAT_MAIN, "initScheduler() failed (esp_timer?).");
     }
 
     startTime = millis();
-    Serial.println("[MAIN DEBUG] Setup complete. Entering main loop...");
+    lastFreqCheckMs = startTime;
+
+    xTaskCreatePinnedToCore(acquisitionTask, "acq", ACQ_TASK_STACK, nullptr,
+                            ACQ_TASK_PRIORITY, nullptr, ACQ_TASK_CORE);
+    xTaskCreatePinnedToCore(controlTask, "control", CONTROL_TASK_STACK, nullptr,
+                            CONTROL_TASK_PRIORITY, nullptr, CONTROL_TASK_CORE);
+    xTaskCreatePinnedToCore(ioTask, "io", IO_TASK_STACK, nullptr,
+                            IO_TASK_PRIORITY, nullptr, IO_TASK_CORE);
+
+    LOG_INFO(LOG_CAT_MAIN, "Setup complete. Acquisition, control + I/O tasks started.");
 }
 
-void loop() {
-    // 1) Check serial input for time-report toggle
-    if (Serial.available() > 0) {
+// Runs a task body if it is due at this tick, with timing statistics
+static void runIfDue(uint8_t id, uint32_t tick, void (*body)()) {
+    if (!schedTaskDue(s_tasks[id], tick)) return;
+    uint32_t startUs = schedTaskBegin(s_tasks[id]);
+    body();
+    schedTaskEnd(s_tasks[id], startUs);
+}
+
+/*──────────────────────── ACQUISITION ────────────────────────────────────*/
+
+// One sensor read into the next ring slot (in place, no copy)
+static void runSensorTask() {
+    PROFILE_SCOPE(PROF_SENSOR);
+    FlowSample &slot = s_flowRing.writeSlot();
+    if (acquireFlowSample(slot)) {
+        s_flowRing.publish();
+    }
+}
+
+static void acquisitionTask(void *) {
+    schedAttachCurrentTask(SENSOR_DIVIDER);
+
+    for (;;) {
+        uint32_t tick = schedWaitTick();
+        runIfDue(TASK_SENSOR, tick, runSensorTask);
+    }
+}
+
+/*──────────────────────── CONTROL CORE ───────────────────────────────────*/
+
+// Control task's flow ring position, decimator and flow-path state
+static ControlCycle s_controlCycle;
+
+// One control cycle (control_cycle.cpp), then hand-off and run timer
+static void runControlTask() {
+    runControlCycle(s_controlCycle, s_flowRing, g_systemState,
+                    (ControlMode)s_requestedMode.load());
+
+    // Hand the finished cycle to the I/O core
+    s_stateSnapshot.publish(g_systemState);
+
+    // Auto-stop if run duration exceeded
+    unsigned long elapsed = (g_systemState.currentTimeMs - startTime) / 1000UL;
+    if (elapsed > SLF_RUN_DURATION) {
+        stopFlowMeasurement();
+        stopPump();
+        flushBartels();
+        LOG_INFO(LOG_CAT_MAIN, "Timer expired. Flow + pump stopped.");
+        while (true) {
+            delay(100);
+        }
+    }
+
+    controlCount++;
+}
+
+static void controlTask(void *) {
+    logAttachCurrentTask(s_controlTx);
+    initControlCycle(s_controlCycle, s_flowRing);
+    schedAttachCurrentTask(CONTROL_DIVIDER);
+
+    for (;;) {
+        uint32_t tick = schedWaitTick();
+
+        if (s_benchStage.load() == BENCH_REQUESTED) {
+            if (isSystemOn()) {
+                s_benchStage.store(BENCH_REFUSED);
+            } else {
+                initBenchReport(s_benchReport);
+                benchControlPath(s_benchReport);
+                s_benchStage.store(BENCH_CONTROL_DONE);
+            }
+        }
+
+        runIfDue(TASK_CONTROL, tick, runControlTask);
+    }
+}
+
+/*──────────────────────── I/O CORE ───────────────────────────────────────*/
+
+// Every field, at 25 Hz as JSON or on every telemetry run as binary
+static void subscribeDefaultTelemetry() {
+    subscribeAllTelemetry(s_subscription, binaryTelemetry ? 1 : TELEMETRY_DIVIDER / TELEMETRY_BINARY_DIVIDER);
+}
+
+// Applies a complete 'S' line; an empty one restores the default
+static void applySubscription(const char *list) {
+    const char *errorAt = nullptr;
+    if (!*list) {
+        s_customSubscription = false;
+        subscribeDefaultTelemetry();
+        s_ioTx.println("[MAIN DEBUG] Subscription: default");
+    } else if (parseTelemetrySubscription(list, s_subscription, &errorAt)) {
+        s_customSubscription = true;
+        s_ioTx.print("[MAIN DEBUG] Subscription: ");
+        s_ioTx.println(list);
+    } else {
+        s_ioTx.print("[MAIN DEBUG] Subscription rejected at: ");
+        s_ioTx.println(errorAt);
+    }
+}
+
+// Collects an 'S' line without blocking; true once it is complete
+static bool readCommandLine() {
+    while (Serial.available() > 0) {
         char c = Serial.read();
-        if (c == 'T' || c == 't') {
-            timeReportingEnabled = !timeReportingEnabled;
-            Serial.print("[MAIN DEBUG] Timing report: ");
-            Serial.println(timeReportingEnabled ? "ENABLED" : "DISABLED");
+        if (c == '\n' || c == '\r') {
+            s_cmdLine[s_cmdLen] = '\0';
+            s_cmdActive = false;
+            return true;
         }
+        if (c != ' ' && s_cmdLen + 1u < sizeof s_cmdLine) s_cmdLine[s_cmdLen++] = c;
+    }
+    return false;
+}
+
+/*
+ * Serial commands:
+ *   T = toggle timing report, J = dump scheduler jitter/miss histograms,
+ *   R = reset scheduler, profiler and bus statistics, P = dump stage profile
+ *   (cycles per stage, log2 histograms), I = I2C bus occupancy per device,
+ *   B = hot-path benchmark (JSON, system off),
+ *   X = toggle binary telemetry (COBS frames, see telemetry.h),
+ *   S<fields> = telemetry subscription, e.g. "Sflow,setpt,pGain:50,iGain:50"
+ *     (field:divisor in telemetry runs of ≈ 6.7 ms, "*" = all fields,
+ *     bare "S" = back to the default), ended by a newline.
+ */
+static void handleSerialCommands() {
+    if (s_cmdActive) {
+        if (readCommandLine()) applySubscription(s_cmdLine);
+        return;
+    }
+    if (Serial.available() <= 0) return;
+
+    char c = Serial.read();
+    if (c == 'S' || c == 's') {
+        s_cmdLen    = 0;
+        s_cmdActive = true;
+        if (readCommandLine()) applySubscription(s_cmdLine);
+    } else if (c == 'T' || c == 't') {
+        timeReportingEnabled = !timeReportingEnabled;
+        s_ioTx.print("[MAIN DEBUG] Timing report: ");
+        s_ioTx.println(timeReportingEnabled ? "ENABLED" : "DISABLED");
+    } else if (c == 'J' || c == 'j') {
+        // Control-core counters are read live; a value may be one update stale
+        printSchedStats(s_tasks, TASK_COUNT, s_ioTx);
+    } else if (c == 'P' || c == 'p') {
+        // Counters of the other tasks are read live, like the scheduler's
+        printProfile(s_ioTx);
+    } else if (c == 'I' || c == 'i') {
+        printI2cBusStats(s_ioTx);
+    } else if (c == 'R' || c == 'r') {
+        // Each task clears its own counters on its next release
+        resetSchedStats(s_tasks, TASK_COUNT);
+        resetProfile();
+        resetI2cBusStats();
+        s_ioTx.println("[MAIN DEBUG] Scheduler, profiler and bus statistics reset.");
+    } else if (c == 'X' || c == 'x') {
+        binaryTelemetry = !binaryTelemetry;
+        if (!s_customSubscription) subscribeDefaultTelemetry();
+        s_ioTx.beginRecord();
+        s_ioTx.print("[MAIN DEBUG] Telemetry: ");
+        s_ioTx.println(binaryTelemetry ? "BINARY" : "JSON");
+        // Terminates the text line as far as a frame decoder is concerned
+        if (binaryTelemetry) s_ioTx.write((uint8_t)0x00);
+        s_ioTx.endRecord();
+    } else if (c == 'B' || c == 'b') {
+        uint8_t idle = BENCH_IDLE;
+        s_benchStage.compare_exchange_strong(idle, BENCH_REQUESTED);
+    }
+}
+
+// Finishes a benchmark once the control task has run its part
+static void serviceBench() {
+    uint8_t stage = s_benchStage.load();
+    if (stage == BENCH_REFUSED) {
+        s_ioTx.println("[MAIN DEBUG] Benchmark needs the system OFF.");
+        s_benchStage.store(BENCH_IDLE);
+    } else if (stage == BENCH_CONTROL_DONE) {
+        SystemState snap;
+        s_stateSnapshot.read(snap);
+        benchIoPath(s_benchReport, snap);
+        printBenchJSON(s_ioTx, s_benchReport);
+        s_benchStage.store(BENCH_IDLE);
     }
+}
 
-    // 2) Update system-on state from buttons
+// Button events, the mode toggle request and settings commits
+static void runButtonsTask() {
+    PROFILE_SCOPE(PROF_BUTTONS);
     updateButtons();
-    bool currentSystemOn = isSystemOn();
-    g_systemState.systemOn = currentSystemOn;
-
-    // Detect OFF->ON or ON->OFF transitions here in the main loop
-    if (!previousSystemOn && currentSystemOn) {
-        // System just turned ON
-        Serial.println("[MAIN DEBUG] System turned ON (main loop) -> initExpController()");
-        initExpController(g_systemState);
-    } 
-    else if (previousSystemOn && !currentSystemOn) {
-        // System just turned OFF
-        Serial.println("[MAIN DEBUG] System turned OFF (main loop) -> initExpController()");
-        initExpController(g_systemState);
-        // Optionally stop pump
-        // stopPump();
-    }
-    previousSystemOn = currentSystemOn;
-
-    // 3) Toggle control mode if requested
+
     if (wasModeTogglePressed()) {
         // Flip between EXP and CONST_VOLTAGE
-        if (g_systemState.controlMode == CONTROL_MODE_EXP) {
-            g_systemState.controlMode = CONTROL_MODE_CONST_VOLTAGE;
-            Serial.println("[MAIN DEBUG] Mode changed -> CONSTANT VOLTAGE");
+        if (s_requestedMode.load() == CONTROL_MODE_EXP) {
+            s_requestedMode.store(CONTROL_MODE_CONST_VOLTAGE);
+            LOG_INFO(LOG_CAT_MAIN, "Mode changed -> CONSTANT VOLTAGE");
         } else {
-            g_systemState.controlMode = CONTROL_MODE_EXP;
-            Serial.println("[MAIN DEBUG] Mode changed -> EXP CONTROL");
+            s_requestedMode.store(CONTROL_MODE_EXP);
+            LOG_INFO(LOG_CAT_MAIN, "Mode changed -> EXP CONTROL");
         }
+        Settings updated    = currentSettings();
+        updated.controlMode = s_requestedMode.load();
+        changeSettings(updated);
     }
 
-    // 4) Acquire sensor inputs
-    g_systemState.flow         = readFlow();
-    g_systemState.setpoint     = getFlowSetpoint();
-    g_systemState.errorPercent = getErrorPercent();
-    g_systemState.temperature  = getTempC();
-
-    uint16_t flags = getLastFlags();
-    g_systemState.bubbleDetected = ((flags & (1 << 0)) != 0);
-
-    // 5) Control logic
-    float desiredVoltage = 0.0f;
-    float pidFraction    = 0.0f;
-    float pTerm          = 0.0f;
-    float iTerm          = 0.0f;
-    float dTerm          = 0.0f;
-
-    if (g_systemState.systemOn) {
-        switch (g_systemState.controlMode) {
-            case CONTROL_MODE_EXP:
-                Serial.println("[MAIN DEBUG] (ON) Calling updateExpController()...");
-                updateExpController(
-                    g_systemState,
-                    g_systemState.flow,
-                    g_systemState.setpoint,
-                    g_systemState.errorPercent,
-                    g_systemState.systemOn,
-                    desiredVoltage,
-                    pidFraction,
-                    g_systemState.bubbleDetected,
-                    pTerm,
-                    iTerm,
-                    dTerm
-                );
-                Serial.println("[MAIN DEBUG] Returned from updateExpController()");
-                break;
-
-            case CONTROL_MODE_CONST_VOLTAGE:
-                Serial.println("[MAIN DEBUG] (ON) Calling updateConstantVoltageControl()...");
-                updateConstantVoltageControl(g_systemState.systemOn, desiredVoltage);
-                Serial.println("[MAIN DEBUG] Returned from updateConstantVoltageControl()");
-                break;
-        }
+    // Long press: status screen <-> trend page
+    if (wasPageTogglePressed()) {
+        uint8_t page = toggleDisplayPage();
+        LOG_INFO(LOG_CAT_MAIN, "Display page -> %s", page == DISPLAY_PAGE_TREND ? "TREND" : "STATUS");
+    }
+
+    // Flash commit once the changes have settled, or on switch-off
+    serviceSettings(isSystemOn());
+}
+
+// Telemetry: the subscribed fields that are due on this run, if any
+static void runTelemetryTask() {
+    PROFILE_SCOPE(PROF_TELEMETRY);
+    uint32_t fields = dueTelemetryFields(s_subscription, telemetryRuns++);
+    if (!fields) return;
+
+    SystemState snap;
+    s_stateSnapshot.read(snap);
+    snap.txDrops = s_ioTx.dropped() + s_controlTx.dropped();
+    if (binaryTelemetry) {
+        s_ioTx.beginRecord();
+        reportStateBinary(snap, fields, s_ioTx);
+        s_ioTx.endRecord();
     } else {
-        // If system is OFF, no controller updates
-        stopPump();
-        desiredVoltage = 0.0f;
-        pidFraction = 0.0f;
-        pTerm = 0.0f;
-        iTerm = 0.0f;
-        dTerm = 0.0f;
+        reportStateJSON(snap, fields, s_ioTx);
+    }
+}
+
+// Serial output: alternates between the task buffers, switching only on a
+// record boundary so lines and frames never interleave; writes no more than
+// the driver can take without blocking
+static void drainSerialTx() {
+    static bool ioTurn = false;
+    size_t room = Serial.availableForWrite();
+    for (uint8_t i = 0; i < 2 && room > 0; i++) {
+        bool boundary = ioTurn ? s_ioTx.drain(Serial, room)
+                               : s_controlTx.drain(Serial, room);
+        if (!boundary) return;        // mid-record: same buffer next time
+        ioTurn = !ioTurn;
     }
+}
 
-    // 6) Save final results in g_systemState
-    g_systemState.desiredVoltage = desiredVoltage;
-    g_systemState.pidOutput      = pidFraction;
-    g_systemState.pTerm          = pTerm;
-    g_systemState.iTerm          = iTerm;
-    g_systemState.dTerm          = dTerm;
+// Trend history at control rate (the snapshot changes once per control cycle)
+static void sampleTrend() {
+    SystemState snap;
+    s_stateSnapshot.read(snap);
+    pushTrendSample(snap.flow, snap.setpoint);
+}
 
-    // 7) Display the current status
+// Post the current status (drawn and sent by serviceDisplay)
+static void runDisplayTask() {
+    SystemState snap;
+    s_stateSnapshot.read(snap);
     showStatus(
-        g_systemState.flow,
-        g_systemState.setpoint,
-        g_systemState.errorPercent,
-        g_systemState.desiredVoltage,
-        g_systemState.systemOn,
-        g_systemState.temperature,
-        g_systemState.bubbleDetected
+        snap.flow,
+        snap.setpoint,
+        snap.errorPercent,
+        snap.desiredVoltage,
+        snap.systemOn,
+        snap.temperature,
+        snap.bubbleDetected
     );
+}
 
-    // 8) JSON reporting
-    g_systemState.currentTimeMs = millis();
-    reportAllStateJSON(g_systemState);
+static void ioTask(void *) {
+    logAttachCurrentTask(s_ioTx);
+    schedAttachCurrentTask(IO_TICK_DIVIDER);
 
-    // 9) Auto-stop if run duration exceeded
-    unsigned long elapsed = (g_systemState.currentTimeMs - startTime) / 1000UL;
-    if (elapsed > SLF_RUN_DURATION) {
-        stopFlowMeasurement();
-        stopPump();
-        Serial.println("[MAIN DEBUG] Timer expired. Flow + pump stopped.");
-        while (true) {
-            delay(100);
+    for (;;) {
+        uint32_t tick = schedWaitTick();
+
+        handleSerialCommands();
+        serviceBench();
+
+        runIfDue(TASK_BUTTONS,   tick, runButtonsTask);
+        runIfDue(TASK_TELEMETRY, tick, runTelemetryTask);
+        runIfDue(TASK_DISPLAY,   tick, runDisplayTask);
+
+        sampleTrend();
+
+        // A few display chunks, in the gaps the sensor and pump leave
+        {
+            PROFILE_SCOPE(PROF_DISPLAY);
+            serviceDisplay();
         }
-    }
 
-    // 10) Delay loop
-    delay(MAIN_LOOP_DELAY_MS);
+        // Optional timing info
+        if (timeReportingEnabled) {
+            LOG_INFO(LOG_CAT_MAIN, "Loop iteration complete.");
+        }
 
-    // 11) Optional timing info
-    if (timeReportingEnabled) {
-        Serial.println("[MAIN DEBUG] Loop iteration complete.");
-    }
+        // Control frequency measurement
+        unsigned long nowMs = millis();
+        if (nowMs - lastFreqCheckMs >= 2000UL) {
+            float loopsPerSecond =
+                1000.0f * (static_cast<float>(controlCount.exchange(0)) / (nowMs - lastFreqCheckMs));
 
-    // 12) Loop frequency measurement
-    static unsigned long loopCount       = 0;
-    static unsigned long lastFreqCheckMs = 0;
-    loopCount++;
-    unsigned long nowMs = millis();
-    if (nowMs - lastFreqCheckMs >= 2000UL) {
-        float loopsPerSecond =
-            1000.0f * (static_cast<float>(loopCount) / (nowMs - lastFreqCheckMs));
+            LOG_INFO(LOG_CAT_MAIN, "~%.2f Hz loop frequency.", loopsPerSecond);
 
-        Serial.print("[MAIN DEBUG] ~");
-        Serial.print(loopsPerSecond, 2);
-        Serial.println(" Hz loop frequency.");
+            lastFreqCheckMs = nowMs;
+        }
 
-        loopCount = 0;
-        lastFreqCheckMs = nowMs;
+        drainSerialTx();
     }
 }
+
+// The Arduino loop task is not used; control and I/O run in their own tasks
+void loop() {
+    vTaskDelete(NULL);
+}
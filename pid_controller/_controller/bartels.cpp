@@ -1,25 +1,90 @@
 /*
  * File: bartels.cpp
  * Brief: Manages the Bartels micropump driver (amplitude-only control after init).
+ *
+ * Commands are posted, not executed inline: runSequence()/stopPump() store
+ * the newest request and serviceBartels() applies it once the driver has
+ * settled from the previous write. Nothing in here blocks the control loop.
+ *
+ * The mp-Lowdriver register file is mirrored in a local shadow copy
+ * (page 0 = control, page 1 = waveform). Updates only touch the shadow;
+ * flushing sends the dirty registers, packing consecutive ones into a
+ * single auto-increment burst, and skips the page select when the
+ * driver is already on the right page.
  */
 
  #include "bartels.h"
  #include "config.h"
+ #include "i2c_bus.h"
+ #include "log.h"
  #include <Wire.h>
  #include <Arduino.h>
- 
- // Single default delay (milliseconds)
- static const uint16_t default_delay = 40;
- 
+
+ // Settle times (milliseconds): after each pass of a full configuration the
+ // OEM sequence waits 40 ms; an amplitude change takes effect on the next
+ // waveform cycle, so updates are spaced one pump period apart.
+ static const unsigned long BARTELS_CONFIG_SETTLE_MS = 40;
+ static const unsigned long BARTELS_UPDATE_SETTLE_MS =
+     (unsigned long)(1000.0f / BARTELS_FREQ) + 1;
+
+ // A stop the driver did not acknowledge is retried after a delay that
+ // doubles with every failure, so a dead driver costs one full
+ // configuration every few seconds instead of one per control cycle.
+ static const unsigned long BARTELS_STOP_RETRY_MIN_MS = 2 * BARTELS_CONFIG_SETTLE_MS;
+ static const unsigned long BARTELS_STOP_RETRY_MAX_MS = 5000;
+
+ // Register file layout
+ static const uint8_t BARTELS_PAGE0_SIZE   = 4;
+ static const uint8_t BARTELS_PAGE1_SIZE   = 10;
+ static const uint8_t BARTELS_REG_AMPLITUDE = 6;   // page 1
+ static const uint8_t BARTELS_REG_FREQ      = 7;   // page 1
+ static const uint8_t BARTELS_PAGE_UNKNOWN  = 0xFE;
+
+ // Two dirty runs separated by at most this many clean registers are sent
+ // as one burst (re-sending a clean byte is cheaper than a new transaction).
+ static const uint8_t BARTELS_MERGE_GAP = 2;
+
  // Driver state
- static bool bartelsInited = false;
- static bool firstRun      = true;
- 
+ static MODULE_STATE bool bartelsInited = false;
+ static MODULE_STATE bool firstRun      = true;
+ static MODULE_STATE bool pumpStopped   = false;
+
+ // Command pipeline: one pending slot, newest command wins
+ enum BartelsCommand {
+   BARTELS_CMD_NONE = 0,
+   BARTELS_CMD_AMPLITUDE,
+   BARTELS_CMD_STOP
+ };
+ static MODULE_STATE BartelsCommand pendingCmd       = BARTELS_CMD_NONE;
+ static MODULE_STATE float          pendingVoltage   = 0.0f;
+ static MODULE_STATE uint8_t        configPassesLeft = 0;
+ static MODULE_STATE float          configVoltage    = 0.0f;
+ static MODULE_STATE unsigned long  settleUntilMs    = 0;
+ static MODULE_STATE unsigned long  stopRetryMs      = 0;   // current back-off, 0 = last stop went through
+ static MODULE_STATE unsigned long  stopRetryAtMs    = 0;
+
+ // Shadow register file + dirty masks (bit n = register n)
+ static MODULE_STATE uint8_t  shadowPage0[BARTELS_PAGE0_SIZE];
+ static MODULE_STATE uint8_t  shadowPage1[BARTELS_PAGE1_SIZE];
+ static MODULE_STATE uint16_t dirtyPage0  = 0;
+ static MODULE_STATE uint16_t dirtyPage1  = 0;
+ static MODULE_STATE uint8_t  currentPage = BARTELS_PAGE_UNKNOWN;
+
+ // Bus accounting
+ static MODULE_STATE BartelsBusStats busStats = {};
+
  // Forward declarations
- static void writeFullWaveformData(float voltage, uint8_t freqByte);
- static void writeAmplitudeOnly(float voltage);
- static void writeControlData();
- 
+ static void postCommand(BartelsCommand cmd, float voltage);
+ static void beginConfiguration(float voltage, unsigned long now);
+ static void finishStop(unsigned long now);
+ static void loadDefaultRegisters(float voltage, uint8_t freqByte);
+ static void shadowWrite(uint8_t page, uint8_t reg, uint8_t value);
+ static void markAllDirty();
+ static bool flushShadow(bool parkOnPage0);
+ static void flushPage(uint8_t page);
+ static void selectPage(uint8_t page);
+ static bool endTransaction(uint8_t payloadBytes);
+
  // ---------------------------------------------------------------------------
  // OEM-like conversion: freq (Hz) → 0..255 (Bartels register).
  // According to the OEM snippet, freqByte = frequency / 7.8125.
@@ -30,154 +95,329 @@
    if (freqByte == 0) freqByte = 1;
    return freqByte;
  }
- 
+
+ // Voltage → 0..255 amplitude register value
+ static uint8_t computeAmplitudeByte(float voltage) {
+   float ratio = voltage / BARTELS_ABSOLUTE_MAX;
+   if (ratio < 0.0f) ratio = 0.0f;
+   if (ratio > 1.0f) ratio = 1.0f;
+   return (uint8_t)(ratio * 255.0f);
+ }
+
  /*
   * Function: initBartels
   * Brief: Initializes driver state and triggers a two-pass setup on the first run.
   */
  bool initBartels() {
-   bartelsInited = true;
-   firstRun      = true;
+   bartelsInited    = true;
+   firstRun         = true;
+   pumpStopped      = false;
+   currentPage      = BARTELS_PAGE_UNKNOWN;
+   pendingCmd       = BARTELS_CMD_NONE;
+   configPassesLeft = 0;
+   settleUntilMs    = millis();
+   stopRetryMs      = 0;
+   loadDefaultRegisters(0.0f, computeFreqByte(BARTELS_FREQ));
+   markAllDirty();
    return true;
  }
- 
+
  /*
   * Function: runSequence
-  * Brief: Updates driver settings based on the specified voltage.
-  *        On first run: performs full configuration including frequency.
-  *        After that: only updates amplitude (not frequency).
+  * Brief: Posts a new target voltage and returns immediately. A command that
+  *        has not been applied yet is superseded by the newer one.
+  *        First run (or after a stop): full configuration including frequency.
+  *        After that: only the registers that changed (normally just the
+  *        amplitude) go out on the bus.
   */
  void runSequence(float voltage) {
    if (!bartelsInited) return;
- 
+
    if (voltage > BARTELS_MAX_VOLTAGE) voltage = BARTELS_MAX_VOLTAGE;
    if (voltage < BARTELS_MIN_VOLTAGE) voltage = BARTELS_MIN_VOLTAGE;
- 
-   float pumpBaseFreqHz = BARTELS_FREQ;
-   uint8_t freqByte     = computeFreqByte(pumpBaseFreqHz);
- 
-   if (firstRun) {
-     for (int i = 0; i < 2; i++) {
-       writeFullWaveformData(voltage, freqByte);
-       writeControlData();
- 
-       Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-       Wire.write(BARTELS_PAGE_REGISTER);
-       Wire.write(0);
-       Wire.endTransmission();
- 
-       delay(default_delay);
-     }
-     firstRun = false;
-     return;
-   }
- 
-   writeAmplitudeOnly(voltage);
-   writeControlData();
- 
-   Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-   Wire.write(BARTELS_PAGE_REGISTER);
-   Wire.write(0);
-   Wire.endTransmission();
- 
-   delay(default_delay);
+
+   postCommand(BARTELS_CMD_AMPLITUDE, voltage);
  }
- 
+
  /*
   * Function: stopPump
-  * Brief: Sets pump amplitude to zero to halt operation, performing a two-pass write.
+  * Brief: Posts a stop (amplitude zero, two-pass full write). Supersedes any
+  *        pending amplitude. Once stopped, further calls cost no bus traffic;
+  *        a stop the driver did not acknowledge is re-posted only once its
+  *        retry back-off has passed.
   */
  void stopPump() {
-   for (int i = 0; i < 2; i++) {
-     uint8_t freqByte = computeFreqByte(BARTELS_FREQ);
-     writeFullWaveformData(0.0f, freqByte);
-     writeControlData();
- 
-     Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-     Wire.write(BARTELS_PAGE_REGISTER);
-     Wire.write(0);
-     Wire.endTransmission();
- 
-     delay(default_delay);
+   if (!bartelsInited) return;
+   if (pumpStopped && configPassesLeft == 0 &&
+       ((dirtyPage0 == 0 && dirtyPage1 == 0) ||
+        (long)(millis() - stopRetryAtMs) < 0)) {
+     pendingCmd = BARTELS_CMD_NONE;
+     return;
    }
+   postCommand(BARTELS_CMD_STOP, 0.0f);
  }
- 
+
  /*
-  * Function: writeFullWaveformData
-  * Brief: Writes the *entire* 10-byte waveform configuration
-  *        (including amplitude and freq) to page=1.
+  * Function: serviceBartels
+  * Brief: Advances the command pipeline. Never blocks: if the driver is
+  *        still settling from the previous write, it returns at once and the
+  *        newest pending command is applied on a later call.
   */
- static void writeFullWaveformData(float voltage, uint8_t freqByte) {
-   float ratio = voltage / BARTELS_ABSOLUTE_MAX;
-   if (ratio < 0.0f) ratio = 0.0f;
-   if (ratio > 1.0f) ratio = 1.0f;
- 
-   uint8_t amplitude_value = (uint8_t)(ratio * 255.0f);
- 
-   uint8_t waveformData[10] = {
+ void serviceBartels() {
+   if (!bartelsInited) return;
+
+   unsigned long now = millis();
+   if ((long)(now - settleUntilMs) < 0) return;
+
+   // Finish an in-progress full configuration first
+   if (configPassesLeft > 0) {
+     loadDefaultRegisters(configVoltage, computeFreqByte(BARTELS_FREQ));
+     markAllDirty();
+     flushShadow(true);
+     configPassesLeft--;
+     settleUntilMs = now + BARTELS_CONFIG_SETTLE_MS;
+     if (configPassesLeft == 0 && pumpStopped) finishStop(now);
+     return;
+   }
+
+   if (pendingCmd == BARTELS_CMD_NONE) return;
+
+   BartelsCommand cmd = pendingCmd;
+   float voltage      = pendingVoltage;
+   pendingCmd         = BARTELS_CMD_NONE;
+
+   if (cmd == BARTELS_CMD_STOP) {
+     pumpStopped = true;
+     beginConfiguration(0.0f, now);
+     return;
+   }
+
+   if (firstRun || pumpStopped) {
+     firstRun    = false;
+     pumpStopped = false;
+     beginConfiguration(voltage, now);
+     return;
+   }
+
+   shadowWrite(1, BARTELS_REG_AMPLITUDE, computeAmplitudeByte(voltage));
+   shadowWrite(1, BARTELS_REG_FREQ,      computeFreqByte(BARTELS_FREQ));
+
+   if (flushShadow(false)) {
+     settleUntilMs = now + BARTELS_UPDATE_SETTLE_MS;
+   }
+ }
+
+ /*
+  * Function: isBartelsIdle
+  * Brief: True when no command is pending and the driver has settled.
+  */
+ bool isBartelsIdle() {
+   return pendingCmd == BARTELS_CMD_NONE && configPassesLeft == 0 &&
+          (long)(millis() - settleUntilMs) >= 0;
+ }
+
+ /*
+  * Function: flushBartels
+  * Brief: Blocking drain of the pipeline, for shutdown paths only.
+  */
+ void flushBartels() {
+   while (bartelsInited && !isBartelsIdle()) {
+     serviceBartels();
+     delay(1);
+   }
+ }
+
+ // Replaces the pending command (latest wins) and tries to apply it now
+ static void postCommand(BartelsCommand cmd, float voltage) {
+   if (pendingCmd != BARTELS_CMD_NONE) {
+     busStats.commandsSuperseded++;
+   }
+   busStats.commandsPosted++;
+   pendingCmd     = cmd;
+   pendingVoltage = voltage;
+   serviceBartels();
+ }
+
+ // Starts the OEM two-pass full configuration; the first pass goes out now
+ static void beginConfiguration(float voltage, unsigned long now) {
+   configVoltage    = voltage;
+   configPassesLeft = 2;
+   settleUntilMs    = now;
+   serviceBartels();
+ }
+
+ // After the last pass of a stop: registers still dirty mean the driver did
+ // not take it, so count it and back off before the next attempt
+ static void finishStop(unsigned long now) {
+   if (dirtyPage0 == 0 && dirtyPage1 == 0) {
+     if (stopRetryMs != 0) LOG_INFO(LOG_CAT_BARTELS, "pump stop acknowledged again");
+     stopRetryMs = 0;
+     return;
+   }
+
+   busStats.stopsFailed++;
+   if (stopRetryMs == 0) {
+     LOG_WARN(LOG_CAT_BARTELS, "pump driver did not acknowledge the stop, retrying");
+     stopRetryMs = BARTELS_STOP_RETRY_MIN_MS;
+   } else if (stopRetryMs < BARTELS_STOP_RETRY_MAX_MS) {
+     stopRetryMs *= 2;
+     if (stopRetryMs > BARTELS_STOP_RETRY_MAX_MS) stopRetryMs = BARTELS_STOP_RETRY_MAX_MS;
+   }
+   stopRetryAtMs = now + stopRetryMs;
+ }
+
+ /*
+  * Function: getBartelsBusStats / resetBartelsBusStats
+  * Brief: Bus accounting for verifying the cost of each pump update.
+  */
+ const BartelsBusStats &getBartelsBusStats() {
+   return busStats;
+ }
+
+ void resetBartelsBusStats() {
+   busStats = {};
+ }
+
+ /*
+  * Function: loadDefaultRegisters
+  * Brief: Loads the complete OEM register image (10-byte waveform on page 1,
+  *        BARTELS_CONTROL_DATA on page 0) into the shadow copy.
+  */
+ static void loadDefaultRegisters(float voltage, uint8_t freqByte) {
+   const uint8_t waveformData[BARTELS_PAGE1_SIZE] = {
      0x05, 0x80, 0x06, 0x00, 0x09, 0x00,
-     amplitude_value,
+     computeAmplitudeByte(voltage),
      freqByte,
      0x64,  // cycle count
      0x00
    };
- 
-   Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-   Wire.write(BARTELS_PAGE_REGISTER);
-   Wire.write(1);
-   Wire.endTransmission();
- 
-   for (uint8_t i = 0; i < 10; i++) {
-     Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-     Wire.write(i);
-     Wire.write(waveformData[i]);
-     Wire.endTransmission();
+
+   for (uint8_t i = 0; i < BARTELS_PAGE1_SIZE; i++) {
+     shadowWrite(1, i, waveformData[i]);
+   }
+   for (uint8_t i = 0; i < BARTELS_PAGE0_SIZE; i++) {
+     shadowWrite(0, i, BARTELS_CONTROL_DATA[i]);
    }
- 
-   delay(default_delay);
  }
- 
+
  /*
-  * Function: writeAmplitudeOnly
-  * Brief: Writes *only* the amplitude register to page=1.
+  * Function: shadowWrite
+  * Brief: Stores a register value in the shadow copy; marks it dirty only
+  *        if it differs from what the driver already holds.
   */
- static void writeAmplitudeOnly(float voltage) {
-   float ratio = voltage / BARTELS_ABSOLUTE_MAX;
-   if (ratio < 0.0f) ratio = 0.0f;
-   if (ratio > 1.0f) ratio = 1.0f;
- 
-   uint8_t amplitude_value = (uint8_t)(ratio * 255.0f);
- 
-   Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-   Wire.write(BARTELS_PAGE_REGISTER);
-   Wire.write(1);
-   Wire.endTransmission();
- 
-   Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-   Wire.write(6);  // Amplitude register index
-   Wire.write(amplitude_value);
-   Wire.endTransmission();
- 
-   delay(default_delay);
+ static void shadowWrite(uint8_t page, uint8_t reg, uint8_t value) {
+   uint8_t *regs = (page == 0) ? shadowPage0 : shadowPage1;
+   uint16_t &dirty = (page == 0) ? dirtyPage0 : dirtyPage1;
+
+   if (regs[reg] != value) {
+     regs[reg] = value;
+     dirty |= (uint16_t)(1u << reg);
+   }
+ }
+
+ // Forces every register to be rewritten on the next flush
+ static void markAllDirty() {
+   dirtyPage0 = (uint16_t)((1u << BARTELS_PAGE0_SIZE) - 1u);
+   dirtyPage1 = (uint16_t)((1u << BARTELS_PAGE1_SIZE) - 1u);
+ }
+
+ /*
+  * Function: flushShadow
+  * Brief: Sends all dirty registers, waveform page first. Full configurations
+  *        park the driver on page 0 as the OEM sequence does; amplitude-only
+  *        updates stay on page 1 (the page register is reachable from either
+  *        page), so a steady-state update is a single 3-byte transaction.
+  * Returns: True if anything was written.
+  */
+ static bool flushShadow(bool parkOnPage0) {
+   if (dirtyPage0 == 0 && dirtyPage1 == 0) {
+     busStats.lastUpdateTransactions = 0;
+     busStats.lastUpdateBytes        = 0;
+     return false;
+   }
+
+   uint32_t txBefore    = busStats.transactions;
+   uint32_t bytesBefore = busStats.bytesOnBus;
+
+   flushPage(1);
+   flushPage(0);
+   if (parkOnPage0) selectPage(0);
+
+   busStats.updates++;
+   busStats.lastUpdateTransactions = (uint16_t)(busStats.transactions - txBefore);
+   busStats.lastUpdateBytes        = (uint16_t)(busStats.bytesOnBus   - bytesBefore);
+   return true;
  }
- 
+
  /*
-  * Function: writeControlData
-  * Brief: Writes control data from BARTELS_CONTROL_DATA[] to page=0.
+  * Function: flushPage
+  * Brief: Writes the dirty registers of one page as auto-increment bursts.
   */
- static void writeControlData() {
+ static void flushPage(uint8_t page) {
+   const uint8_t *regs  = (page == 0) ? shadowPage0 : shadowPage1;
+   uint16_t      &dirty = (page == 0) ? dirtyPage0  : dirtyPage1;
+   uint8_t        size  = (page == 0) ? BARTELS_PAGE0_SIZE : BARTELS_PAGE1_SIZE;
+
+   if (dirty == 0) return;
+   selectPage(page);
+
+   uint16_t failed = 0;   // bursts that NACKed stay dirty for the next flush
+   uint8_t  reg    = 0;
+   while (reg < size) {
+     if (!(dirty & (1u << reg))) { reg++; continue; }
+
+     // Extend the burst over dirty registers and short clean gaps
+     uint8_t first = reg;
+     uint8_t last  = reg;
+     for (uint8_t r = reg + 1; r < size && r <= last + BARTELS_MERGE_GAP + 1; r++) {
+       if (dirty & (1u << r)) last = r;
+     }
+
+     i2cBusAcquire(I2C_DEV_PUMP);
+     Wire.beginTransmission(BARTELS_DRIVER_ADDR);
+     Wire.write(first);
+     for (uint8_t r = first; r <= last; r++) {
+       Wire.write(regs[r]);
+     }
+     if (!endTransaction((uint8_t)(1 + last - first + 1))) {
+       failed |= (uint16_t)(dirty & (((1u << (last + 1)) - 1u) & ~((1u << first) - 1u)));
+     }
+
+     reg = last + 1;
+   }
+   dirty = failed;
+ }
+
+ // Selects the register page unless the driver is already on it
+ static void selectPage(uint8_t page) {
+   if (currentPage == page) return;
+
+   i2cBusAcquire(I2C_DEV_PUMP);
    Wire.beginTransmission(BARTELS_DRIVER_ADDR);
    Wire.write(BARTELS_PAGE_REGISTER);
-   Wire.write(0);
-   Wire.endTransmission();
- 
-   for (uint8_t i = 0; i < 4; i++) {
-     Wire.beginTransmission(BARTELS_DRIVER_ADDR);
-     Wire.write(i);
-     Wire.write(BARTELS_CONTROL_DATA[i]);
-     Wire.endTransmission();
+   Wire.write(page);
+   endTransaction(2);
+
+   currentPage = page;
+ }
+
+ /*
+  * Function: endTransaction
+  * Brief: Closes a write transaction, releases the bus and counts it. Bytes
+  *        on bus include the address byte. A failed write leaves the page
+  *        unknown so the next flush re-selects it.
+  * Returns: True if the driver acknowledged the write.
+  */
+ static bool endTransaction(uint8_t payloadBytes) {
+   uint8_t err = Wire.endTransmission();
+   i2cBusRelease(I2C_DEV_PUMP, payloadBytes);
+   busStats.transactions++;
+   busStats.bytesOnBus += 1u + payloadBytes;
+   if (err != 0) {
+     busStats.errors++;
+     currentPage = BARTELS_PAGE_UNKNOWN;
+     LOG_DEBUG(LOG_CAT_BARTELS, "driver write failed (Wire error %u), page reselect", err);
+     return false;
    }
- 
-   delay(default_delay);
+   return true;
  }
- 
\ No newline at end of file
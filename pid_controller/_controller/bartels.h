@@ -6,11 +6,39 @@
  * Brief: Declares functions to control a Bartels micropump driver via I2C.
  */
 
+// Bus accounting for the pump driver (bytes include the I2C address byte)
+struct BartelsBusStats {
+  uint32_t updates;                 // flushes that wrote at least one register
+  uint32_t transactions;            // total I2C write transactions
+  uint32_t bytesOnBus;              // total bytes clocked out
+  uint32_t errors;                  // transactions the driver did not ACK
+  uint16_t lastUpdateTransactions;  // transactions used by the most recent update
+  uint16_t lastUpdateBytes;         // bytes used by the most recent update
+  uint32_t commandsPosted;          // runSequence()/stopPump() requests
+  uint32_t commandsSuperseded;      // requests replaced before being applied
+  uint32_t stopsFailed;             // stops the driver did not acknowledge (retried with back-off)
+};
+
 // Initializes the driver state
 bool initBartels();
 
-// Writes amplitude and control data to the micropump
+// Posts a new pump voltage (non-blocking; newest command wins)
 void runSequence(float voltage);
 
-// Sets pump amplitude to zero (stop)
+// Posts a pump stop (amplitude zero; non-blocking)
 void stopPump();
+
+// Applies the pending command once the driver has settled; call every loop
+void serviceBartels();
+
+// True when nothing is pending and the driver has settled
+bool isBartelsIdle();
+
+// Blocks until the pipeline is drained (shutdown paths only)
+void flushBartels();
+
+// Returns the running bus counters
+const BartelsBusStats &getBartelsBusStats();
+
+// Clears the bus counters
+void resetBartelsBusStats();
@@ -0,0 +1,253 @@
+/*
+ * File: bench.cpp
+ * Brief: Hot-path micro-benchmarks (see bench.h).
+ */
+
+ #include "bench.h"
+ #include "config.h"
+ #include "crc.h"
+ #include "display.h"
+ #include "exp_control.h"
+ #include "filter.h"
+ #include "flow.h"
+ #include "gain_lut.h"
+ #include "pid.h"
+ #include "profiler.h"
+ #include "report.h"
+ #include "telemetry.h"
+ #include "tx_buffer.h"
+ #include <math.h>
+
+ #if !defined(ARDUINO_ARCH_ESP32)
+ #include <chrono>
+ #endif
+
+ /*──────────────────────── CYCLE COUNTER ──────────────────────────────────*/
+ // The counter itself is profCycles() (profiler.h)
+ uint32_t benchCycles() { return profCycles(); }
+
+ #if defined(ARDUINO_ARCH_ESP32)
+
+ float       benchCyclesPerUs() { return (float)getCpuFrequencyMhz(); }
+ const char *benchClockName()   { return "ccount"; }
+
+ #elif defined(__x86_64__) || defined(__i386__)
+
+ const char *benchClockName()   { return "tsc"; }
+
+ // TSC rate against the steady clock over ~20 ms, measured once
+ float benchCyclesPerUs()
+ {
+     static float rate = 0.0f;
+     if (rate == 0.0f) {
+         auto t0 = std::chrono::steady_clock::now();
+         uint64_t c0 = __rdtsc();
+         while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20)) {}
+         uint64_t c1 = __rdtsc();
+         double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+         rate = (float)((c1 - c0) / us);
+     }
+     return rate;
+ }
+
+ #else
+
+ float       benchCyclesPerUs() { return 1000.0f; }
+ const char *benchClockName()   { return "ns"; }
+
+ #endif
+
+ /*──────────────────────── HARNESS ────────────────────────────────────────*/
+ typedef void (*BenchBody)(uint16_t i);
+
+ static MODULE_STATE float          s_errors[BENCH_BATCH];   // inputs spread over ±0.6 mL/min
+ static MODULE_STATE volatile float s_sink;                  // keeps results alive
+
+ static MODULE_STATE TwoPoleFilter   s_twoPole;
+ static MODULE_STATE DynamicLPFilter s_dynamic;
+ static MODULE_STATE SimpleEMA       s_ema;
+ static MODULE_STATE uint8_t         s_frame[9];     // SLF3S frame: 3 × (word, CRC)
+ static MODULE_STATE SystemState     s_sample;
+
+ // Print that discards everything, so only the formatting is timed
+ class NullPrint : public Print {
+ public:
+     using Print::write;
+     size_t write(uint8_t) override                    { return 1; }
+     size_t write(const uint8_t *, size_t n) override  { return n; }
+ };
+ static MODULE_STATE NullPrint s_null;
+ static MODULE_STATE TxBuffer<TX_CONTROL_BUFFER_SIZE> s_tx;
+
+ static void emptyBody(uint16_t) {}
+
+ static void sortCycles(uint32_t *v, uint8_t n)
+ {
+     for (uint8_t i = 1; i < n; i++) {
+         uint32_t x = v[i];
+         uint8_t  j = i;
+         while (j > 0 && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+         v[j] = x;
+     }
+ }
+
+ // Sorted cycle counts of BENCH_SAMPLES batches of `batch` calls
+ static void sampleBatches(BenchBody body, uint16_t batch, uint32_t *out)
+ {
+     for (uint8_t s = 0; s < BENCH_SAMPLES; s++) {
+         uint32_t t0 = benchCycles();
+         for (uint16_t i = 0; i < batch; i++) body(i % BENCH_BATCH);
+         out[s] = benchCycles() - t0;
+     }
+     sortCycles(out, BENCH_SAMPLES);
+ }
+
+ static void measure(BenchReport &r, const char *name, BenchBody body, uint16_t batch)
+ {
+     if (r.count >= BENCH_MAX_RESULTS) return;
+
+     uint32_t empty[BENCH_SAMPLES], cycles[BENCH_SAMPLES];
+     sampleBatches(emptyBody, batch, empty);
+     sampleBatches(body, batch, cycles);
+
+     float overhead = (float)empty[0];
+     float lo  = (float)cycles[0] - overhead;
+     float mid = (float)cycles[BENCH_SAMPLES / 2] - overhead;
+
+     BenchResult &res = r.results[r.count++];
+     res.name         = name;
+     res.minCycles    = (lo  > 0.0f ? lo  : 0.0f) / batch;
+     res.medianCycles = (mid > 0.0f ? mid : 0.0f) / batch;
+     res.batch        = batch;
+ }
+
+ static void prepareInputs()
+ {
+     for (uint16_t i = 0; i < BENCH_BATCH; i++)
+         s_errors[i] = 0.6f * sinf(0.7f * i) * (i % 3 ? 1.0f : 0.05f);
+
+     // A valid frame: 0.5 mL/min, 25 °C, no flags
+     int16_t words[3] = { (int16_t)(0.5f * SLF_SCALE_FACTOR_FLOW),
+                          (int16_t)(25.0f * SLF_SCALE_FACTOR_TEMP), 0 };
+     for (uint8_t w = 0; w < 3; w++) {
+         s_frame[3 * w]     = (uint8_t)((uint16_t)words[w] >> 8);
+         s_frame[3 * w + 1] = (uint8_t)words[w];
+         s_frame[3 * w + 2] = crc8Sensirion(&s_frame[3 * w], 2);
+     }
+ }
+
+ /*──────────────────────── CASES ──────────────────────────────────────────*/
+ static void runTwoPole(uint16_t i) { s_sink = updateTwoPoleFilter(s_twoPole, s_errors[i]); }
+ static void runDynamic(uint16_t i) { s_sink = updateDynamicLPFilter(s_dynamic, s_errors[i]); }
+ static void runEma(uint16_t i)     { s_sink = updateEMA(s_ema, s_errors[i]); }
+
+ static void runPid(uint16_t i)
+ {
+     float p, in, d;
+     s_sink = updatePIDNormal(s_errors[i], p, in, d);
+ }
+
+ static void runExpCurve(uint16_t i)
+ {
+     s_sink = expCurveLut(fabsf(s_errors[i]), EXP_KI_A, EXP_KI_K, EXP_KI_B, EXP_KI_C);
+ }
+
+ static void runSlfDecode(uint16_t)
+ {
+     SlfFrame f;
+     decodeSlfFrame(s_frame, f);
+     s_sink = f.rawFlow;
+ }
+
+ // A control-task debug line into its TxBuffer (drained so it never fills)
+ static void runTxLine(uint16_t)
+ {
+     s_tx.println("[MAIN DEBUG] Returned from updateExpController()");
+     size_t room = TX_CONTROL_BUFFER_SIZE;
+     s_tx.drain(s_null, room);
+ }
+
+ static void runReport(uint16_t)       { reportAllStateJSON(s_sample, s_null); }
+ static void runReportBinary(uint16_t) { reportAllStateBinary(s_sample, s_null); }
+
+ // A production subscription: flow and setpoint only
+ static void runReportFlow(uint16_t)
+ {
+     reportStateJSON(s_sample, (1u << TLM_FIELD_FLOW) | (1u << TLM_FIELD_SETPT), s_null);
+ }
+
+ // Post and redraw; every other call changes the last digit of each
+ // value, as a running system does. The I2C push is left to serviceDisplay().
+ static void runDisplay(uint16_t i)
+ {
+     float d = (i & 1) ? 0.001f : 0.0f;
+     showStatus(s_sample.flow + d, s_sample.setpoint, s_sample.errorPercent + 100.0f * d,
+                s_sample.desiredVoltage + 100.0f * d, s_sample.systemOn,
+                s_sample.temperature + 100.0f * d, s_sample.bubbleDetected);
+     renderDisplay();
+ }
+
+ /*──────────────────────── PUBLIC ─────────────────────────────────────────*/
+ void initBenchReport(BenchReport &r)
+ {
+     r.count = 0;
+ }
+
+ void benchControlPath(BenchReport &r)
+ {
+     prepareInputs();
+     initTwoPoleFilter(s_twoPole);
+     initDynamicLPFilter(s_dynamic);
+     resetEMA(s_ema);
+
+     float kp, ki, kd;
+     computeExpGains(0.1f, kp, ki, kd);
+     initPID();
+     setPIDGains(kp, ki, kd);
+
+     measure(r, "updateTwoPoleFilter",   runTwoPole,   BENCH_BATCH);
+     measure(r, "updateDynamicLPFilter", runDynamic,   BENCH_BATCH);
+     measure(r, "updateEMA",             runEma,       BENCH_BATCH);
+     measure(r, "updatePIDNormal",       runPid,       BENCH_BATCH);
+     measure(r, "expCurveLut",           runExpCurve,  BENCH_BATCH);
+     measure(r, "decodeSlfFrame",        runSlfDecode, BENCH_BATCH);
+     measure(r, "TxBuffer println",      runTxLine,    BENCH_BATCH);
+ }
+
+ void benchIoPath(BenchReport &r, const SystemState &sample)
+ {
+     s_sample = sample;
+     measure(r, "reportAllStateJSON",   runReport,       BENCH_BATCH);
+     measure(r, "reportAllStateBinary", runReportBinary, BENCH_BATCH);
+     measure(r, "reportStateJSON(flow)", runReportFlow,   BENCH_BATCH);
+     measure(r, "showStatus+render",    runDisplay,      BENCH_BATCH);
+ }
+
+ void printBenchJSON(Print &out, const BenchReport &r)
+ {
+     float perUs = benchCyclesPerUs();
+
+     out.print("{\"bench\":{\"clock\":\"");
+     out.print(benchClockName());
+     out.print("\",\"cyclesPerUs\":");
+     out.print(perUs, 1);
+     out.print(",\"samples\":");
+     out.print(BENCH_SAMPLES);
+     out.print(",\"results\":[");
+     for (uint8_t i = 0; i < r.count; i++) {
+         const BenchResult &res = r.results[i];
+         if (i) out.print(",");
+         out.print("{\"name\":\"");
+         out.print(res.name);
+         out.print("\",\"min\":");
+         out.print(res.minCycles, 1);
+         out.print(",\"median\":");
+         out.print(res.medianCycles, 1);
+         out.print(",\"ns\":");
+         out.print(perUs > 0.0f ? 1000.0f * res.medianCycles / perUs : 0.0f, 1);
+         out.print(",\"batch\":");
+         out.print(res.batch);
+         out.print("}");
+     }
+     out.println("]}}");
+ }
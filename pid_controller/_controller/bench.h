@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include "system_state.h"
+
+/*
+ * File: bench.h
+ * Brief: Micro-benchmarks of the per-cycle hot path, shared by the target
+ *        (serial command 'B') and the host build (controller_bench).
+ *
+ *   Each case runs BENCH_BATCH calls between two cycle-counter reads,
+ *   BENCH_SAMPLES times; the minimum and the median per call are kept,
+ *   minus the cost of an empty batch. The counter is the CPU cycle
+ *   counter on the ESP32 and the TSC on x86 hosts (ns elsewhere).
+ *
+ *   The control-path cases use the PID's module state, so on the target
+ *   they run in the control task with the system off; the I/O cases
+ *   (report, display) run in the I/O task that owns those devices.
+ */
+
+static const uint8_t  BENCH_MAX_RESULTS = 12;
+static const uint16_t BENCH_BATCH       = 32;
+static const uint8_t  BENCH_SAMPLES     = 31;
+
+typedef struct {
+    const char *name;
+    float       minCycles;      // per call
+    float       medianCycles;   // per call
+    uint16_t    batch;          // calls per timed batch
+} BenchResult;
+
+typedef struct {
+    BenchResult results[BENCH_MAX_RESULTS];
+    uint8_t     count;
+} BenchReport;
+
+// Clears the report
+void  initBenchReport(BenchReport &r);
+
+// Filters, EMA, PID, gain curve, SLF3S frame decode (control core)
+void  benchControlPath(BenchReport &r);
+
+// JSON and binary telemetry into a null sink, showStatus() (I/O core)
+void  benchIoPath(BenchReport &r, const SystemState &sample);
+
+// {"bench":{"clock":..,"cyclesPerUs":..,"samples":..,"results":[{"name":..,"min":..,"median":..,"ns":..,"batch":..}]}}
+void  printBenchJSON(Print &out, const BenchReport &r);
+
+// Raw counter and its rate
+uint32_t    benchCycles();
+float       benchCyclesPerUs();
+const char *benchClockName();
@@ -1,12 +1,30 @@
 /*
  * File: buttons.cpp
- * Brief: Manages button input for system control and stores relevant data in EEPROM.
+ * Brief: Manages button input for system control; setpoint and error % are
+ *        kept across power cycles by settings.cpp.
+ *
+ * A timer samples the six pins every BUTTON_SAMPLE_US (esp_timer task, off
+ * the control core) and debounces them: a new level must hold for
+ * BUTTON_DEBOUNCE_SAMPLES samples. Presses, releases, auto-repeats and the
+ * MODE long press go into a lock-free event queue, which updateButtons()
+ * drains on the I/O task, so a press is never lost between two calls.
+ *
+ * The queue never overwrites: a full queue refuses the event. A refused
+ * press, release or long press is retried on the next sample (the
+ * debounced level only changes once its event is queued), and repeats
+ * may only take part of the queue, so a stalled I/O task costs repeat
+ * steps, not presses. Both kinds of overflow are counted and logged.
  */
 
  #include "buttons.h"
  #include "config.h"
  #include <Arduino.h>
- #include <EEPROM.h>
+ #include <atomic>
+ #include "log.h"
+ #include "settings.h"
+ #if defined(ARDUINO_ARCH_ESP32)
+ #include <esp_timer.h>
+ #endif
  
  // Pin assignments
  static const int PIN_ONOFF       = D6;
@@ -15,161 +33,323 @@
  static const int PIN_ERROR_UP    = D8;
  static const int PIN_ERROR_DOWN  = D7;
  static const int PIN_MODE_TOGGLE = D10;
- 
- // Previous states for edge detection
- static int oldState_onoff       = HIGH;
- static int oldState_flowUp      = HIGH;
- static int oldState_flowDown    = HIGH;
- static int oldState_errorUp     = HIGH;
- static int oldState_errorDown   = HIGH;
- static int oldState_modeToggle  = HIGH;
- 
- // System variables
- static bool  systemOn          = false;
- static float flowSetpointValue = 0.0f;
- static float errorPercentValue = 0.0f;
- static bool  modeTogglePressed = false;  // Set true if mode button pressed
- 
- // EEPROM addresses
- static const int EEPROM_SIZE          = 512;
- static const int EEPROM_ADDR_ERROR    = 0;
- static const int EEPROM_ADDR_SETPOINT = 4;
- 
- /*
-  * Function: checkFallingEdge
-  * Brief: Returns true if the given pin transitions from HIGH to LOW.
-  */
- static bool checkFallingEdge(int pin, int &oldState) {
-   int newState = digitalRead(pin);
-   bool triggered = (newState == LOW && oldState == HIGH);
-   oldState = newState;
-   return triggered;
+
+ enum {
+   BTN_ONOFF = 0,
+   BTN_FLOW_UP,
+   BTN_FLOW_DOWN,
+   BTN_ERROR_UP,
+   BTN_ERROR_DOWN,
+   BTN_MODE,
+   BTN_COUNT
+ };
+ static const int BUTTON_PINS[BTN_COUNT] = {
+   PIN_ONOFF, PIN_FLOW_UP, PIN_FLOW_DOWN, PIN_ERROR_UP, PIN_ERROR_DOWN, PIN_MODE_TOGGLE
+ };
+
+ // Buttons that repeat while held (the value steps)
+ static const uint8_t REPEAT_BUTTONS =
+   (1 << BTN_FLOW_UP) | (1 << BTN_FLOW_DOWN) | (1 << BTN_ERROR_UP) | (1 << BTN_ERROR_DOWN);
+
+ // Queue entries: event kind in the high nibble, button in the low nibble
+ enum {
+   BTN_EVENT_PRESS   = 0x00,
+   BTN_EVENT_RELEASE = 0x10,
+   BTN_EVENT_REPEAT  = 0x20,   // value button still held
+   BTN_EVENT_LONG    = 0x30    // MODE held for BUTTON_LONG_PRESS_MS
+ };
+
+ // Debounce state of one button (sampler side only)
+ typedef struct {
+   bool     pressed;      // debounced level is LOW
+   uint8_t  count;        // consecutive samples disagreeing with it
+   bool     timed;        // a repeat / long press is pending
+   uint32_t dueMs;        // when it fires
+   uint16_t intervalMs;   // current repeat interval
+   bool     waiting;      // an event was refused and is being retried
+ } ButtonSampler;
+ static MODULE_STATE ButtonSampler samplers[BTN_COUNT];
+
+ // Sampler -> updateButtons() (one producer, one reader): the sampler
+ // fills a slot and then publishes it by advancing eventHead; the reader
+ // frees slots by advancing eventTail. Both are free-running counters.
+ static MODULE_STATE uint8_t               eventQueue[BUTTON_EVENT_QUEUE];
+ static MODULE_STATE std::atomic<uint32_t> eventHead{0};
+ static MODULE_STATE std::atomic<uint32_t> eventTail{0};
+
+ // Overflow counters (sampler side), and the totals already logged
+ static MODULE_STATE std::atomic<uint32_t> droppedRepeats{0};   // repeats refused
+ static MODULE_STATE std::atomic<uint32_t> deferredEvents{0};   // other events refused, retried
+ static MODULE_STATE uint32_t loggedDropped  = 0;
+ static MODULE_STATE uint32_t loggedDeferred = 0;
+
+ #if defined(ARDUINO_ARCH_ESP32)
+ static esp_timer_handle_t s_sampleTimer = nullptr;
+ #endif
+
+ // System variables (written by updateButtons() on the I/O core, read
+ // lock-free by the control core through the accessors below)
+ static MODULE_STATE std::atomic<bool>  systemOn{false};
+ static MODULE_STATE std::atomic<float> flowSetpointValue{0.0f};
+ static MODULE_STATE std::atomic<float> errorPercentValue{0.0f};
+ static MODULE_STATE bool  modeTogglePressed = false;  // Set true if mode button pressed
+ static MODULE_STATE bool  pageTogglePressed = false;  // Set true if mode button held long
+
+ // Consumer-side view of the held buttons
+ static MODULE_STATE uint8_t heldButtons   = 0;       // pressed since their PRESS event
+ static MODULE_STATE bool    modeLongFired = false;
+
+ // Queues an event unless that would fill more than `limit` entries
+ static bool pushEvent(uint8_t kind, uint8_t button, uint32_t limit) {
+   uint32_t head = eventHead.load(std::memory_order_relaxed);
+   if (head - eventTail.load(std::memory_order_acquire) >= limit) return false;
+   eventQueue[head % BUTTON_EVENT_QUEUE] = (uint8_t)(kind | button);
+   eventHead.store(head + 1, std::memory_order_release);
+   return true;
  }
- 
- /*
-  * Function: loadFromEEPROM
-  * Brief: Loads stored error and setpoint values if they are valid.
-  */
- static void loadFromEEPROM() {
-   float storedError    = 0.0f;
-   float storedSetpoint = 0.0f;
- 
-   EEPROM.get(EEPROM_ADDR_ERROR,    storedError);
-   EEPROM.get(EEPROM_ADDR_SETPOINT, storedSetpoint);
- 
-   if (storedError < -50.0f || storedError > 50.0f) {
-     storedError = 0.0f;
+
+ // Press, release and long press: may use the whole queue; the caller
+ // retries a refused one on the next sample (counted once)
+ static bool pushEdge(uint8_t kind, uint8_t button, ButtonSampler &s) {
+   if (pushEvent(kind, button, BUTTON_EVENT_QUEUE)) {
+     s.waiting = false;
+     return true;
+   }
+   if (!s.waiting) deferredEvents.fetch_add(1, std::memory_order_relaxed);
+   s.waiting = true;
+   return false;
+ }
+
+ // Arms the repeat (value buttons) or long-press (MODE) timer of a new press
+ static void startHold(uint8_t button, ButtonSampler &s, uint32_t nowMs) {
+   if (REPEAT_BUTTONS & (1 << button)) {
+     s.timed      = true;
+     s.dueMs      = nowMs + BUTTON_REPEAT_DELAY_MS;
+     s.intervalMs = BUTTON_REPEAT_START_MS;
+   } else if (button == BTN_MODE) {
+     s.timed = true;
+     s.dueMs = nowMs + BUTTON_LONG_PRESS_MS;
+   } else {
+     s.timed = false;
+   }
+ }
+
+ // A held button's timer ran out: one more repeat (each sooner than the
+ // last), or MODE's long press
+ static void holdDue(uint8_t button, ButtonSampler &s) {
+   if (button == BTN_MODE) {
+     if (pushEdge(BTN_EVENT_LONG, button, s)) s.timed = false;
+     return;
    }
-   if (storedSetpoint < FLOW_SP_MIN || storedSetpoint > FLOW_SP_MAX) {
-     storedSetpoint = (FLOW_SP_MIN + FLOW_SP_MAX) * 0.5f;
+   // A repeat that does not fit is dropped; the schedule goes on
+   if (!pushEvent(BTN_EVENT_REPEAT, button, BUTTON_REPEAT_QUEUE_MAX)) {
+     droppedRepeats.fetch_add(1, std::memory_order_relaxed);
    }
- 
-   errorPercentValue = storedError;
-   flowSetpointValue = storedSetpoint;
+   s.dueMs += s.intervalMs;
+   uint16_t next = (uint16_t)((uint32_t)s.intervalMs * BUTTON_REPEAT_ACCEL_PCT / 100);
+   s.intervalMs  = next > BUTTON_REPEAT_MIN_MS ? next : BUTTON_REPEAT_MIN_MS;
  }
- 
+
  /*
-  * Function: saveToEEPROM
-  * Brief: Saves the current error and setpoint values to EEPROM.
+  * Function: sampleButtons
+  * Brief: One debounce step for all buttons; queues the press, release,
+  *        repeat and long-press events.
   */
- static void saveToEEPROM() {
-   EEPROM.put(EEPROM_ADDR_ERROR,    errorPercentValue);
-   EEPROM.put(EEPROM_ADDR_SETPOINT, flowSetpointValue);
-   EEPROM.commit();
+ void sampleButtons() {
+   uint32_t nowMs = millis();
+   for (uint8_t b = 0; b < BTN_COUNT; b++) {
+     ButtonSampler &s = samplers[b];
+     bool low = (digitalRead(BUTTON_PINS[b]) == LOW);
+
+     if (low == s.pressed) {
+       s.count = 0;
+       if (s.timed && (int32_t)(nowMs - s.dueMs) >= 0) holdDue(b, s);
+       continue;
+     }
+     if (++s.count < BUTTON_DEBOUNCE_SAMPLES) continue;
+
+     // Queue full: keep the old level and try again on the next sample
+     if (!pushEdge(low ? BTN_EVENT_PRESS : BTN_EVENT_RELEASE, b, s)) {
+       s.count = BUTTON_DEBOUNCE_SAMPLES - 1;
+       continue;
+     }
+     s.count   = 0;
+     s.pressed = low;
+     if (low) {
+       startHold(b, s, nowMs);
+     } else {
+       s.timed = false;
+     }
+   }
  }
- 
+
+ #if defined(ARDUINO_ARCH_ESP32)
+ static void onSampleTimer(void *) {
+   sampleButtons();
+ }
+ #endif
+
  /*
   * Function: initButtons
-  * Brief: Initializes button inputs and loads stored values from EEPROM.
-  * Note: EEPROM.begin(...) must be called before this function.
+  * Brief: Initializes button inputs, takes the stored setpoint and error %
+  *        and starts the sampling timer (host builds call sampleButtons()
+  *        themselves).
+  * Note: initSettings() must be called before this function.
   */
  void initButtons() {
-   pinMode(PIN_ONOFF,       INPUT_PULLUP);
-   pinMode(PIN_FLOW_UP,     INPUT_PULLUP);
-   pinMode(PIN_FLOW_DOWN,   INPUT_PULLUP);
-   pinMode(PIN_ERROR_UP,    INPUT_PULLUP);
-   pinMode(PIN_ERROR_DOWN,  INPUT_PULLUP);
-   pinMode(PIN_MODE_TOGGLE, INPUT_PULLUP);
- 
-   loadFromEEPROM();
- 
-   oldState_onoff      = digitalRead(PIN_ONOFF);
-   oldState_flowUp     = digitalRead(PIN_FLOW_UP);
-   oldState_flowDown   = digitalRead(PIN_FLOW_DOWN);
-   oldState_errorUp    = digitalRead(PIN_ERROR_UP);
-   oldState_errorDown  = digitalRead(PIN_ERROR_DOWN);
-   oldState_modeToggle = digitalRead(PIN_MODE_TOGGLE);
- }
- 
- /*
-  * Function: updateButtons
-  * Brief: Reads button inputs each loop to update systemOn, setpoint, error%, 
-  *        and mode toggle state. Saves changes to EEPROM if values changed.
-  */
- void updateButtons() {
-   bool changed = false;
-   modeTogglePressed = false; // Reset each iteration
- 
-   // On/Off toggle
-   if (checkFallingEdge(PIN_ONOFF, oldState_onoff)) {
-     systemOn = !systemOn;
+   for (uint8_t b = 0; b < BTN_COUNT; b++) pinMode(BUTTON_PINS[b], INPUT_PULLUP);
+
+   const Settings &stored = currentSettings();
+   errorPercentValue.store(stored.errorPercent);
+   flowSetpointValue.store(stored.setpoint);
+
+   // Buttons already held count as pressed without a PRESS event, so
+   // neither they nor their release do anything
+   for (uint8_t b = 0; b < BTN_COUNT; b++) {
+     samplers[b] = {};
+     samplers[b].pressed = (digitalRead(BUTTON_PINS[b]) == LOW);
    }
- 
-   // Flow Up
-   if (checkFallingEdge(PIN_FLOW_UP, oldState_flowUp)) {
-     flowSetpointValue += FLOW_STEP_SIZE;
-     if (flowSetpointValue > FLOW_SP_MAX) {
-       flowSetpointValue = FLOW_SP_MAX;
+   eventHead.store(0, std::memory_order_relaxed);
+   eventTail.store(0, std::memory_order_relaxed);
+   droppedRepeats.store(0, std::memory_order_relaxed);
+   deferredEvents.store(0, std::memory_order_relaxed);
+   loggedDropped  = 0;
+   loggedDeferred = 0;
+   heldButtons   = 0;
+   modeLongFired = false;
+
+ #if defined(ARDUINO_ARCH_ESP32)
+   if (!s_sampleTimer) {
+     esp_timer_create_args_t args = {};
+     args.callback        = &onSampleTimer;
+     args.dispatch_method = ESP_TIMER_TASK;
+     args.name            = "buttons";
+     if (esp_timer_create(&args, &s_sampleTimer) == ESP_OK) {
+       esp_timer_start_periodic(s_sampleTimer, BUTTON_SAMPLE_US);
      }
-     changed = true;
    }
- 
-   // Flow Down
-   if (checkFallingEdge(PIN_FLOW_DOWN, oldState_flowDown)) {
-     flowSetpointValue -= FLOW_STEP_SIZE;
-     if (flowSetpointValue < FLOW_SP_MIN) {
-       flowSetpointValue = FLOW_SP_MIN;
+ #endif
+ }
+
+ // Applies one queued event
+ static void applyEvent(uint8_t event, float &setpoint, float &errorPct, bool &changed) {
+   uint8_t kind    = event & 0xF0;
+   uint8_t button  = event & 0x0F;
+
+   uint8_t bit    = (uint8_t)(1 << button);
+   bool    wasHeld = (heldButtons & bit) != 0;   // false for a button held since boot
+
+   if (kind == BTN_EVENT_PRESS)   heldButtons |= bit;
+   if (kind == BTN_EVENT_RELEASE) heldButtons &= (uint8_t)~bit;
+   bool step = (kind == BTN_EVENT_PRESS || kind == BTN_EVENT_REPEAT);
+
+   switch (button) {
+   case BTN_ONOFF:
+     if (kind == BTN_EVENT_PRESS) systemOn.store(!systemOn.load());
+     break;
+
+   case BTN_FLOW_UP:
+     if (!step) break;
+     setpoint += FLOW_STEP_SIZE;
+     if (setpoint > FLOW_SP_MAX) {
+       setpoint = FLOW_SP_MAX;
      }
      changed = true;
-   }
- 
-   // Error% Up
-   if (checkFallingEdge(PIN_ERROR_UP, oldState_errorUp)) {
-     errorPercentValue += 1.0f;
-     if (errorPercentValue > 50.0f) {
-       errorPercentValue = 50.0f;
+     break;
+
+   case BTN_FLOW_DOWN:
+     if (!step) break;
+     setpoint -= FLOW_STEP_SIZE;
+     if (setpoint < FLOW_SP_MIN) {
+       setpoint = FLOW_SP_MIN;
      }
      changed = true;
-   }
- 
-   // Error% Down
-   if (checkFallingEdge(PIN_ERROR_DOWN, oldState_errorDown)) {
-     errorPercentValue -= 1.0f;
-     if (errorPercentValue < -50.0f) {
-       errorPercentValue = -50.0f;
+     break;
+
+   case BTN_ERROR_UP:
+     if (!step) break;
+     errorPct += 1.0f;
+     if (errorPct > 50.0f) {
+       errorPct = 50.0f;
      }
      changed = true;
+     break;
+
+   case BTN_ERROR_DOWN:
+     if (!step) break;
+     errorPct -= 1.0f;
+     if (errorPct < -50.0f) {
+       errorPct = -50.0f;
+     }
+     changed = true;
+     break;
+
+   case BTN_MODE:
+     // A short press toggles the control mode (on release); holding it for
+     // BUTTON_LONG_PRESS_MS switches the display page instead
+     if (kind == BTN_EVENT_PRESS) {
+       modeLongFired = false;
+     } else if (kind == BTN_EVENT_LONG) {
+       modeLongFired     = true;
+       pageTogglePressed = true;
+     } else if (kind == BTN_EVENT_RELEASE && wasHeld && !modeLongFired) {
+       modeTogglePressed = true;
+     }
+     break;
    }
- 
-   // Mode toggle
-   if (checkFallingEdge(PIN_MODE_TOGGLE, oldState_modeToggle)) {
-     modeTogglePressed = true;
+ }
+
+ /*
+  * Function: updateButtons
+  * Brief: Applies the button events queued since the last call to systemOn,
+  *        setpoint, error% and the mode toggle state. Changed values go to
+  *        the settings store, which commits them once they settle.
+  */
+ void updateButtons() {
+   bool changed = false;
+   modeTogglePressed = false; // Reset each iteration
+   pageTogglePressed = false;
+
+   float setpoint = flowSetpointValue.load(std::memory_order_relaxed);
+   float errorPct = errorPercentValue.load(std::memory_order_relaxed);
+
+   uint32_t tail = eventTail.load(std::memory_order_relaxed);
+   uint32_t head = eventHead.load(std::memory_order_acquire);
+   for (; tail != head; tail++) {
+     applyEvent(eventQueue[tail % BUTTON_EVENT_QUEUE], setpoint, errorPct, changed);
    }
- 
-   // Save to EEPROM if values changed
+   eventTail.store(tail, std::memory_order_release);
+
+   // Report overflows since the last call (the I/O task was held up)
+   uint32_t dropped  = droppedRepeats.load(std::memory_order_relaxed);
+   uint32_t deferred = deferredEvents.load(std::memory_order_relaxed);
+   if (dropped != loggedDropped || deferred != loggedDeferred) {
+     LOG_WARN(LOG_CAT_MAIN, "Button queue full (I/O task stalled): dropped repeats=%lu, delayed events=%lu",
+              (unsigned long)dropped, (unsigned long)deferred);
+     loggedDropped  = dropped;
+     loggedDeferred = deferred;
+   }
+
+   // Publish, and hand to the settings store
    if (changed) {
-     saveToEEPROM();
+     flowSetpointValue.store(setpoint);
+     errorPercentValue.store(errorPct);
+
+     Settings updated     = currentSettings();
+     updated.setpoint     = setpoint;
+     updated.errorPercent = errorPct;
+     changeSettings(updated);
    }
  }
  
  // Accessors
  
  bool isSystemOn() {
-   return systemOn;
+   return systemOn.load();
  }
  
  float getFlowSetpoint() {
-   return flowSetpointValue;
+   return flowSetpointValue.load();
  }
  
  float getErrorPercent()
@@ -180,14 +360,22 @@
          error_fw   = 100·(measured − expected)/expected
        → same magnitude, opposite sign
     */
-    return errorPercentValue;  
+    return errorPercentValue.load();
 }
  
  /*
   * Function: wasModeTogglePressed
-  * Brief: Returns true if the mode toggle button was pressed in this loop iteration.
+  * Brief: Returns true if a short press of the mode button ended before the last updateButtons().
   */
  bool wasModeTogglePressed() {
    return modeTogglePressed;
  }
+
+ /*
+  * Function: wasPageTogglePressed
+  * Brief: Returns true if the mode button reached a long press before the last updateButtons().
+  */
+ bool wasPageTogglePressed() {
+   return pageTogglePressed;
+ }
  
\ No newline at end of file
@@ -7,10 +7,14 @@
  *        (ON/OFF, Flow Up/Down, Error% Up/Down, Mode Toggle).
  */
 
-// Initializes button pins and loads stored values from EEPROM
+// Initializes button pins, loads stored values from EEPROM and starts sampling
 void initButtons();
 
-// Reads button inputs each loop and updates internal state
+// One debounce sample of all buttons; runs every BUTTON_SAMPLE_US from a
+// timer started by initButtons() (the host rig calls it every base tick)
+void sampleButtons();
+
+// Applies the queued button events and updates internal state
 void updateButtons();
 
 // Returns whether the system is currently ON
@@ -22,5 +26,10 @@ float getFlowSetpoint();
 // Returns the current error percentage
 float getErrorPercent();
 
-// Returns true if the mode toggle was pressed in the current loop iteration
+// Returns true if the mode toggle was pressed (short press, reported on
+// release) since the previous updateButtons()
 bool wasModeTogglePressed();
+
+// Returns true if the mode toggle was held for BUTTON_LONG_PRESS_MS since
+// the previous updateButtons() (display page switch)
+bool wasPageTogglePressed();
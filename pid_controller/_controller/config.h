@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include "const_math.h"   // constexpr exp for the derived filter constants
 
 /*
  * File: config.h
@@ -18,6 +19,33 @@ static const float kConstantVoltage = 80.0f; // Used in constant-voltage control
 // ---------------------------------------------------------------------------
 static const uint8_t SSD1306_DISPLAY_ADDR = 0x3C;
 
+/**
+ * DISPLAY_CHUNK_BYTES / DISPLAY_CHUNKS_PER_SERVICE:
+ *   Changed display columns go out as transactions of DISPLAY_CHUNK_BYTES
+ *   data bytes (~0.41 ms at 400 kHz, so one fits between two sensor reads),
+ *   at most DISPLAY_CHUNKS_PER_SERVICE per I/O wake-up. A chunk is only
+ *   sent if it cannot delay a sensor read or pump write (i2c_bus.h).
+ *
+ * DISPLAY_MIN_FRAME_MS:
+ *   Shortest spacing between two screen updates, however often the
+ *   status is posted (10 Hz).
+ */
+static const uint8_t  DISPLAY_CHUNK_BYTES        = 16;
+static const uint8_t  DISPLAY_CHUNKS_PER_SERVICE = 4;
+static const uint16_t DISPLAY_MIN_FRAME_MS       = 100;
+
+
+// ---------------------------------------------------------------------------
+// I2C Bus
+//   400 kHz (supported by the SSD1306, the mp-Lowdriver and the SLF3S);
+//   a 9-byte sensor read then takes ~0.25 ms, ~30% of the bus at 1.2 kHz.
+// ---------------------------------------------------------------------------
+static const uint32_t I2C_CLOCK_HZ = 400000;
+
+// Slack added to a low-priority transaction's bus time before it may start
+// ahead of a periodic sensor read or pump write (driver setup, ISR latency)
+static const uint32_t I2C_BUS_GUARD_US = 50;
+
 
 // ---------------------------------------------------------------------------
 // Bartels Pump Driver
@@ -26,7 +54,7 @@ static const uint8_t BARTELS_DRIVER_ADDR   = 0x59;
 static const uint8_t BARTELS_PAGE_REGISTER = 0xFF;
 static const uint8_t BARTELS_CONTROL_DATA[] = {0x00, 0x3B, 0x01, 0x01};
 
-static const float BARTELS_FREQ         = 300.0f;  // Desired pump frequency in Hz
+static constexpr float BARTELS_FREQ     = 300.0f;  // Desired pump frequency in Hz
 static const float BARTELS_ABSOLUTE_MAX = 150.0f;
 static const float BARTELS_MAX_VOLTAGE  = 150.0f;
 static const float BARTELS_MIN_VOLTAGE  = 0.0f;
@@ -41,6 +69,13 @@ static const uint8_t SLF_CALIBRATION_CMD_BYTE = 0x08;
 static const uint8_t SLF_STOP_CMD             = 0x3F;
 static const uint8_t SLF_STOP_BYTE            = 0xF9;
 
+/**
+ * FLOW_RING_SIZE:
+ *   Samples kept by the acquisition ring (power of two). 64 samples at
+ *   1.2 kHz ≈ 53 ms of history, well above the slowest reader's period.
+ */
+static const uint32_t FLOW_RING_SIZE = 64;
+
 static const float SLF_SCALE_FACTOR_FLOW = 10000.0f;
 static const float SLF_SCALE_FACTOR_TEMP = 200.0f;
 
@@ -62,6 +97,42 @@ static const float ERROR_PERCENT_MAX =  50.0f;
  */
 static const float FLOW_STEP_SIZE = 0.05f;
 
+/**
+ * BUTTON_*:
+ *   The pins are sampled every BUTTON_SAMPLE_US by a timer (buttons.cpp), not
+ *   by any task. A level counts once it has held for BUTTON_DEBOUNCE_SAMPLES
+ *   consecutive samples (contact bounce shorter than that is ignored).
+ *   Holding Flow/Error Up/Down repeats the step after BUTTON_REPEAT_DELAY_MS,
+ *   first every BUTTON_REPEAT_START_MS, each interval BUTTON_REPEAT_ACCEL_PCT
+ *   of the previous one, down to BUTTON_REPEAT_MIN_MS. Holding MODE for
+ *   BUTTON_LONG_PRESS_MS switches the display page.
+ *   Events wait in a BUTTON_EVENT_QUEUE-entry queue until the I/O task
+ *   reads them. Repeats may fill only BUTTON_REPEAT_QUEUE_MAX entries, so
+ *   presses and releases still fit if the I/O task stalls.
+ */
+static const uint32_t BUTTON_SAMPLE_US         = 1000;
+static const uint8_t  BUTTON_DEBOUNCE_SAMPLES  = 5;
+static const uint16_t BUTTON_REPEAT_DELAY_MS   = 500;
+static const uint16_t BUTTON_REPEAT_START_MS   = 200;
+static const uint16_t BUTTON_REPEAT_MIN_MS     = 25;
+static const uint8_t  BUTTON_REPEAT_ACCEL_PCT  = 85;
+static const uint16_t BUTTON_LONG_PRESS_MS     = 800;
+static const uint32_t BUTTON_EVENT_QUEUE       = 32;   // events between two updateButtons() calls
+static const uint32_t BUTTON_REPEAT_QUEUE_MAX   = BUTTON_EVENT_QUEUE / 2;
+static_assert((BUTTON_EVENT_QUEUE & (BUTTON_EVENT_QUEUE - 1)) == 0,
+              "BUTTON_EVENT_QUEUE must be a power of two");
+
+/**
+ * SETTINGS_*:
+ *   Setpoint, error %, and control mode are kept in a journal of
+ *   SETTINGS_SLOTS records in the emulated EEPROM (settings.cpp). A change
+ *   is committed SETTINGS_QUIET_MS after the last one, or as soon as the
+ *   system is switched off, not on every button press.
+ */
+static const uint16_t SETTINGS_EEPROM_SIZE = 512;   // EEPROM.begin() size
+static const uint8_t  SETTINGS_SLOTS       = 32;
+static const uint32_t SETTINGS_QUIET_MS    = 5000;
+
 
 // ---------------------------------------------------------------------------
 // Exponential Gain Parameters for PID
@@ -95,27 +166,90 @@ static const float FLOW_STEP_SIZE = 0.05f;
  *   The reference "time" or error at which we match slopes for
  *   the primary vs. secondary exponential function.
  */
-static const float FILTER_T_REF = 0.05f;
+static constexpr float FILTER_T_REF = 0.05f;
 
 /**
  * FILTER_SECONDARY_A2 / K2:
  *   For the secondary function f2(t) = A2 + (K2 - A2)*exp(-1/(B2*t)),
  *   often pinned A2=0, K2=1 for slope matching approach.
  */
-static const float FILTER_SECONDARY_A2 = 0.0f;
-static const float FILTER_SECONDARY_K2 = 0.5f;
+static constexpr float FILTER_SECONDARY_A2 = 0.0f;
+static constexpr float FILTER_SECONDARY_K2 = 0.5f;
 
 /**
- * FILTER_B2_GUESS:
- *   Initial guess for numeric solving to find B2.
+ * FILTER_B2_MIN / MAX:
+ *   Bisection bracket for the slope-matched B2.
  */
-static const float FILTER_B2_GUESS = 3.0f;
+static constexpr float FILTER_B2_MIN = 1e-3f;
+static constexpr float FILTER_B2_MAX = 100.0f;
+
+/**
+ * FILTER_B2:
+ *   Solved at compile time: the B2 at which f2'(T_REF) matches the Ki
+ *   curve's slope f1'(T_REF), where f'(t) = (K − A)·exp(−1/(B·t)) / (B·t²).
+ *   Same 60-step bisection the firmware used to run at every init.
+ *   (With the current parameters f2' stays above f1' on the upper side of
+ *   the bracket, so B2 lands on FILTER_B2_MAX, the 100 the firmware has
+ *   always run with. The exact slope match, near 245, would retune the
+ *   α curve and is not used.)
+ */
+static constexpr double filterExpSlope(double t, double A, double K, double B)
+{
+    return (t <= 1e-9) ? 0.0 : (K - A) * cmath_ce::exp(-1.0 / (B * t)) / (B * t * t);
+}
+
+static constexpr float solveFilterB2(float kiA, float kiK, float kiB,
+                                     float a2, float k2, float tRef)
+{
+    double slopeP = filterExpSlope(tRef, kiA, kiK, kiB);
+    double lo = FILTER_B2_MIN, hi = FILTER_B2_MAX, mid = lo;
+
+    for (int i = 0; i < 60; i++) {
+        mid = 0.5 * (lo + hi);
+        double slope2 = filterExpSlope(tRef, a2, k2, mid);
+        if (slope2 > slopeP) lo = mid; else hi = mid;
+        if ((hi - lo) < 1e-6) break;
+    }
+    return (float)mid;
+}
+
+static constexpr float FILTER_B2 = solveFilterB2(EXP_KI_A, EXP_KI_K, EXP_KI_B,
+                                                 FILTER_SECONDARY_A2, FILTER_SECONDARY_K2,
+                                                 FILTER_T_REF);
 
 // ─── Extra EMA pole ──────────────────────────────────────────────
 // α close to 1.0  → heavy smoothing, more delay
 // α close to 0.0  → no smoothing
 #define EMA_ALPHA   0.85f          
 
+// Reject parameter sets the filter cannot work with
+static_assert(EXP_KI_B > 0.0f && EXP_KI_K > EXP_KI_A,
+              "Ki curve must rise with |error| (B > 0, K > A)");
+static_assert(FILTER_T_REF > 0.0f, "FILTER_T_REF must be positive");
+static_assert(FILTER_SECONDARY_A2 >= 0.0f && FILTER_SECONDARY_K2 <= 1.0f &&
+              FILTER_SECONDARY_A2 < FILTER_SECONDARY_K2,
+              "filter alpha curve must rise within [0, 1]");
+static_assert(0.0f < FILTER_B2_MIN && FILTER_B2_MIN < FILTER_B2_MAX, "bad B2 bracket");
+// f2' peaks at B2 = 1/T_REF with value (K2 − A2)·e⁻¹ / T_REF
+static_assert((FILTER_SECONDARY_K2 - FILTER_SECONDARY_A2) * 0.36787944 / FILTER_T_REF >=
+              filterExpSlope(FILTER_T_REF, EXP_KI_A, EXP_KI_K, EXP_KI_B),
+              "filter alpha curve cannot match the Ki slope at FILTER_T_REF");
+static_assert(FILTER_B2 >= FILTER_B2_MIN && FILTER_B2 <= FILTER_B2_MAX, "B2 solve out of bracket");
+// The solve either matches the slopes (within 0.1 %) or stops at the end of
+// the bracket that f2' stays beyond, as it does at FILTER_B2_MAX today
+static_assert((filterExpSlope(FILTER_T_REF, FILTER_SECONDARY_A2, FILTER_SECONDARY_K2, FILTER_B2) <=
+               1.001 * filterExpSlope(FILTER_T_REF, EXP_KI_A, EXP_KI_K, EXP_KI_B) &&
+               filterExpSlope(FILTER_T_REF, FILTER_SECONDARY_A2, FILTER_SECONDARY_K2, FILTER_B2) >=
+               0.999 * filterExpSlope(FILTER_T_REF, EXP_KI_A, EXP_KI_K, EXP_KI_B)) ||
+              (FILTER_B2 >= FILTER_B2_MAX - 1e-3f &&
+               filterExpSlope(FILTER_T_REF, FILTER_SECONDARY_A2, FILTER_SECONDARY_K2, FILTER_B2_MAX) >
+               filterExpSlope(FILTER_T_REF, EXP_KI_A, EXP_KI_K, EXP_KI_B)) ||
+              (FILTER_B2 <= FILTER_B2_MIN + 1e-3f &&
+               filterExpSlope(FILTER_T_REF, FILTER_SECONDARY_A2, FILTER_SECONDARY_K2, FILTER_B2_MIN) <=
+               filterExpSlope(FILTER_T_REF, EXP_KI_A, EXP_KI_K, EXP_KI_B)),
+              "B2 solve stopped inside the bracket without matching the Ki slope");
+static_assert(EMA_ALPHA > 0.0f && EMA_ALPHA <= 1.0f, "EMA_ALPHA must be in (0, 1]");
+
 
 // ---------------------------------------------------------------------------
 // (Optional) Legacy logistic-based LPF params (you can remove if not in use)
@@ -136,10 +270,181 @@ static const float PID_DERIV_FILTER_ALPHA = 0.8f;
 // ---------------------------------------------------------------------------
 // Timing / Loop
 // ---------------------------------------------------------------------------
-static const float FLUID_TIME_CONSTANT = 0.05f;
-static const float LOOP_FREQ_FACTOR    = 15.0f;
-static const unsigned long MAIN_LOOP_DELAY_MS =
-    (unsigned long)((FLUID_TIME_CONSTANT / LOOP_FREQ_FACTOR) * 1000.0f);
+static constexpr float FLUID_TIME_CONSTANT = 0.05f;
+static constexpr float LOOP_FREQ_FACTOR    = 15.0f;
+
+/**
+ * CONTROL_PERIOD_US:
+ *   Control period (sensor → filter → PID → pump), derived from the fluid
+ *   time constant. Everything else runs on multiples of SCHED_TICK_US.
+ */
+static constexpr uint32_t CONTROL_PERIOD_US =
+    (uint32_t)((FLUID_TIME_CONSTANT / LOOP_FREQ_FACTOR) * 1000000.0f);
+
+/**
+ * SCHED_TICKS_PER_CONTROL:
+ *   Base ticks per control period (the timer runs this much faster).
+ */
+static constexpr uint16_t SCHED_TICKS_PER_CONTROL = 4;
+static constexpr uint32_t SCHED_TICK_US = CONTROL_PERIOD_US / SCHED_TICKS_PER_CONTROL;
+
+/**
+ * *_DIVIDER:
+ *   Rate of each scheduled activity, in base ticks per run.
+ *   Sensor = every tick (1.2 kHz acquisition task), telemetry ≈ 25 Hz,
+ *   display ≈ 10 Hz.
+ */
+static constexpr uint16_t SENSOR_DIVIDER = 1;
+static const uint16_t CONTROL_DIVIDER   = SCHED_TICKS_PER_CONTROL;
+static const uint16_t BUTTONS_DIVIDER   = SCHED_TICKS_PER_CONTROL;
+static const uint16_t TELEMETRY_DIVIDER = 12 * SCHED_TICKS_PER_CONTROL;
+static const uint16_t DISPLAY_DIVIDER   = 30 * SCHED_TICKS_PER_CONTROL;
+
+/**
+ * TELEMETRY_BINARY_*:
+ *   Binary telemetry (telemetry.h, serial command 'X') sends 72-byte frames
+ *   instead of ~390-byte JSON lines, so it runs 6× faster (≈ 150 Hz) and
+ *   still uses less of the 115200-baud link. The telemetry activity is
+ *   scheduled at the binary rate; JSON mode reports every
+ *   TELEMETRY_DIVIDER / TELEMETRY_BINARY_DIVIDER runs.
+ */
+static const uint16_t TELEMETRY_BINARY_DIVIDER = 2 * SCHED_TICKS_PER_CONTROL;
+static const bool     TELEMETRY_BINARY_DEFAULT = false;
+static_assert(TELEMETRY_DIVIDER % TELEMETRY_BINARY_DIVIDER == 0,
+              "JSON telemetry rate must be a multiple of the binary rate");
+
+/**
+ * TX_*_BUFFER_SIZE:
+ *   Serial output is formatted into per-task buffers (tx_buffer.h) that
+ *   the I/O task drains as fast as the driver accepts. A record that does
+ *   not fit is dropped and counted ("txDrop" in the telemetry). The I/O
+ *   buffer holds ~0.35 s of JSON telemetry at 115200 baud and the largest
+ *   single record (the 'B' benchmark line); the control task only prints
+ *   debug lines.
+ */
+static const uint32_t TX_IO_BUFFER_SIZE      = 4096;
+static const uint32_t TX_CONTROL_BUFFER_SIZE = 1024;
+
+/**
+ * FLOW_SAMPLE_RATE_HZ / DECIM_TAPS:
+ *   The control task averages the last DECIM_TAPS sensor samples (a moving
+ *   boxcar read once per control period). The window spans exactly
+ *   DECIM_PUMP_PERIODS pump periods, which puts the boxcar's nulls on
+ *   BARTELS_FREQ and all its harmonics (including their aliases).
+ */
+static constexpr float   FLOW_SAMPLE_RATE_HZ = 1000000.0f / (SCHED_TICK_US * SENSOR_DIVIDER);
+static constexpr uint8_t DECIM_PUMP_PERIODS  = 1;
+static constexpr uint8_t DECIM_TAPS =
+    (uint8_t)(FLOW_SAMPLE_RATE_HZ * DECIM_PUMP_PERIODS / BARTELS_FREQ + 0.5f);
+static constexpr uint8_t DECIM_MAX_TAPS      = 32;
+
+static_assert(DECIM_TAPS >= 1 && DECIM_TAPS <= DECIM_MAX_TAPS,
+              "decimation window out of range");
+static_assert(DECIM_TAPS * BARTELS_FREQ > 0.98f * FLOW_SAMPLE_RATE_HZ * DECIM_PUMP_PERIODS &&
+              DECIM_TAPS * BARTELS_FREQ < 1.02f * FLOW_SAMPLE_RATE_HZ * DECIM_PUMP_PERIODS,
+              "sample rate is not an integer multiple of the pump frequency; "
+              "boxcar nulls would miss the pump ripple");
+
+/**
+ * FLOW_OUTAGE_US / FLOW_HOLDOVER_MS:
+ *   The flow path is in an outage once no valid sample (a flow word read
+ *   and CRC-checked) has arrived for FLOW_OUTAGE_US, two control periods.
+ *   The controller is then frozen and the pump held at its last command,
+ *   so the integrator does not wind up on a flow it cannot see. After
+ *   FLOW_HOLDOVER_MS without a valid sample the pump is stopped; the
+ *   controller restarts from scratch when valid samples return.
+ *   The clock starts with the control task: the first valid sample gets
+ *   FLOW_STARTUP_MS on top (start command and sensor warm-up), so a sensor
+ *   that never answers ends in the same stop.
+ */
+static constexpr uint32_t FLOW_OUTAGE_US   = 2 * CONTROL_PERIOD_US;
+static const uint32_t     FLOW_HOLDOVER_MS = 250;
+static const uint32_t     FLOW_STARTUP_MS  = 200;
+
+/**
+ * IO_TICK_DIVIDER:
+ *   The I/O task wakes every IO_TICK_DIVIDER base ticks; buttons, telemetry
+ *   and display dividers must be multiples of it.
+ */
+static const uint16_t IO_TICK_DIVIDER = SCHED_TICKS_PER_CONTROL;
+
+
+// ---------------------------------------------------------------------------
+// Trend Page (trend.h, display.cpp)
+//   Long-press MODE (BUTTON_LONG_PRESS_MS) switches between the status
+//   screen and a plot of the last TREND_SECONDS of flow against setpoint.
+//   One screen column per TREND_COLUMNS entry; the plot spans
+//   ±TREND_SPAN_PCT around each column's setpoint.
+// ---------------------------------------------------------------------------
+static const uint16_t TREND_SECONDS  = 64;
+static const uint16_t TREND_COLUMNS  = 128;
+static const float    TREND_SPAN_PCT = 10.0f;
+
+// Samples are taken on every I/O wake-up (control rate): 150 per column
+static constexpr uint16_t TREND_SAMPLES_PER_COLUMN = (uint16_t)(
+    TREND_SECONDS * 1000000.0f / (SCHED_TICK_US * IO_TICK_DIVIDER) / TREND_COLUMNS + 0.5f);
+
+
+// ---------------------------------------------------------------------------
+// Tasks / Cores (ESP32-S3)
+//   Control path pinned to core 1 at high priority; buttons, EEPROM,
+//   telemetry and display on core 0.
+// ---------------------------------------------------------------------------
+static const int      CONTROL_TASK_CORE     = 1;
+static const uint32_t CONTROL_TASK_PRIORITY = 20;
+static const uint32_t CONTROL_TASK_STACK    = 8192;
+
+static const int      ACQ_TASK_CORE         = 1;   // flow acquisition, preempts control
+static const uint32_t ACQ_TASK_PRIORITY     = 21;
+static const uint32_t ACQ_TASK_STACK        = 4096;
+
+static const int      IO_TASK_CORE          = 0;
+static const uint32_t IO_TASK_PRIORITY      = 2;
+static const uint32_t IO_TASK_STACK         = 8192;
+
+
+// ---------------------------------------------------------------------------
+// Logging (log.h)
+//   LOG_LEVEL and LOG_CATEGORIES select at compile time which LOG_* calls
+//   exist at all; everything else compiles to nothing. Override from the
+//   build, e.g. for a release image:
+//     arduino-cli compile --build-property "compiler.cpp.extra_flags=-DLOG_LEVEL=0"
+//   or -DLOG_LEVEL=4 -DLOG_CATEGORIES=0x04 for EXP_CONTROL debug only.
+// ---------------------------------------------------------------------------
+#ifndef LOG_LEVEL
+#define LOG_LEVEL      3              // LOG_LEVEL_INFO
+#endif
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES 0xFF           // all
+#endif
+static const uint8_t LOG_LINE_MAX = 120;   // formatted line incl. tag, longer is cut
+
+/**
+ * PROFILER_ENABLED:
+ *   Per-stage cycle-count probes (profiler.h, serial command 'P'). One
+ *   counter read and a few stores per stage; -DPROFILER_ENABLED=0 removes
+ *   them entirely.
+ */
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Host Builds
+//   MODULE_STATE marks controller state kept in file-scope statics. The
+//   host sweep (pid_controller/host) runs one controller per thread and
+//   defines CONTROLLER_RUNTIME_TUNING: module state becomes thread_local and
+//   EXP_KI_*, EMA_ALPHA, FILTER_SECONDARY_K2 and FILTER_B2 resolve to a
+//   per-thread copy (runtime_tuning.h) seeded from the values above.
+//   Firmware builds never define it.
+// ---------------------------------------------------------------------------
+#ifdef CONTROLLER_RUNTIME_TUNING
+#define MODULE_STATE thread_local
+#include "runtime_tuning.h"
+#else
+#define MODULE_STATE
+#endif
 
 
 // ---------------------------------------------------------------------------
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * File: const_math.h
+ * Brief: constexpr math for values baked at compile time (lookup tables,
+ *        solved filter constants). Evaluated in double; never called on the
+ *        hot path at runtime.
+ */
+
+namespace cmath_ce {
+
+static constexpr double LN2 = 0.69314718055994530942;
+
+// e^x: range-reduce to x = k·ln2 + r, |r| ≤ ln2/2, then a 20-term Taylor
+// series (relative error < 1e-15 over the reduced range).
+constexpr double exp(double x)
+{
+    if (x < -700.0) return 0.0;
+    if (x >  700.0) x = 700.0;
+
+    int    k = (int)(x / LN2 + (x >= 0.0 ? 0.5 : -0.5));
+    double r = x - k * LN2;
+
+    double term = 1.0, sum = 1.0;
+    for (int i = 1; i < 20; i++) {
+        term *= r / i;
+        sum  += term;
+    }
+
+    double scale = 1.0;
+    for (int i = 0; i <  k; i++) scale *= 2.0;
+    for (int i = 0; i < -k; i++) scale *= 0.5;
+    return sum * scale;
+}
+
+constexpr double fabs(double x) { return x < 0.0 ? -x : x; }
+
+} // namespace cmath_ce
@@ -0,0 +1,174 @@
+/*
+ * File: control_cycle.cpp
+ * Brief: Sensor inputs, mode handling, controller and pump command of one
+ *        control cycle (see control_cycle.h).
+ */
+
+ #include "control_cycle.h"
+ #include "bartels.h"
+ #include "buttons.h"
+ #include "constant_voltage_control.h"
+ #include "exp_control.h"
+ #include "log.h"
+ #include "profiler.h"
+ #include <Arduino.h>
+
+ void initControlCycle(ControlCycle &c, const FlowRing &ring)
+ {
+     ring.attach(c.cursor);
+     initBoxcarDecimator(c.decimator, DECIM_TAPS);
+     initFlowGuard(c.flowGuard, micros());
+     c.flowPath         = FLOW_PATH_OK;
+     c.previousSystemOn = false;
+ }
+
+ // Drain new flow samples through the decimator (valid ones only), then
+ // take the operator inputs
+ static void takeSensorInputs(ControlCycle &c, const FlowRing &ring, SystemState &state)
+ {
+     const FlowSample *block;
+     uint32_t n;
+     while ((n = ring.peek(c.cursor, block)) > 0) {
+         for (uint32_t i = 0; i < n; i++) {
+             if (flowGuardSample(c.flowGuard, block[i])) {
+                 pushBoxcarDecimator(c.decimator, block[i].flow);
+             }
+         }
+         ring.consume(c.cursor, n);
+     }
+
+     // In an outage the last good flow stands; the decimator restarts empty
+     // so that no pre-outage sample is averaged in afterwards
+     uint8_t previousPath = c.flowPath;
+     c.flowPath = updateFlowGuard(c.flowGuard, micros());
+     if (c.flowPath != FLOW_PATH_OK && previousPath == FLOW_PATH_OK) {
+         initBoxcarDecimator(c.decimator, DECIM_TAPS);
+     }
+
+     const FlowSample *latest = ring.latest();
+     if (latest) {
+         if (c.flowPath == FLOW_PATH_OK) {
+             state.flow = compensateFlow(readBoxcarDecimator(c.decimator));
+         }
+         state.temperature    = latest->tempC;
+         state.bubbleDetected = ((latest->flags & (1 << 0)) != 0);
+     }
+     state.setpoint     = getFlowSetpoint();
+     state.errorPercent = getErrorPercent();
+
+     const FlowLinkStats &link = getFlowLinkStats();
+     state.flowCrcErrors  = link.crcFailures;
+     state.flowShortReads = link.shortReads;
+     state.flowNacks      = link.nacks;
+ }
+
+ // Outage state and counters (after any controller reset, which clears them)
+ static void reportFlowPath(const ControlCycle &c, SystemState &state)
+ {
+     state.flowPath        = c.flowPath;
+     state.flowOutages     = c.flowGuard.outages;
+     state.flowFaults      = c.flowGuard.faults;
+     state.flowOutageMs    = c.flowGuard.outageMs;
+     state.flowMaxOutageMs = c.flowGuard.maxOutageMs;
+ }
+
+ void runControlCycle(ControlCycle &c, const FlowRing &ring, SystemState &state, ControlMode mode)
+ {
+     uint8_t previousPath = c.flowPath;
+     takeSensorInputs(c, ring, state);
+
+     // System-on state comes from the buttons on the I/O core
+     bool currentSystemOn = isSystemOn();
+
+     // Detect OFF->ON or ON->OFF transitions here in the control task
+     if (!c.previousSystemOn && currentSystemOn) {
+         LOG_INFO(LOG_CAT_MAIN, "System turned ON -> initExpController()");
+         initExpController(state);
+     } else if (c.previousSystemOn && !currentSystemOn) {
+         LOG_INFO(LOG_CAT_MAIN, "System turned OFF -> initExpController()");
+         initExpController(state);
+     }
+     c.previousSystemOn = currentSystemOn;
+
+     // Flow sensor outages: hold the pump, then stop it; after a stop the
+     // controller starts over once valid flow returns
+     if (c.flowPath != previousPath) {
+         if (c.flowPath == FLOW_PATH_HOLDOVER) {
+             LOG_WARN(LOG_CAT_FLOW, "No valid flow sample -> holding the pump");
+         } else if (c.flowPath == FLOW_PATH_FAULT) {
+             LOG_WARN(LOG_CAT_FLOW, "No valid flow for %lu ms -> pump stopped", (unsigned long)c.flowGuard.outageMs);
+         } else {
+             LOG_INFO(LOG_CAT_FLOW, "Valid flow again");
+             if (previousPath == FLOW_PATH_FAULT) initExpController(state);
+         }
+     }
+
+     state.systemOn    = currentSystemOn;
+     state.controlMode = mode;
+
+     // Control logic
+     float desiredVoltage = 0.0f;
+     float pidFraction    = 0.0f;
+     float pTerm          = 0.0f;
+     float iTerm          = 0.0f;
+     float dTerm          = 0.0f;
+
+     if (state.systemOn) {
+         switch (state.controlMode) {
+             case CONTROL_MODE_EXP:
+                 if (c.flowPath == FLOW_PATH_OK) {
+                     updateExpController(
+                         state,
+                         state.flow,
+                         state.setpoint,
+                         state.errorPercent,
+                         state.systemOn,
+                         desiredVoltage,
+                         pidFraction,
+                         state.bubbleDetected,
+                         pTerm,
+                         iTerm,
+                         dTerm
+                     );
+                 } else if (c.flowPath == FLOW_PATH_HOLDOVER) {
+                     // Controller frozen; the pump keeps its last command
+                     desiredVoltage = state.desiredVoltage;
+                     pidFraction    = state.pidOutput;
+                     pTerm          = state.pTerm;
+                     iTerm          = state.iTerm;
+                     dTerm          = state.dTerm;
+                 } else {
+                     stopPump();
+                 }
+                 break;
+
+             case CONTROL_MODE_CONST_VOLTAGE:
+                 updateConstantVoltageControl(state.systemOn, desiredVoltage);
+                 break;
+         }
+     } else {
+         // If system is OFF, no controller updates
+         stopPump();
+     }
+
+     // Apply any pump command still waiting for the driver to settle
+     {
+         PROFILE_SCOPE(PROF_PUMP);
+         serviceBartels();
+     }
+
+     // Save final results
+     state.desiredVoltage = desiredVoltage;
+     state.pidOutput      = pidFraction;
+     state.pTerm          = pTerm;
+     state.iTerm          = iTerm;
+     state.dTerm          = dTerm;
+
+     const BartelsBusStats &pumpBus = getBartelsBusStats();
+     state.pumpBusTxns      = pumpBus.lastUpdateTransactions;
+     state.pumpBusBytes     = pumpBus.lastUpdateBytes;
+     state.pumpStopFailures = pumpBus.stopsFailed;
+     reportFlowPath(c, state);
+
+     state.currentTimeMs = millis();
+ }
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+#include "filter.h"        // BoxcarDecimator
+#include "flow.h"          // FlowSample
+#include "flow_guard.h"
+#include "sample_ring.h"
+#include "system_state.h"
+
+/*
+ * File: control_cycle.h
+ * Brief: One control cycle, from the new flow samples to the pump command.
+ *
+ *   The body of the control task. The sketch runs it from its control task,
+ *   and the host rig runs it from its tick loop, so the two builds share the
+ *   same code. The caller owns the flow ring and the SystemState.
+ *   Publishing the state, the run timer and the debug prints stay with the
+ *   caller. Control task only.
+ */
+
+// Timestamped flow samples from the acquisition task
+typedef SampleRing<FlowSample, FLOW_RING_SIZE> FlowRing;
+
+typedef struct {
+    RingCursor      cursor;            // position in the flow ring
+    BoxcarDecimator decimator;         // pump-ripple decimator
+    FlowGuard       flowGuard;
+    uint8_t         flowPath;          // FLOW_PATH_* this cycle
+    bool            previousSystemOn;  // on/off edge detection
+} ControlCycle;
+
+// Attaches to the flow ring and starts with the system off
+void initControlCycle(ControlCycle &c, const FlowRing &ring);
+
+// Drains the new flow samples, takes the operator inputs, handles the
+// on/off and flow outage transitions, runs the controller for `mode` and
+// services the pump. Leaves the results in `state`.
+void runControlCycle(ControlCycle &c, const FlowRing &ring, SystemState &state, ControlMode mode);
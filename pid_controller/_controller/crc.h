@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * File: crc.h
+ * Brief: Table-driven checksums used on the I2C and serial links.
+ */
+
+// Sensirion CRC-8 (poly 0x31, init 0xFF, no reflection, no final XOR).
+// crc8Sensirion({0xBE, 0xEF}) == 0x92.
+uint8_t crc8Sensirion(const uint8_t *data, size_t len);
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final XOR).
+// crc16Ccitt("123456789") == 0x29B1. Pass the previous result as `crc` to
+// continue over several buffers.
+uint16_t crc16Ccitt(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
@@ -1,43 +1,175 @@
 /*
  * File: display.cpp
  * Brief: Manages the SSD1306 display for system status reporting.
+ *
+ * The status screen is retained: the text of each line as last drawn is
+ * kept, and an update redraws only the characters that changed (opaque
+ * glyphs, so no clear is needed). Each text line is one SSD1306 page; the
+ * frame-buffer columns touched are recorded per page and only those go
+ * out over I2C, so a typical update is a few dozen bytes instead of 1 KB.
+ *
+ * The trend page (toggleDisplayPage()) plots trend.h's flow history
+ * oscilloscope-style: a new column is drawn at a write position that moves
+ * right and wraps, with a blank column ahead of it. Drawing one column per
+ * new entry keeps both the drawing and the I2C update to one column
+ * instead of shifting the whole plot.
+ *
+ * showStatus() only posts the values (newest wins, like the pump commands
+ * in bartels.cpp). serviceDisplay() draws them, at most every
+ * DISPLAY_MIN_FRAME_MS, and pushes the dirty columns in DISPLAY_CHUNK_BYTES
+ * pieces, each one only when the bus manager says it cannot delay the
+ * sensor or the pump.
  */
 
  #include "display.h"
  #include "config.h"
+ #include "i2c_bus.h"
+ #include "trend.h"
  #include <Wire.h>
  #include <Adafruit_GFX.h>
  #include <Adafruit_SSD1306.h>
- 
+ #include <string.h>
+
  // Display configuration
  static const int SCREEN_WIDTH  = 128;
  static const int SCREEN_HEIGHT = 64;
- static Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
- 
+ static const uint8_t SCREEN_ROTATION = 2;   // mounted upside down
+ static const uint8_t SCREEN_PAGES    = SCREEN_HEIGHT / 8;
+ static MODULE_STATE Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+
+ // Text layout: classic font at size 1 (6×8 px cells), one line per page
+ static const uint8_t CHAR_W     = 6;
+ static const uint8_t CHAR_H     = 8;
+ static const uint8_t TEXT_COLS  = SCREEN_WIDTH / CHAR_W;
+ static const uint8_t TEXT_LINES = 7;
+
+ // Trend page: header line, then the plot (centre row = setpoint)
+ static const uint8_t PLOT_TOP    = CHAR_H;
+ static const uint8_t PLOT_HEIGHT = SCREEN_HEIGHT - PLOT_TOP;
+ static const uint8_t PLOT_MID    = PLOT_TOP + PLOT_HEIGHT / 2;
+ static const uint8_t PLOT_HALF   = PLOT_HEIGHT / 2 - 1;    // rows for TREND_SPAN_PCT
+ static const float   PLOT_MIN_SPAN_UL = 10.0f;            // scale floor near 0 mL/min
+ static_assert(TREND_COLUMNS == SCREEN_WIDTH, "one trend column per screen column");
+
+ // SSD1306 I2C control bytes
+ static const uint8_t SSD1306_CONTROL_CMD  = 0x00;   // command stream follows
+ static const uint8_t SSD1306_CONTROL_DATA = 0x40;   // GDDRAM data follows
+
  // Tracks whether the display was successfully initialized
- static bool displayInited = false;
- 
+ static MODULE_STATE bool displayInited = false;
+
+ // Newest status not yet drawn
+ typedef struct {
+   float flow;
+   float setpoint;
+   float errorPct;
+   float bartelsVoltage;
+   float temperature;
+   bool  systemOn;
+   bool  bubbleDetected;
+ } DisplayStatus;
+ static MODULE_STATE DisplayStatus pendingStatus;
+ static MODULE_STATE bool          statusPending = false;
+
+ // Page on the screen and the one asked for (switched between updates)
+ static MODULE_STATE uint8_t shownPage     = DISPLAY_PAGE_STATUS;
+ static MODULE_STATE uint8_t requestedPage = DISPLAY_PAGE_STATUS;
+
+ // Text on the screen (blank-padded lines)
+ static MODULE_STATE char shownText[TEXT_LINES][TEXT_COLS];
+
+ // Trend columns drawn so far (trend.h numbering)
+ static MODULE_STATE uint32_t trendDrawn = 0;
+
+ // Frame-buffer columns not yet sent, per page (lo > hi = clean)
+ static MODULE_STATE uint8_t dirtyLo[SCREEN_PAGES];
+ static MODULE_STATE uint8_t dirtyHi[SCREEN_PAGES];
+
+ // Update in progress
+ static MODULE_STATE bool          flushing    = false;
+ static MODULE_STATE uint8_t       flushPage   = 0;
+ static MODULE_STATE bool          windowSent  = false;   // address window set up
+ static MODULE_STATE uint8_t       flushCol    = 0;       // next column to send
+ static MODULE_STATE bool          sendFailed  = false;   // a transaction NACKed
+ static MODULE_STATE unsigned long lastFrameMs = 0;
+
+ // Prints into one fixed-width, blank-padded text line
+ class LineWriter : public Print {
+ public:
+   explicit LineWriter(char *line) : line_(line) { memset(line_, ' ', TEXT_COLS); }
+
+   using Print::write;
+   size_t write(uint8_t c) override {
+     if (c >= ' ' && len_ < TEXT_COLS) line_[len_++] = (char)c;
+     return 1;
+   }
+
+ private:
+   char   *line_;
+   uint8_t len_ = 0;
+ };
+
+ static void markClean(uint8_t page) {
+   dirtyLo[page] = 0xFF;
+   dirtyHi[page] = 0;
+ }
+
+ // Marks pixel columns x0..x1 of a text line (8-pixel band) as changed
+ static void markDirty(uint8_t line, uint8_t x0, uint8_t x1) {
+   uint8_t page = line;
+   uint8_t lo   = x0;
+   uint8_t hi   = x1;
+   if (SCREEN_ROTATION == 2) {
+     page = (uint8_t)(SCREEN_PAGES - 1 - line);
+     uint8_t mirroredLo = (uint8_t)(SCREEN_WIDTH - 1 - hi);
+     hi = (uint8_t)(SCREEN_WIDTH - 1 - lo);
+     lo = mirroredLo;
+   }
+   if (lo < dirtyLo[page]) dirtyLo[page] = lo;
+   if (hi > dirtyHi[page]) dirtyHi[page] = hi;
+ }
+
+ static void markAllDirty() {
+   for (uint8_t p = 0; p < SCREEN_PAGES; p++) {
+     dirtyLo[p] = 0;
+     dirtyHi[p] = SCREEN_WIDTH - 1;
+   }
+ }
+
  /*
   * Function: initDisplay
   * Brief: Initializes the SSD1306 display with the address from config.h.
+  *        Runs before the tasks start, so the library's own full-frame
+  *        write of the blank screen does not need the bus manager.
   * Returns: True if successful, false otherwise.
   */
  bool initDisplay() {
+   statusPending = false;
+   flushing      = false;
+   sendFailed    = false;
+   shownPage     = DISPLAY_PAGE_STATUS;
+   requestedPage = DISPLAY_PAGE_STATUS;
+   memset(shownText, ' ', sizeof shownText);
+   for (uint8_t p = 0; p < SCREEN_PAGES; p++) markClean(p);
+
    if (!display.begin(SSD1306_SWITCHCAPVCC, SSD1306_DISPLAY_ADDR)) {
      displayInited = false;
      return false;
    }
-   display.setRotation(2);
+   display.setRotation(SCREEN_ROTATION);
    display.clearDisplay();
+   display.setTextSize(1);
+   display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);   // opaque: overwrites old glyphs
    display.display();
+   lastFrameMs   = millis();
    displayInited = true;
    return true;
  }
- 
+
  /*
   * Function: showStatus
-  * Brief: Displays flow rate, setpoint, error %, voltage, temperature, 
-  *        bubble detection status, and system power state.
+  * Brief: Posts flow rate, setpoint, error %, voltage, temperature,
+  *        bubble detection status, and system power state for display.
   */
  void showStatus(float flow,
                  float setpoint,
@@ -48,38 +180,242 @@
                  bool bubbleDetected)
  {
    if (!displayInited) return;
- 
+
+   pendingStatus.flow           = flow;
+   pendingStatus.setpoint       = setpoint;
+   pendingStatus.errorPct       = errorPct;
+   pendingStatus.bartelsVoltage = bartelsVoltage;
+   pendingStatus.temperature    = temperature;
+   pendingStatus.systemOn       = systemOn;
+   pendingStatus.bubbleDetected = bubbleDetected;
+   statusPending = true;
+ }
+
+ // The seven status lines, formatted as the screen shows them
+ static void formatStatus(const DisplayStatus &s, char text[TEXT_LINES][TEXT_COLS])
+ {
+   LineWriter flow(text[0]);
+   flow.print("Flow: ");
+   flow.print(s.flow, 3);
+   flow.print(" mL/min");
+
+   LineWriter setpt(text[1]);
+   setpt.print("Setpt: ");
+   setpt.print(s.setpoint, 3);
+   setpt.print(" mL/min");
+
+   LineWriter err(text[2]);
+   err.print("Err%: ");
+   err.print(s.errorPct, 1);
+
+   LineWriter volt(text[3]);
+   volt.print("Volt: ");
+   volt.print(s.bartelsVoltage, 1);
+
+   LineWriter temp(text[4]);
+   temp.print("Temp: ");
+   temp.print(s.temperature, 1);
+   temp.print(" C");
+
+   LineWriter bubble(text[5]);
+   bubble.print("Bubble: ");
+   bubble.print(s.bubbleDetected ? "YES" : "NO");
+
+   LineWriter power(text[6]);
+   power.print("System: ");
+   power.print(s.systemOn ? "ON" : "OFF");
+ }
+
+ // Redraws the characters of a text line that differ from the screen
+ // (one run, first to last change)
+ static void drawTextChanges(uint8_t line, const char *now) {
+   char   *shown = shownText[line];
+   uint8_t first = 0;
+   while (first < TEXT_COLS && now[first] == shown[first]) first++;
+   if (first == TEXT_COLS) return;
+   uint8_t last = TEXT_COLS - 1;
+   while (now[last] == shown[last]) last--;
+
+   display.setCursor(first * CHAR_W, line * CHAR_H);
+   for (uint8_t c = first; c <= last; c++) display.write((uint8_t)now[c]);
+   memcpy(shown + first, now + first, last - first + 1);
+   markDirty(line, (uint8_t)(first * CHAR_W), (uint8_t)(last * CHAR_W + CHAR_W - 1));
+ }
+
+ static void renderStatus() {
+   if (!statusPending) return;
+   statusPending = false;
+
+   char text[TEXT_LINES][TEXT_COLS];
+   formatStatus(pendingStatus, text);
+   for (uint8_t line = 0; line < TEXT_LINES; line++) drawTextChanges(line, text[line]);
+ }
+
+ // Plot row of a flow: the column's setpoint in the middle, ±TREND_SPAN_PCT
+ // of it at the edges, clamped to the plot
+ static int16_t plotRow(int16_t flow, int16_t setpoint) {
+   float span = fabsf((float)setpoint) * (TREND_SPAN_PCT / 100.0f);
+   if (span < PLOT_MIN_SPAN_UL) span = PLOT_MIN_SPAN_UL;
+   int16_t row = (int16_t)lroundf(PLOT_MID - (flow - setpoint) / span * PLOT_HALF);
+   if (row < PLOT_TOP) row = PLOT_TOP;
+   if (row > SCREEN_HEIGHT - 1) row = SCREEN_HEIGHT - 1;
+   return row;
+ }
+
+ static void markPlotDirty(uint8_t x) {
+   for (uint8_t line = PLOT_TOP / CHAR_H; line < SCREEN_PAGES; line++) markDirty(line, x, x);
+ }
+
+ // One plot column: min..max flow bar over a dotted setpoint line
+ static void drawTrendColumn(uint8_t x, const TrendColumn &c) {
+   display.drawFastVLine(x, PLOT_TOP, PLOT_HEIGHT, SSD1306_BLACK);
+   if (x % 4 == 0) display.drawPixel(x, PLOT_MID, SSD1306_WHITE);
+   int16_t top    = plotRow(c.flowMax, c.setpoint);
+   int16_t bottom = plotRow(c.flowMin, c.setpoint);
+   display.drawFastVLine(x, top, bottom - top + 1, SSD1306_WHITE);
+   markPlotDirty(x);
+ }
+
+ // Header with the latest values, then the columns not drawn yet
+ static void renderTrend() {
+   if (statusPending) {
+     statusPending = false;
+     char text[TEXT_COLS];
+     LineWriter head(text);
+     head.print(pendingStatus.flow, 3);
+     head.print('/');
+     head.print(pendingStatus.setpoint, 3);
+     head.print(' ');
+     head.print(TREND_SECONDS);
+     head.print("s +-");
+     head.print(TREND_SPAN_PCT, 0);
+     head.print('%');
+     drawTextChanges(0, text);
+   }
+
+   uint32_t count = trendColumnCount();
+   if (trendDrawn == count) return;
+   if (count - trendDrawn > TREND_COLUMNS) trendDrawn = count - TREND_COLUMNS;
+   for (; trendDrawn != count; trendDrawn++) {
+     drawTrendColumn((uint8_t)(trendDrawn % TREND_COLUMNS), getTrendColumn(trendDrawn));
+   }
+
+   // The blank column ahead of the write position
+   uint8_t gap = (uint8_t)(count % TREND_COLUMNS);
+   display.drawFastVLine(gap, PLOT_TOP, PLOT_HEIGHT, SSD1306_BLACK);
+   markPlotDirty(gap);
+ }
+
+ // Clears the screen for the requested page and has it drawn in full
+ static void switchPage() {
+   shownPage = requestedPage;
    display.clearDisplay();
-   display.setTextSize(1);
-   display.setTextColor(SSD1306_WHITE);
-   display.setCursor(0, 0);
- 
-   display.print("Flow: ");
-   display.print(flow, 3);
-   display.println(" mL/min");
- 
-   display.print("Setpt: ");
-   display.print(setpoint, 3);
-   display.println(" mL/min");
- 
-   display.print("Err%: ");
-   display.print(errorPct, 1);
-   display.println();
- 
-   display.print("Volt: ");
-   display.print(bartelsVoltage, 1);
-   display.println();
- 
-   display.print("Temp: ");
-   display.print(temperature, 1);
-   display.println(" C");
- 
-   display.print("Bubble: ");
-   display.println(bubbleDetected ? "YES" : "NO");
- 
-   display.print("System: ");
-   display.println(systemOn ? "ON" : "OFF");
- 
-   display.display();
+   memset(shownText, ' ', sizeof shownText);
+   markAllDirty();
+   uint32_t count = trendColumnCount();
+   trendDrawn    = count > TREND_COLUMNS ? count - TREND_COLUMNS : 0;
+   statusPending = true;   // the last posted values, on the new layout
+ }
+
+ /*
+  * Function: renderDisplay
+  * Brief: Brings the frame buffer up to date for the current page. Waits
+  *        while an update is being sent, so the columns in flight stay as
+  *        marked.
+  */
+ void renderDisplay() {
+   if (!displayInited || flushing) return;
+   if (shownPage == DISPLAY_PAGE_TREND) renderTrend();
+   else                                 renderStatus();
+ }
+
+ uint8_t toggleDisplayPage() {
+   requestedPage = (requestedPage == DISPLAY_PAGE_STATUS) ? DISPLAY_PAGE_TREND : DISPLAY_PAGE_STATUS;
+   return requestedPage;
+ }
+
+ // Moves flushPage to the next page with unsent columns; false when none
+ static bool nextDirtyPage() {
+   while (flushPage < SCREEN_PAGES && dirtyLo[flushPage] > dirtyHi[flushPage]) flushPage++;
+   return flushPage < SCREEN_PAGES;
+ }
+
+ // One write transaction through the bus manager; false if it was deferred
+ static bool sendTransaction(const uint8_t *head, uint8_t headLen,
+                             const uint8_t *data, uint8_t dataLen) {
+   if (!i2cBusTryAcquire(I2C_DEV_DISPLAY, headLen + dataLen)) return false;
+   Wire.beginTransmission(SSD1306_DISPLAY_ADDR);
+   Wire.write(head, headLen);
+   if (dataLen) Wire.write(data, dataLen);
+   if (Wire.endTransmission() != 0) sendFailed = true;
+   i2cBusRelease(I2C_DEV_DISPLAY, headLen + dataLen);
+   return true;
+ }
+
+ /*
+  * Function: pushChunk
+  * Brief: Sends the next piece of the update: per dirty page, the address
+  *        window (that page, its dirty columns), then the column data.
+  * Returns: False if the bus manager deferred it.
+  */
+ static bool pushChunk() {
+   uint8_t page = flushPage;
+   if (!windowSent) {
+     const uint8_t window[] = {
+       SSD1306_CONTROL_CMD,
+       SSD1306_PAGEADDR, page, page,
+       SSD1306_COLUMNADDR, dirtyLo[page], dirtyHi[page]
+     };
+     if (!sendTransaction(window, sizeof window, nullptr, 0)) return false;
+     windowSent = true;
+     flushCol   = dirtyLo[page];
+     return true;
+   }
+
+   uint8_t len = (uint8_t)(dirtyHi[page] - flushCol + 1);
+   if (len > DISPLAY_CHUNK_BYTES) len = DISPLAY_CHUNK_BYTES;
+   const uint8_t control = SSD1306_CONTROL_DATA;
+   if (!sendTransaction(&control, 1, display.getBuffer() + page * SCREEN_WIDTH + flushCol, len)) {
+     return false;
+   }
+
+   flushCol += len;
+   if (flushCol > dirtyHi[page]) {
+     markClean(page);
+     windowSent = false;
+     flushPage++;
+     if (!nextDirtyPage()) {
+       flushing = false;
+       // The panel may now differ from the frame buffer: send it all again
+       if (sendFailed) markAllDirty();
+       sendFailed = false;
+     }
+   }
+   return true;
+ }
+
+ /*
+  * Function: serviceDisplay
+  * Brief: Once the previous update is out and DISPLAY_MIN_FRAME_MS has
+  *        passed, draws the newest posted status; then sends up to
+  *        DISPLAY_CHUNKS_PER_SERVICE chunks of the changed columns.
+  */
+ void serviceDisplay() {
+   if (!displayInited) return;
+
+   if (!flushing) {
+     unsigned long nowMs = millis();
+     if (requestedPage != shownPage) switchPage();      // at once, not rate-capped
+     else if (nowMs - lastFrameMs < DISPLAY_MIN_FRAME_MS) return;
+     renderDisplay();
+     flushPage  = 0;
+     windowSent = false;
+     if (!nextDirtyPage()) return;   // nothing on screen changed
+     flushing    = true;
+     lastFrameMs = nowMs;
+   }
+
+   for (uint8_t n = 0; n < DISPLAY_CHUNKS_PER_SERVICE && flushing; n++) {
+     if (!pushChunk()) return;
+   }
  }
- 
\ No newline at end of file
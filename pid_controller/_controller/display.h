@@ -1,15 +1,21 @@
 #pragma once
+#include <stdint.h>
 
 /*
  * File: display.h
  * Brief: Declarations for initializing and updating the SSD1306 display.
  */
 
+enum {
+    DISPLAY_PAGE_STATUS = 0,   // the seven status lines
+    DISPLAY_PAGE_TREND         // flow vs setpoint over TREND_SECONDS (trend.h)
+};
+
 // Initializes the SSD1306 display. Returns true if successful.
 bool initDisplay();
 
-// Displays key status parameters (flow, setpoint, error%, voltage, temperature,
-// bubble detection, system on/off state).
+// Posts key status parameters (flow, setpoint, error%, voltage, temperature,
+// bubble detection, system on/off state); drawn and sent by serviceDisplay().
 void showStatus(float flow,
                 float setpoint,
                 float errorPct,
@@ -17,3 +23,18 @@ void showStatus(float flow,
                 bool systemOn,
                 float temperature,
                 bool bubbleDetected);
+
+// Brings the frame buffer up to date for the current page: the characters
+// of the newest posted status that differ from the screen, and on the trend
+// page the new plot columns; no-op while an update is being sent
+// (serviceDisplay() calls it)
+void renderDisplay();
+
+// Switches between the status screen and the trend page (on the next
+// update); returns the page switched to
+uint8_t toggleDisplayPage();
+
+// Draws the newest posted status (at most every DISPLAY_MIN_FRAME_MS) and
+// sends the changed columns a few chunks at a time, yielding the bus to
+// the sensor and pump; call every I/O wake-up
+void serviceDisplay();
@@ -13,18 +13,21 @@
  #include "filter.h"      // TwoPoleFilter + wrapper API
  #include "pid.h"
  #include "bartels.h"
+ #include "gain_lut.h"    // expCurveLut — tabulated exp(−1/v)
+ #include "log.h"
+ #include "profiler.h"
  #include <Arduino.h>
  
  // ─────────────────────────────────────────────
  // External integrator symbols (defined in pid.cpp)
- extern float integralTerm;
- extern float g_lastIntegralIncrement;
+ extern MODULE_STATE float integralTerm;
+ extern MODULE_STATE float g_lastIntegralIncrement;
  
  // ─────────────────────────────────────────────
  // Local persistent state
- static TwoPoleFilter s_errFilter;   // composite 2-pole filter
- static float         s_lastKi   = 0.0f;   // for integrator rescaling
- static float         g_errSmooth = 0.0f;  // optional for logging
+ static MODULE_STATE TwoPoleFilter s_errFilter;   // composite 2-pole filter
+ static MODULE_STATE float         s_lastKi   = 0.0f;   // for integrator rescaling
+ static MODULE_STATE float         g_errSmooth = 0.0f;  // optional for logging
  
  // ─────────────────────────────────────────────
  // Forward-declared gain helpers
@@ -42,8 +45,6 @@
      initTwoPoleFilter(s_errFilter);
      s_lastKi   = 0.0f;
      g_errSmooth = 0.0f;
- 
-     Serial.println(F("[EXP_CONTROL] initExpController → reset OK"));
  }
  
  // ─────────────────────────────────────────────
@@ -68,6 +69,8 @@
          return;
      }
  
+     ProfLap lap;
+
      /* 1. Raw error */
      float errRaw = flowSetpoint - flow;
  
@@ -78,33 +81,16 @@
      g_errSmooth         = errSmooth;
      state.filteredError = errSmooth;
      state.currentAlpha  = s_errFilter.dyn.currentAlpha;
+     lap.split(PROF_FILTER);
  
      /* 3. Exponential gains */
-     float absE = fabs(errSmooth);
-     float kp = getExpKp(absE);
-     float ki = getExpKi(absE);
-     float kd = getExpKd(absE);
- 
-     /* Rescale integrator if Ki changes */
-     if (fabs(s_lastKi - ki) > 1e-9f) {
-         if (fabs(s_lastKi) > 1e-9f && fabs(ki) > 1e-9f)
-             integralTerm *= s_lastKi / ki;
-         s_lastKi = ki;
-     }
- 
-     setPIDGains(kp, ki, kd);
+     float kp, ki, kd;
+     computeExpGains(fabs(errSmooth), kp, ki, kd);
      state.pGain = kp;  state.iGain = ki;  state.dGain = kd;
+     lap.split(PROF_GAINS);
  
-     /* 4. PID update */
-     pidFraction = updatePIDNormal(errSmooth, pTermOut, iTermOut, dTermOut);
- 
-     /* Clamp & anti-windup */
-     if (pidFraction > 1.0f) {
-         integralTerm -= g_lastIntegralIncrement;
-         pidFraction = 1.0f;
-     } else if (pidFraction < 0.0f) {
-         pidFraction = 0.0f;
-     }
+     /* 4. PID update (integrator rescale, clamp & anti-windup) */
+     pidFraction = stepExpPid(errSmooth, kp, ki, kd, s_lastKi, pTermOut, iTermOut, dTermOut);
  
      /* 5. Voltage mapping + limits */
      desiredVoltage = pidFraction * BARTELS_MAX_VOLTAGE;
@@ -112,24 +98,47 @@
          desiredVoltage = BARTELS_MIN_VOLTAGE;
      if (desiredVoltage > BARTELS_MAX_VOLTAGE)
          desiredVoltage = BARTELS_MAX_VOLTAGE;
+     lap.split(PROF_PID);
  
      /* 6. Drive pump */
      runSequence(desiredVoltage);
+     LOG_DEBUG(LOG_CAT_EXP_CONTROL, "err=%.4f out=%.4f volt=%.1f", errSmooth, pidFraction, desiredVoltage);
  }
  
  // ─────────────────────────────────────────────
- // Exponential gain helper
- static float expCurve(float x, float A, float K, float B, float C)
+ // Exponential gain helpers — table lookup, see gain_lut.h for the error bound
+ static float getExpKp(float x){ return expCurveLut(x,EXP_KP_A,EXP_KP_K,EXP_KP_B,EXP_KP_C); }
+ static float getExpKi(float x){ return expCurveLut(x,EXP_KI_A,EXP_KI_K,EXP_KI_B,EXP_KI_C); }
+ static float getExpKd(float x){ return expCurveLut(x,EXP_KD_A,EXP_KD_K,EXP_KD_B,EXP_KD_C); }
+ 
+ void computeExpGains(float absError, float &kp, float &ki, float &kd)
  {
-     float denom = B * (x - C);
-     if (fabs(denom) < 1e-9f) return A;
-     float v = A + (K - A) * expf(-1.0f / denom);
-     if (v < A) v = A;
-     if (v > K) v = K;
-     return v;
+     kp = getExpKp(absError);
+     ki = getExpKi(absError);
+     kd = getExpKd(absError);
+ }
+
+ float stepExpPid(float errSmooth, float kp, float ki, float kd, float &lastKi,
+                  float &pTermOut, float &iTermOut, float &dTermOut)
+ {
+     /* Rescale integrator if Ki changes */
+     if (fabs(lastKi - ki) > 1e-9f) {
+         if (fabs(lastKi) > 1e-9f && fabs(ki) > 1e-9f)
+             integralTerm *= lastKi / ki;
+         LOG_DEBUG(LOG_CAT_EXP_CONTROL, "Ki %.6f -> %.6f, integralTerm=%.6f", lastKi, ki, integralTerm);
+         lastKi = ki;
+     }
+     setPIDGains(kp, ki, kd);
+
+     float pidFraction = updatePIDNormal(errSmooth, pTermOut, iTermOut, dTermOut);
+
+     /* Clamp & anti-windup */
+     if (pidFraction > 1.0f) {
+         integralTerm -= g_lastIntegralIncrement;
+         pidFraction = 1.0f;
+     } else if (pidFraction < 0.0f) {
+         pidFraction = 0.0f;
+     }
+     return pidFraction;
  }
- 
- static float getExpKp(float x){ return expCurve(x,EXP_KP_A,EXP_KP_K,EXP_KP_B,EXP_KP_C); }
- static float getExpKi(float x){ return expCurve(x,EXP_KI_A,EXP_KI_K,EXP_KI_B,EXP_KI_C); }
- static float getExpKd(float x){ return expCurve(x,EXP_KD_A,EXP_KD_K,EXP_KD_B,EXP_KD_C); }
  
\ No newline at end of file
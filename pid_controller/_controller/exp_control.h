@@ -37,4 +37,21 @@ void updateExpController(
     float &dTermOut
 );
 
+/**
+ * The gain schedule on its own: Kp/Ki/Kd for a filtered |error|.
+ * updateExpController() uses it; exposed so the host replay can time and
+ * check the stage separately.
+ */
+void computeExpGains(float absError, float &kp, float &ki, float &kd);
+
+/**
+ * The PID step on its own: rescales the integrator if Ki differs from
+ * `lastKi` (then updated), applies the gains, runs the PID on the filtered
+ * error and clamps the output to 0..1 with anti-windup. Returns the PID
+ * fraction. updateExpController() uses it; exposed so the host replay runs
+ * the same code.
+ */
+float stepExpPid(float errSmooth, float kp, float ki, float kd, float &lastKi,
+                 float &pTermOut, float &iTermOut, float &dTermOut);
+
 #endif // EXP_CONTROL_H
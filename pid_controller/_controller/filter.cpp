@@ -1,6 +1,8 @@
 /*
  * File: filter.cpp
  * Purpose
+ *   0) Boxcar decimator: many raw sensor samples → one per control period,
+ *      with nulls on the pump frequency and its harmonics.
  *   1) Adaptive first-order LPF whose α(|e|) is slope–matched to the Ki curve.
  *   2) Tiny fixed-α EMA pole for extra polish.
  *   3) Optional wrapper (TwoPoleFilter) that cascades the two.
@@ -12,38 +14,49 @@
 
  #include "filter.h"
  #include "config.h"      // EXP_KI_*, FILTER_*, EMA_ALPHA
+ #include "gain_lut.h"    // expShapeLut — tabulated exp(−1/v)
  #include <Arduino.h>
  #include <math.h>
  
- /*──────────────────────── INTERNALS FOR ADAPTIVE α ───────────────────────*/
- static float s_b2 = 0.0f;   // solved once (slope-matching)
- 
- static float customExpDerivative(float t, float A, float K, float B)
+ /*──────────────────────── BOXCAR DECIMATOR ───────────────────────────────*/
+ /*
+  * Moving average over the last `length` samples, read once per control
+  * period. With length = fs / f_pump the response
+  *     H(f) = sin(π f N / fs) / (N sin(π f / fs))
+  * is zero at every multiple of f_pump, and the group delay is only
+  * (N − 1) / 2 samples (1.25 ms for N = 4 at 1.2 kHz).
+  * Taps are re-summed on each read, so no running-sum drift.
+  */
+ void initBoxcarDecimator(BoxcarDecimator &d, uint8_t length)
  {
-     if (t <= 1e-9f) return 0.0f;
-     float factor = (K - A) * expf(-1.0f / (B * t));
-     return factor / (B * t * t);
+     if (length < 1)              length = 1;
+     if (length > DECIM_MAX_TAPS) length = DECIM_MAX_TAPS;
+     d.length = length;
+     d.idx    = 0;
+     d.filled = 0;
  }
- 
- static float computeB2ViaSlope(float A1,float K1,float B1,
-                                float A2,float K2,float Tref)
+
+ void pushBoxcarDecimator(BoxcarDecimator &d, float in)
  {
-     float slopeP = customExpDerivative(Tref,A1,K1,B1);
-     float lo=1e-3f, hi=100.0f, eps=1e-6f, mid=FILTER_B2_GUESS;
- 
-     for (int i=0;i<60;i++) {
-         mid  = 0.5f*(lo+hi);
-         float slope2 = customExpDerivative(Tref,A2,K2,mid);
-         (slope2 > slopeP) ? lo = mid : hi = mid;
-         if ((hi-lo) < eps) break;
-     }
-     return mid;
+     d.taps[d.idx] = in;
+     d.idx = (uint8_t)((d.idx + 1) % d.length);
+     if (d.filled < d.length) d.filled++;
  }
- 
+
+ float readBoxcarDecimator(const BoxcarDecimator &d)
+ {
+     if (d.filled == 0) return 0.0f;
+     float sum = 0.0f;
+     for (uint8_t i = 0; i < d.filled; i++) sum += d.taps[i];
+     return sum / d.filled;
+ }
+
+ /*──────────────────────── INTERNALS FOR ADAPTIVE α ───────────────────────*/
+ // B2 is slope-matched to the Ki curve at compile time (FILTER_B2, config.h)
  static float computeAlphaSecondary(float e,float A2,float K2)
  {
      if (e < 1e-9f) return 1.0f;
-     float val = A2 + (K2 - A2) * expf(-1.0f / (s_b2 * e));
+     float val = A2 + (K2 - A2) * expShapeLut(FILTER_B2 * e);
      if (val < 0.0f) val = 0.0f;
      if (val > 1.0f) val = 1.0f;
      return val;
@@ -52,12 +65,6 @@
  /*──────────────────────── PUBLIC ADAPTIVE FILTER ─────────────────────────*/
  void initDynamicLPFilter(DynamicLPFilter &f)
  {
-     Serial.println(F("[FILTER] slope-matching B2 …"));
-     s_b2 = computeB2ViaSlope(EXP_KI_A,EXP_KI_K,EXP_KI_B,
-                              FILTER_SECONDARY_A2,FILTER_SECONDARY_K2,
-                              FILTER_T_REF);
-     Serial.print  (F("[FILTER] B2 = ")); Serial.println(s_b2,6);
- 
      f.state = 0.0f;
      f.currentAlpha = 0.0f;
  }
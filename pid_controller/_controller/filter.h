@@ -1,5 +1,14 @@
 #pragma once
 #include <stdint.h>
+#include "config.h"     // DECIM_MAX_TAPS
+
+/*──────── Pump-ripple boxcar decimator ─────────*/
+typedef struct {
+    float   taps[DECIM_MAX_TAPS];   // last `length` raw samples (circular)
+    uint8_t length;
+    uint8_t idx;                    // next slot to overwrite
+    uint8_t filled;                 // samples held so far (≤ length)
+} BoxcarDecimator;
 
 /*──────── Slope-matched first-pole filter ────────*/
 typedef struct {
@@ -19,6 +28,11 @@ typedef struct {
     SimpleEMA       ema;   // fixed-α pole
 } TwoPoleFilter;
 
+/*———  Decimation front end ————————————————*/
+void  initBoxcarDecimator(BoxcarDecimator &d, uint8_t length);
+void  pushBoxcarDecimator(BoxcarDecimator &d, float in);   // every raw sample
+float readBoxcarDecimator(const BoxcarDecimator &d);       // once per control period
+
 /*———  Primary adaptive filter ————————————*/
 void  initDynamicLPFilter (DynamicLPFilter &f);
 float updateDynamicLPFilter(DynamicLPFilter &f, float in);
@@ -7,29 +7,68 @@
  #include "flow.h"
  #include "config.h"
  #include "buttons.h"
+ #include "crc.h"
+ #include "i2c_bus.h"
+ #include "log.h"
  #include <Wire.h>
  #include <Arduino.h>
+ #include <atomic>
  
- static bool  measuringFlow  = false;
- static int   readAttemptCnt = 0;
- static float rawFlow_mLmin  = 0.0f;
- static float rawTempC       = 0.0f;
- static uint16_t lastFlags   = 0;
+ // wantMeasuring: set by start/stop; measuringFlow: the sensor accepted the
+ // start command and still answers (the acquisition task retries otherwise)
+ static MODULE_STATE std::atomic<bool> wantMeasuring{false};
+ static MODULE_STATE std::atomic<bool> measuringFlow{false};
+ static MODULE_STATE unsigned long lastAnswerMs   = 0;
+ static MODULE_STATE unsigned long lastStartTryMs = 0;
+ static MODULE_STATE int   readAttemptCnt = 0;
+ static MODULE_STATE unsigned long measureStartMs = 0;
+ static MODULE_STATE float rawFlow_mLmin  = 0.0f;
+ static MODULE_STATE float rawTempC       = 0.0f;
+ static MODULE_STATE uint16_t lastFlags   = 0;
+ static MODULE_STATE FlowLinkStats linkStats = {};
+
+ static const uint8_t SLF_FRAME_SIZE = 9;
+
+ // First reads after the start command are not trusted
+ static const unsigned long SLF_WARMUP_MS = 100;
+
+ // A sensor that does not answer for this long (or at start) gets the start
+ // command again, at most this often (it forgets it after a power glitch)
+ static const unsigned long SLF_RESTART_MS = 100;
+
+ // Sends the start command; no logging (also used by the acquisition task)
+ static uint8_t sendStartCommand() {
+   lastStartTryMs = millis();
+   i2cBusAcquire(I2C_DEV_FLOW);
+   Wire.beginTransmission(SLF_FLOW_SENSOR_ADDR);
+   Wire.write(SLF_START_CMD);
+   Wire.write(SLF_CALIBRATION_CMD_BYTE);
+   uint8_t err = Wire.endTransmission(true);
+   i2cBusRelease(I2C_DEV_FLOW, 2);
+   if (err != 0) {
+     linkStats.nacks++;
+     return err;
+   }
+
+   readAttemptCnt = 0;
+   measureStartMs = millis();
+   lastAnswerMs   = measureStartMs;
+   measuringFlow  = true;
+   return 0;
+ }
  
  /*
   * Starts continuous measurement mode for the flow sensor.
-  * Returns true if successful; otherwise false on I2C error.
+  * Returns true if successful; otherwise false on I2C error, in which case
+  * acquireFlowSample() retries every SLF_RESTART_MS.
   */
  bool startFlowMeasurement() {
-   Wire.beginTransmission(SLF_FLOW_SENSOR_ADDR);
-   Wire.write(SLF_START_CMD);
-   Wire.write(SLF_CALIBRATION_CMD_BYTE);
-   uint8_t err = Wire.endTransmission(true);
+   wantMeasuring = true;
+   uint8_t err = sendStartCommand();
    if (err != 0) {
+     LOG_WARN(LOG_CAT_FLOW, "start command failed (Wire error %u)", err);
      return false;
    }
-   measuringFlow  = true;
-   readAttemptCnt = 0;
    return true;
  }
  
@@ -38,17 +77,98 @@
   * Returns true if successful; otherwise false on I2C error.
   */
  bool stopFlowMeasurement() {
+   wantMeasuring = false;
+   i2cBusAcquire(I2C_DEV_FLOW);
    Wire.beginTransmission(SLF_FLOW_SENSOR_ADDR);
    Wire.write(SLF_STOP_CMD);
    Wire.write(SLF_STOP_BYTE);
    uint8_t err = Wire.endTransmission(true);
+   i2cBusRelease(I2C_DEV_FLOW, 2);
    measuringFlow = false;
+   if (err != 0) LOG_WARN(LOG_CAT_FLOW, "stop command failed (Wire error %u)", err);
    return (err == 0);
  }
  
+ /*
+  * Validates and decodes one 9-byte SLF3S frame: three big-endian words
+  * (flow, temperature, flags), each followed by its Sensirion CRC-8.
+  * Words that fail their CRC are flagged in out.badWords and left at 0.
+  * Returns true if all three words are valid.
+  */
+ bool decodeSlfFrame(const uint8_t *frame, SlfFrame &out) {
+   uint16_t words[3] = {0, 0, 0};
+   out.badWords = 0;
+
+   for (uint8_t w = 0; w < 3; w++) {
+     const uint8_t *p = frame + 3 * w;
+     if (crc8Sensirion(p, 2) != p[2]) {
+       out.badWords |= (uint8_t)(1u << w);
+       continue;
+     }
+     words[w] = (uint16_t)((p[0] << 8) | p[1]);
+   }
+
+   out.rawFlow = (int16_t)words[0];
+   out.rawTemp = (int16_t)words[1];
+   out.flags   = words[2];
+   return out.badWords == 0;
+ }
+
+ /*
+  * Reads one frame over I2C and updates the held raw values. A NACK, short
+  * read or CRC failure is counted and the last good value is kept.
+  * Returns the FLOW_SAMPLE_* status of this read; `flowQuality` says
+  * whether the flow value is new (FLOW_QUALITY_*).
+  */
+ static uint8_t readSensorFrame(uint8_t &flowQuality) {
+   // The Wire receive buffer is shared too: empty it before releasing the bus
+   uint8_t frame[SLF_FRAME_SIZE];
+   i2cBusAcquire(I2C_DEV_FLOW);
+   uint8_t received = Wire.requestFrom((uint8_t)SLF_FLOW_SENSOR_ADDR, (uint8_t)SLF_FRAME_SIZE);
+   bool complete = received >= SLF_FRAME_SIZE && Wire.available() >= SLF_FRAME_SIZE;
+   for (uint8_t i = 0; complete && i < SLF_FRAME_SIZE; i++) {
+     frame[i] = (uint8_t)Wire.read();
+   }
+   while (Wire.available() > 0) Wire.read();   // drop a partial frame
+   i2cBusRelease(I2C_DEV_FLOW, received);
+
+   flowQuality = FLOW_QUALITY_STALE;
+   if (received == 0) {
+     linkStats.nacks++;
+     flowQuality = FLOW_QUALITY_MISSING;
+     return FLOW_SAMPLE_NACK;
+   }
+   if (!complete) {
+     linkStats.shortReads++;
+     return FLOW_SAMPLE_SHORT;
+   }
+
+   SlfFrame decoded;
+   bool ok = decodeSlfFrame(frame, decoded);
+   if (ok) {
+     linkStats.framesOk++;
+   } else {
+     linkStats.crcFailures++;
+   }
+
+   // Convert raw values (each word only if its own CRC matched)
+   if (!(decoded.badWords & SLF_WORD_FLOW)) {
+     rawFlow_mLmin = (float)decoded.rawFlow / SLF_SCALE_FACTOR_FLOW;
+     flowQuality   = FLOW_QUALITY_VALID;
+   }
+   if (!(decoded.badWords & SLF_WORD_TEMP)) {
+     rawTempC = (float)decoded.rawTemp / SLF_SCALE_FACTOR_TEMP;
+   }
+   if (!(decoded.badWords & SLF_WORD_FLAGS)) {
+     lastFlags = decoded.flags;
+   }
+   return ok ? FLOW_SAMPLE_OK : FLOW_SAMPLE_CRC;
+ }
+
  /*
   * Reads sensor data (flow, temp, flags) and returns a compensated flow value.
-  * If measurement is not active or data is unavailable, returns 0.0f.
+  * If measurement is not active, returns 0.0f. A NACK, short read or CRC
+  * failure is counted and the last good value is held instead.
   * The sensor stabilizes on early attempts (with a brief delay).
   */
  float readFlow() {
@@ -61,41 +181,59 @@
      delay(100);
    }
  
-   Wire.requestFrom((uint8_t)SLF_FLOW_SENSOR_ADDR, (uint8_t)9);
-   if (Wire.available() < 9) {
-     return 0.0f;
+   uint8_t quality;
+   readSensorFrame(quality);
+   return compensateFlow(rawFlow_mLmin);
+ }
+
+ /*
+  * Non-blocking read for the acquisition task: one frame into a
+  * timestamped sample (uncompensated flow). Returns false while measurement
+  * is off or the sensor is still warming up. If the sensor never took the
+  * start command, or has not answered for SLF_RESTART_MS, the start command
+  * is sent again (every SLF_RESTART_MS, counted in restarts); the control
+  * task sees the gap as a flow outage (flow_guard.h).
+  */
+ bool acquireFlowSample(FlowSample &out) {
+   unsigned long nowMs = millis();
+   if (!measuringFlow) {
+     if (wantMeasuring && nowMs - lastStartTryMs >= SLF_RESTART_MS) {
+       linkStats.restarts++;
+       sendStartCommand();
+     }
+     return false;
    }
- 
-   // Read flow
-   uint8_t flowHigh = Wire.read();
-   uint8_t flowLow  = Wire.read();
-   Wire.read(); // discard CRC
-   int16_t rawFlowInt = (int16_t)((flowHigh << 8) | flowLow);
- 
-   // Read temperature
-   uint8_t tempHigh = Wire.read();
-   uint8_t tempLow  = Wire.read();
-   Wire.read(); // discard CRC
-   int16_t rawTempInt = (int16_t)((tempHigh << 8) | tempLow);
- 
-   // Read flags
-   uint8_t flagHigh = Wire.read();
-   uint8_t flagLow  = Wire.read();
-   Wire.read(); // discard CRC
-   lastFlags = (uint16_t)((flagHigh << 8) | flagLow);
- 
-   // Convert raw values
-   rawFlow_mLmin = (float)rawFlowInt / SLF_SCALE_FACTOR_FLOW;
-   rawTempC      = (float)rawTempInt / SLF_SCALE_FACTOR_TEMP;
- 
-   // Apply user-defined error compensation
+   if (nowMs - measureStartMs < SLF_WARMUP_MS) return false;
+
+   out.timeUs  = micros();
+   out.status  = readSensorFrame(out.quality);
+   out.flow    = rawFlow_mLmin;
+   out.tempC   = rawTempC;
+   out.flags   = lastFlags;
+
+   if (out.status != FLOW_SAMPLE_NACK) {
+     lastAnswerMs = nowMs;
+   } else if (nowMs - lastAnswerMs >= SLF_RESTART_MS) {
+     measuringFlow  = false;            // lost: start it again
+     lastStartTryMs = nowMs - SLF_RESTART_MS;
+   }
+   return true;
+ }
+
+ /*
+  * Applies the user-defined error compensation to a raw flow (mL/min).
+  */
+ float compensateFlow(float rawFlow) {
    float err = getErrorPercent();          // +10 means high
    float compFactor = 1.0f / (1.0f - err/100.0f);
-   float compensatedFlow  = rawFlow_mLmin * compFactor;
- 
-   return compensatedFlow;
+   return rawFlow * compFactor;
  }
  
+ // Returns the running link counters (NACKs, short reads, CRC failures)
+ const FlowLinkStats &getFlowLinkStats() {
+   return linkStats;
+ }
+
  // Returns the last temperature reading (°C)
  float getTempC() {
    return rawTempC;
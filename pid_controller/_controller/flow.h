@@ -7,15 +7,71 @@
 
 #include <stdint.h>
 
-// Starts continuous flow measurement; returns true if successful
+// One decoded measurement frame; bit n of badWords = word n failed its CRC
+enum {
+  SLF_WORD_FLOW  = 1 << 0,
+  SLF_WORD_TEMP  = 1 << 1,
+  SLF_WORD_FLAGS = 1 << 2
+};
+
+struct SlfFrame {
+  int16_t  rawFlow;
+  int16_t  rawTemp;
+  uint16_t flags;
+  uint8_t  badWords;
+};
+
+// Outcome of one sensor read
+enum {
+  FLOW_SAMPLE_OK = 0,
+  FLOW_SAMPLE_CRC,     // at least one word held from the previous frame
+  FLOW_SAMPLE_SHORT,   // fewer than 9 bytes; all values held
+  FLOW_SAMPLE_NACK     // no answer; all values held
+};
+
+// What a sample's flow value is worth to the controller
+enum {
+  FLOW_QUALITY_VALID = 0,   // flow word read and CRC-checked in this frame
+  FLOW_QUALITY_STALE,       // sensor answered, flow held from an earlier frame
+  FLOW_QUALITY_MISSING      // sensor did not answer, flow held
+};
+
+// One timestamped acquisition (flow is uncompensated, mL/min)
+struct FlowSample {
+  uint32_t timeUs;
+  float    flow;
+  float    tempC;
+  uint16_t flags;
+  uint8_t  status;     // FLOW_SAMPLE_*
+  uint8_t  quality;    // FLOW_QUALITY_*
+};
+
+// Running I2C link counters for the flow sensor
+struct FlowLinkStats {
+  uint32_t framesOk;      // frames with all three CRCs valid
+  uint32_t crcFailures;   // frames with at least one bad CRC
+  uint32_t shortReads;    // fewer than 9 bytes returned
+  uint32_t nacks;         // sensor did not answer (a read or start command)
+  uint32_t restarts;      // start commands retried by the acquisition task
+};
+
+// Starts continuous flow measurement; returns true if successful. If the
+// sensor does not answer, acquireFlowSample() keeps retrying.
 bool     startFlowMeasurement();
 
-// Stops continuous flow measurement; returns true if successful
+// Stops continuous flow measurement (and the retries); returns true if successful
 bool     stopFlowMeasurement();
 
 // Reads the current flow (mL/min), applying any user error compensation
 float    readFlow();
 
+// Non-blocking read of one frame into a timestamped sample (acquisition
+// task); also restarts measurement when the sensor is missing or lost it
+bool     acquireFlowSample(FlowSample &out);
+
+// Applies the user error compensation to a raw flow in mL/min
+float    compensateFlow(float rawFlow);
+
 // Returns the most recent temperature reading in °C
 float    getTempC();
 
@@ -27,3 +83,9 @@ float    getRawFlow();
 
 // Returns the raw temperature reading in °C (if implemented for debugging)
 float    getRawTemp();
+
+// Validates (CRC-8 per word) and decodes a 9-byte sensor frame
+bool     decodeSlfFrame(const uint8_t *frame, SlfFrame &out);
+
+// Returns the running link counters
+const FlowLinkStats &getFlowLinkStats();
@@ -0,0 +1,51 @@
+/*
+ * File: flow_guard.cpp
+ * Brief: Flow path state and outage statistics (see flow_guard.h).
+ */
+
+ #include "flow_guard.h"
+ #include "config.h"
+
+ void initFlowGuard(FlowGuard &g, uint32_t nowUs)
+ {
+     g = {};
+     g.state       = FLOW_PATH_OK;
+     g.lastValidUs = nowUs + FLOW_STARTUP_MS * 1000;   // first valid sample due by then
+ }
+
+ bool flowGuardSample(FlowGuard &g, const FlowSample &s)
+ {
+     switch (s.quality) {
+         case FLOW_QUALITY_VALID:
+             g.lastValidUs = s.timeUs;
+             return true;
+         case FLOW_QUALITY_STALE:
+             g.staleSamples++;
+             return false;
+         default:
+             g.missingSamples++;
+             return false;
+     }
+ }
+
+ uint8_t updateFlowGuard(FlowGuard &g, uint32_t nowUs)
+ {
+     uint32_t sinceUs = nowUs - g.lastValidUs;
+     if ((int32_t)sinceUs <= (int32_t)FLOW_OUTAGE_US) {
+         g.state    = FLOW_PATH_OK;
+         g.outageMs = 0;
+         return g.state;
+     }
+
+     if (g.state == FLOW_PATH_OK) {
+         g.state = FLOW_PATH_HOLDOVER;
+         g.outages++;
+     }
+     g.outageMs = sinceUs / 1000;
+     if (g.outageMs > g.maxOutageMs) g.maxOutageMs = g.outageMs;
+     if (g.state == FLOW_PATH_HOLDOVER && g.outageMs >= FLOW_HOLDOVER_MS) {
+         g.state = FLOW_PATH_FAULT;
+         g.faults++;
+     }
+     return g.state;
+ }
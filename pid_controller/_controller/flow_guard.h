@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include "flow.h"
+
+/*
+ * File: flow_guard.h
+ * Brief: Tracks whether the control task is still getting valid flow
+ *        samples, and for how long it has not.
+ *
+ *   Every sample goes through flowGuardSample(); only valid ones may feed
+ *   the decimator. Once per control cycle updateFlowGuard() returns the
+ *   state of the flow path:
+ *     FLOW_PATH_OK       – a valid sample within FLOW_OUTAGE_US
+ *     FLOW_PATH_HOLDOVER – outage: freeze the controller, hold the pump
+ *     FLOW_PATH_FAULT    – outage longer than FLOW_HOLDOVER_MS: pump off
+ *   The outage clock starts at initFlowGuard(), FLOW_STARTUP_MS late (sensor
+ *   start and warm-up), so a sensor that never delivers a valid sample
+ *   also ends in FLOW_PATH_FAULT. Control task only.
+ */
+
+enum {
+    FLOW_PATH_OK = 0,
+    FLOW_PATH_HOLDOVER,
+    FLOW_PATH_FAULT
+};
+
+typedef struct {
+    uint8_t  state;            // FLOW_PATH_*
+    uint32_t lastValidUs;      // time of the newest valid sample (or start-up deadline)
+    uint32_t staleSamples;     // FLOW_QUALITY_STALE samples
+    uint32_t missingSamples;   // FLOW_QUALITY_MISSING samples
+    uint32_t outages;
+    uint32_t faults;           // outages that reached FLOW_PATH_FAULT
+    uint32_t outageMs;         // current outage so far, 0 = none
+    uint32_t maxOutageMs;
+} FlowGuard;
+
+// Starts the outage clock at `nowUs` (plus the start-up allowance)
+void    initFlowGuard(FlowGuard &g, uint32_t nowUs);
+
+// Counts one sample; true if its flow may be used
+bool    flowGuardSample(FlowGuard &g, const FlowSample &s);
+
+// Once per control cycle, after the new samples; returns FLOW_PATH_*
+uint8_t updateFlowGuard(FlowGuard &g, uint32_t nowUs);
@@ -0,0 +1,109 @@
+/*
+ * File: gain_lut.cpp
+ * Brief: Compile-time tables for g(v) = exp(−1/v) and their lookup.
+ *
+ *   Three uniform segments, denser where g bends hardest (peak |g''| ≈ 2.6
+ *   near v ≈ 0.2):
+ *       [0, 16)      1024 points   err ≈ 7.8e-5
+ *       [16, 128)     256 points   err ≈ 1.2e-5
+ *       [128, 1024)    64 points   err ≈ 2.4e-5
+ *       ≥ 1024       g ≈ 1 − 1/v   err < 4.8e-7
+ *   5.3 KB of flash in total. With the shipped config the index v stays
+ *   below 1024 for any |error| under 10 mL/min.
+ */
+
+ #include "gain_lut.h"
+ #include "const_math.h"
+ #include <math.h>
+
+ namespace {
+
+ template <int N>
+ struct PwlSegment {
+     float lo;
+     float hi;
+     float invStep;
+     float y[N];
+ };
+
+ constexpr double expShapeExact(double v)
+ {
+     return v > 0.0 ? cmath_ce::exp(-1.0 / v) : 0.0;
+ }
+
+ template <int N>
+ constexpr PwlSegment<N> buildSegment(float lo, float hi)
+ {
+     PwlSegment<N> s{};
+     s.lo      = lo;
+     s.hi      = hi;
+     s.invStep = (float)((N - 1) / ((double)hi - lo));
+     for (int i = 0; i < N; i++) {
+         double v = lo + ((double)hi - lo) * i / (N - 1);
+         s.y[i] = (float)expShapeExact(v);
+     }
+     return s;
+ }
+
+ // Same arithmetic as the runtime path, so the bound below is the real one
+ template <int N>
+ constexpr float evalSegment(const PwlSegment<N> &s, float v)
+ {
+     float pos = (v - s.lo) * s.invStep;
+     int   i   = (int)pos;
+     if (i > N - 2) i = N - 2;
+     if (i < 0)     i = 0;
+     float t = pos - (float)i;
+     return s.y[i] + (s.y[i + 1] - s.y[i]) * t;
+ }
+
+ // Max |table − exact| over 7 interior points of every interval
+ template <int N>
+ constexpr double maxSegmentError(const PwlSegment<N> &s)
+ {
+     double worst = 0.0;
+     double step  = ((double)s.hi - s.lo) / (N - 1);
+     for (int i = 0; i < N - 1; i++) {
+         for (int k = 1; k < 8; k++) {
+             double v   = s.lo + (i + k / 8.0) * step;
+             double err = cmath_ce::fabs(evalSegment(s, (float)v) - expShapeExact(v));
+             if (err > worst) worst = err;
+         }
+     }
+     return worst;
+ }
+
+ constexpr float SEG0_HI = 16.0f;
+ constexpr float SEG1_HI = 128.0f;
+ constexpr float SEG2_HI = 1024.0f;
+
+ constexpr PwlSegment<1024> kSeg0 = buildSegment<1024>(0.0f,    SEG0_HI);
+ constexpr PwlSegment<256>  kSeg1 = buildSegment<256> (SEG0_HI, SEG1_HI);
+ constexpr PwlSegment<64>   kSeg2 = buildSegment<64>  (SEG1_HI, SEG2_HI);
+
+ static_assert(maxSegmentError(kSeg0) <= GAIN_LUT_MAX_ERR, "g(v) table [0,16) too coarse");
+ static_assert(maxSegmentError(kSeg1) <= GAIN_LUT_MAX_ERR, "g(v) table [16,128) too coarse");
+ static_assert(maxSegmentError(kSeg2) <= GAIN_LUT_MAX_ERR, "g(v) table [128,1024) too coarse");
+
+ } // namespace
+
+ float expShapeLut(float v)
+ {
+     if (v <= 0.0f)    return 0.0f;
+     if (v < SEG0_HI)  return evalSegment(kSeg0, v);
+     if (v < SEG1_HI)  return evalSegment(kSeg1, v);
+     if (v < SEG2_HI)  return evalSegment(kSeg2, v);
+     return 1.0f - 1.0f / v;
+ }
+
+ float expCurveLut(float x, float A, float K, float B, float C)
+ {
+     float denom = B * (x - C);
+     if (fabsf(denom) < 1e-9f) return A;
+
+     // x below C: exp(−1/denom) > 1, which the clamp below always maps to K
+     float v = (denom > 0.0f) ? A + (K - A) * expShapeLut(denom) : K;
+     if (v < A) v = A;
+     if (v > K) v = K;
+     return v;
+ }
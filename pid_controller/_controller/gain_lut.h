@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * File: gain_lut.h
+ * Brief: Table-driven gain schedule and filter-α curves.
+ *
+ *   Every curve in the controller has the same shape:
+ *       f(x) = A + (K − A) · g(B · (x − C)),   g(v) = exp(−1 / v)
+ *   so one piecewise-linear table of g(v), baked at compile time, serves
+ *   Kp/Ki/Kd (exp_control.cpp) and the adaptive filter α (filter.cpp).
+ *   Per lookup: one multiply for the index, one table interpolation,
+ *   no division and no expf.
+ *
+ *   Worst-case interpolation error (checked by static_assert in gain_lut.cpp):
+ *       |gLut(v) − g(v)| ≤ GAIN_LUT_MAX_ERR = 1e-4   for all v > 0
+ *   i.e. a scheduled gain is within 1e-4·|K − A| of the exact curve
+ *   (0.01 % of the Ki span with the current config).
+ */
+
+static constexpr float GAIN_LUT_MAX_ERR = 1.0e-4f;
+
+// g(v) = exp(−1/v) for v > 0 (returns 0 for v ≤ 0)
+float expShapeLut(float v);
+
+// Lookup equivalent of exp_control's expCurve():
+//   A + (K − A)·exp(−1/(B·(x − C))), clamped to [A, K]
+float expCurveLut(float x, float A, float K, float B, float C);
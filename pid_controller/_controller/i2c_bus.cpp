@@ -0,0 +1,175 @@
+/*
+ * File: i2c_bus.cpp
+ * Brief: Bus lock, device ranking and occupancy counters (see i2c_bus.h).
+ */
+
+ #include "i2c_bus.h"
+ #include "config.h"
+
+ #if defined(ARDUINO_ARCH_ESP32)
+ #include <freertos/FreeRTOS.h>
+ #include <freertos/semphr.h>
+
+ static SemaphoreHandle_t s_busLock = nullptr;
+ static void lockBus()   { xSemaphoreTake(s_busLock, portMAX_DELAY); }
+ static void unlockBus() { xSemaphoreGive(s_busLock); }
+ #else
+ // Host builds drive every device from one thread: nothing to lock
+ static void lockBus()   {}
+ static void unlockBus() {}
+ #endif
+
+ static const char *const I2C_DEVICE_NAMES[I2C_DEV_COUNT] = { "flow", "pump", "display" };
+
+ // Expected spacing of each device's transactions (0 = not periodic). Pump
+ // writes are at most one per control cycle, so this errs on the safe side.
+ static const uint32_t I2C_DEVICE_PERIOD_US[I2C_DEV_COUNT] = {
+     SCHED_TICK_US * SENSOR_DIVIDER,
+     SCHED_TICK_US * CONTROL_DIVIDER,
+     0
+ };
+
+ static MODULE_STATE I2cDeviceStats s_stats[I2C_DEV_COUNT];
+ static MODULE_STATE std::atomic<uint8_t>  s_waiting{0};                 // bit n = device n blocked in acquire
+ static MODULE_STATE std::atomic<uint32_t> s_lastStartUs[I2C_DEV_COUNT]; // read by lower-ranked devices
+ static MODULE_STATE std::atomic<bool>     s_started[I2C_DEV_COUNT];
+ static MODULE_STATE uint32_t s_holdStartUs[I2C_DEV_COUNT];
+ static MODULE_STATE uint32_t s_windowStartUs = 0;                      // start of the occupancy window
+
+ static void clearStats(I2cDeviceStats &st)
+ {
+     st.transactions = 0;
+     st.bytes        = 0;
+     st.busyUs       = 0;
+     st.maxHoldUs    = 0;
+     st.maxWaitUs    = 0;
+     st.deferred     = 0;
+ }
+
+ // Honours a pending reset; called by the device's own task only
+ static I2cDeviceStats &ownStats(uint8_t dev)
+ {
+     I2cDeviceStats &st = s_stats[dev];
+     if (st.resetRequested.exchange(false, std::memory_order_relaxed)) clearStats(st);
+     return st;
+ }
+
+ static void beginHold(uint8_t dev, uint32_t now, uint32_t waitUs)
+ {
+     I2cDeviceStats &st = ownStats(dev);
+     if (waitUs > st.maxWaitUs) st.maxWaitUs = waitUs;
+     s_holdStartUs[dev] = now;
+     s_lastStartUs[dev].store(now, std::memory_order_relaxed);
+     s_started[dev].store(true, std::memory_order_relaxed);
+ }
+
+ // True if a periodic device ranked above `dev` is due within `us`
+ static bool higherDueWithin(uint8_t dev, uint32_t now, uint32_t us)
+ {
+     for (uint8_t d = 0; d < dev; d++) {
+         uint32_t period = I2C_DEVICE_PERIOD_US[d];
+         if (!period || !s_started[d].load(std::memory_order_relaxed)) continue;
+         uint32_t since = now - s_lastStartUs[d].load(std::memory_order_relaxed);
+         if (period - since % period < us) return true;
+     }
+     return false;
+ }
+
+ void initI2cBus()
+ {
+ #if defined(ARDUINO_ARCH_ESP32)
+     if (!s_busLock) s_busLock = xSemaphoreCreateMutex();
+ #endif
+     for (uint8_t d = 0; d < I2C_DEV_COUNT; d++) {
+         clearStats(s_stats[d]);
+         s_stats[d].resetRequested.store(false, std::memory_order_relaxed);
+         s_started[d].store(false, std::memory_order_relaxed);
+     }
+     s_waiting.store(0, std::memory_order_relaxed);
+     s_windowStartUs = micros();
+ }
+
+ uint32_t i2cTransactionUs(uint16_t bytes)
+ {
+     // Start + address byte + payload (9 clocks per byte incl. ACK) + stop
+     uint32_t bits = 2 + 9 * (1 + (uint32_t)bytes);
+     return (uint32_t)(((uint64_t)bits * 1000000ULL + I2C_CLOCK_HZ - 1) / I2C_CLOCK_HZ);
+ }
+
+ void i2cBusAcquire(uint8_t dev)
+ {
+     uint32_t t0 = micros();
+     s_waiting.fetch_or((uint8_t)(1u << dev));
+     lockBus();
+     s_waiting.fetch_and((uint8_t)~(1u << dev));
+     uint32_t now = micros();
+     beginHold(dev, now, now - t0);
+ }
+
+ /*
+  * Waits at most for a transaction already on the bus, never for one that
+  * has not started: the request is refused if a higher-ranked device is
+  * waiting or due before this transaction (plus I2C_BUS_GUARD_US) ends.
+  */
+ bool i2cBusTryAcquire(uint8_t dev, uint16_t bytes)
+ {
+     uint8_t  higher = (uint8_t)((1u << dev) - 1u);
+     uint32_t t0     = micros();
+     if (!(s_waiting.load() & higher)) {
+         lockBus();
+         uint32_t now = micros();
+         if (!(s_waiting.load() & higher) &&
+             !higherDueWithin(dev, now, i2cTransactionUs(bytes) + I2C_BUS_GUARD_US)) {
+             beginHold(dev, now, now - t0);
+             return true;
+         }
+         unlockBus();
+     }
+     ownStats(dev).deferred++;
+     return false;
+ }
+
+ void i2cBusRelease(uint8_t dev, uint16_t bytes)
+ {
+     I2cDeviceStats &st = s_stats[dev];
+     uint32_t held = micros() - s_holdStartUs[dev];
+     st.transactions++;
+     st.bytes  += bytes;
+     st.busyUs += held;
+     if (held > st.maxHoldUs) st.maxHoldUs = held;
+     unlockBus();
+ }
+
+ const I2cDeviceStats &getI2cDeviceStats(uint8_t dev)
+ {
+     return s_stats[dev];
+ }
+
+ void resetI2cBusStats()
+ {
+     for (uint8_t d = 0; d < I2C_DEV_COUNT; d++)
+         s_stats[d].resetRequested.store(true, std::memory_order_relaxed);
+     s_windowStartUs = micros();
+ }
+
+ /*──────────────────────── SERIAL DUMP ────────────────────────────────────*/
+ void printI2cBusStats(Print &out)
+ {
+     uint32_t windowUs = micros() - s_windowStartUs;
+     out.print("[I2C] clockHz=");
+     out.print(I2C_CLOCK_HZ);
+     out.print(" windowMs=");
+     out.println(windowUs / 1000);
+
+     for (uint8_t d = 0; d < I2C_DEV_COUNT; d++) {
+         const I2cDeviceStats &st = s_stats[d];
+         out.print("[I2C] ");
+         out.print(I2C_DEVICE_NAMES[d]);
+         out.print(" n=");         out.print(st.transactions);
+         out.print(" bytes=");     out.print(st.bytes);
+         out.print(" busyPct=");   out.print(windowUs ? 100.0f * (float)st.busyUs / windowUs : 0.0f, 1);
+         out.print(" maxHoldUs="); out.print(st.maxHoldUs);
+         out.print(" maxWaitUs="); out.print(st.maxWaitUs);
+         out.print(" deferred=");  out.println(st.deferred);
+     }
+ }
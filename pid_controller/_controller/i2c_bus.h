@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+/*
+ * File: i2c_bus.h
+ * Brief: Arbitration of the shared I2C bus (flow sensor, pump driver,
+ *        display) by device priority, with per-device occupancy ('I').
+ *
+ *   Every transaction is bracketed by an acquire and i2cBusRelease().
+ *   Devices are ranked: flow sensor, then pump driver, then display. Each
+ *   is driven by one task only, and the task priorities follow the same
+ *   order (acquisition > control > I/O), so the bus lock, a FreeRTOS mutex,
+ *   hands the bus to the highest-ranked waiter and lends a low-ranked
+ *   holder its priority until it lets go.
+ *
+ *   Lower-ranked work must not delay a higher-ranked device. It uses
+ *   i2cBusTryAcquire(), which refuses the bus in two cases:
+ *     - a higher-ranked device is waiting;
+ *     - a periodic higher-ranked device (sensor read, control-cycle pump
+ *       write) is due before the transaction would end.
+ *   The display pushes its frame as such chunks, so at worst it delays
+ *   itself.
+ */
+
+enum {
+    I2C_DEV_FLOW = 0,    // SLF3S read, every sensor tick
+    I2C_DEV_PUMP,        // mp-Lowdriver writes, control cycle
+    I2C_DEV_DISPLAY,     // SSD1306 frame chunks
+    I2C_DEV_COUNT
+};
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;             // payload bytes (address byte not included)
+    uint64_t busyUs;            // time holding the bus
+    uint32_t maxHoldUs;
+    uint32_t maxWaitUs;         // longest wait for the bus
+    uint32_t deferred;          // i2cBusTryAcquire() refusals
+    std::atomic<bool> resetRequested;   // set by the dump side, honoured by the writer
+} I2cDeviceStats;
+
+// Creates the bus lock; call once after Wire.begin(), before the tasks start
+void initI2cBus();
+
+// Waits for the bus (higher-ranked waiters go first)
+void i2cBusAcquire(uint8_t dev);
+
+// Takes the bus for a `bytes`-byte transaction only if that cannot delay a
+// higher-ranked device; false = try again later
+bool i2cBusTryAcquire(uint8_t dev, uint16_t bytes);
+
+// Ends the transaction started by an acquire (`bytes` for the statistics)
+void i2cBusRelease(uint8_t dev, uint16_t bytes);
+
+// Bus time of a transaction with `bytes` payload bytes at I2C_CLOCK_HZ
+uint32_t i2cTransactionUs(uint16_t bytes);
+
+// Counters of one device
+const I2cDeviceStats &getI2cDeviceStats(uint8_t dev);
+
+// Prints per-device occupancy as [I2C] lines
+void printI2cBusStats(Print &out = Serial);
+
+// Clears all counters (each device's task clears its own on its next transaction)
+void resetI2cBusStats();
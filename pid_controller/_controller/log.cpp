@@ -0,0 +1,51 @@
+/*
+ * File: log.cpp
+ * Brief: Line formatting and per-task sinks for log.h.
+ */
+
+ #include "log.h"
+ #include <stdarg.h>
+ #include <stdio.h>
+
+ // Each task's sink; FreeRTOS tasks (and host threads) get their own copy
+ static thread_local Print *t_logSink = nullptr;
+
+ static const char *const LEVEL_NAMES[] = { "", "ERROR", "WARN", "INFO", "DEBUG" };
+
+ static const char *categoryName(uint8_t category)
+ {
+     switch (category) {
+         case LOG_CAT_MAIN:        return "MAIN";
+         case LOG_CAT_FILTER:      return "FILTER";
+         case LOG_CAT_EXP_CONTROL: return "EXP";
+         case LOG_CAT_BARTELS:     return "BARTELS";
+         case LOG_CAT_FLOW:        return "FLOW";
+         default:                  return "?";
+     }
+ }
+
+ void logAttachCurrentTask(Print &sink)
+ {
+     t_logSink = &sink;
+ }
+
+ void logWrite(uint8_t level, uint8_t category, const char *fmt, ...)
+ {
+     char line[LOG_LINE_MAX];
+     int  n = snprintf(line, sizeof line, "[%s %s] ", categoryName(category),
+                       level <= LOG_LEVEL_DEBUG ? LEVEL_NAMES[level] : "");
+
+     va_list ap;
+     va_start(ap, fmt);
+     if (n >= 0 && n < (int)sizeof line) {
+         int m = vsnprintf(line + n, sizeof line - n, fmt, ap);
+         n = (m < 0) ? n : n + m;
+     }
+     va_end(ap);
+     if (n > (int)sizeof line - 2) n = sizeof line - 2;   // cut, keep room for '\n'
+     line[n++] = '\n';
+
+     // One write: a TxBuffer commits (or drops) the whole line
+     Print &out = t_logSink ? *t_logSink : Serial;
+     out.write((const uint8_t *)line, n);
+ }
@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"      // LOG_LEVEL, LOG_CATEGORIES
+
+/*
+ * File: log.h
+ * Brief: Leveled, per-category logging that compiles away when disabled
+ *        and never blocks the task that logs.
+ *
+ *   LOG_DEBUG(LOG_CAT_MAIN, "x=%d", x) prints "[MAIN DEBUG] x=3". A call
+ *   above LOG_LEVEL is removed by the preprocessor (its arguments are not
+ *   evaluated); a category outside LOG_CATEGORIES is a constant-false
+ *   branch the compiler drops. With LOG_LEVEL 0 no format string reaches
+ *   the image.
+ *
+ *   An enabled call formats into a stack buffer and writes the line, as
+ *   one record, to the sink its task attached with logAttachCurrentTask()
+ *   (a TxBuffer on the target, drained by the I/O task). Tasks that never
+ *   attach (setup()) write to Serial directly, so the control path must
+ *   attach before it logs.
+ */
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#define LOG_CAT_MAIN        0x01
+#define LOG_CAT_FILTER      0x02
+#define LOG_CAT_EXP_CONTROL 0x04
+#define LOG_CAT_BARTELS     0x08
+#define LOG_CAT_FLOW        0x10
+
+// Sends this task's log lines to `sink` (call once at task start)
+void logAttachCurrentTask(Print &sink);
+
+// Formats and writes one line; use the LOG_* macros instead
+void logWrite(uint8_t level, uint8_t category, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define LOG_AT(level, cat, ...) \
+    do { if ((cat) & (LOG_CATEGORIES)) logWrite((level), (cat), __VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(cat, ...) LOG_AT(LOG_LEVEL_ERROR, cat, __VA_ARGS__)
+#else
+#define LOG_ERROR(cat, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(cat, ...)  LOG_AT(LOG_LEVEL_WARN, cat, __VA_ARGS__)
+#else
+#define LOG_WARN(cat, ...)  do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(cat, ...)  LOG_AT(LOG_LEVEL_INFO, cat, __VA_ARGS__)
+#else
+#define LOG_INFO(cat, ...)  do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(cat, ...) LOG_AT(LOG_LEVEL_DEBUG, cat, __VA_ARGS__)
+#else
+#define LOG_DEBUG(cat, ...) do {} while (0)
+#endif
@@ -8,24 +8,24 @@
  #include <Arduino.h>
  
  // PID gains
- static float Kp = 0.0f;
- static float Ki = 0.0f;
- static float Kd = 0.0f;
+ static MODULE_STATE float Kp = 0.0f;
+ static MODULE_STATE float Ki = 0.0f;
+ static MODULE_STATE float Kd = 0.0f;
  
  // Derivative filter
- static float derivFilterAlphaNormal = 0.0f;
- static float dErrorFilteredNormal   = 0.0f;
+ static MODULE_STATE float derivFilterAlphaNormal = 0.0f;
+ static MODULE_STATE float dErrorFilteredNormal   = 0.0f;
  
  // Exposed integrator term (extern in pid.h)
- float integralTerm = 0.0f;
+ MODULE_STATE float integralTerm = 0.0f;
  
  // Tracking variables for normal PID
- static float lastError         = 0.0f;
- static unsigned long lastTimeNormal = 0;
+ static MODULE_STATE float lastError         = 0.0f;
+ static MODULE_STATE unsigned long lastTimeNormal = 0;   // micros()
  
  // Externally referenced anti-windup data
- float g_lastIntegralIncrement = 0.0f;
- float g_lastErrorForAW        = 0.0f;
+ MODULE_STATE float g_lastIntegralIncrement = 0.0f;
+ MODULE_STATE float g_lastErrorForAW        = 0.0f;
  
  /*
   * Re-initializes PID states (integrator, derivative filter).
@@ -36,7 +36,7 @@
    dErrorFilteredNormal   = 0.0f;
    integralTerm           = 0.0f;
    lastError              = 0.0f;
-   lastTimeNormal         = millis();
+   lastTimeNormal         = micros();
    g_lastIntegralIncrement = 0.0f;
    g_lastErrorForAW        = 0.0f;
  }
@@ -59,8 +59,8 @@
                        float &iTermOut,
                        float &dTermOut)
  {
-   unsigned long now = millis();
-   float dt = (now - lastTimeNormal) / 1000.0f;
+   unsigned long now = micros();
+   float dt = (now - lastTimeNormal) / 1000000.0f;
    if (dt <= 0.0f) {
      dt = 0.001f;
    }
@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include "config.h"   // MODULE_STATE
 
 /*
  * File: pid.h
@@ -7,9 +8,9 @@
  */
 
 // Externally accessible PID integrator and anti-windup references
-extern float integralTerm;
-extern float g_lastIntegralIncrement;
-extern float g_lastErrorForAW;
+extern MODULE_STATE float integralTerm;
+extern MODULE_STATE float g_lastIntegralIncrement;
+extern MODULE_STATE float g_lastErrorForAW;
 
 // Initializes PID states (integrator, derivative filter, etc.)
 void initPID();
@@ -0,0 +1,88 @@
+/*
+ * File: profiler.cpp
+ * Brief: Stage statistics and the 'P' dump (see profiler.h).
+ */
+
+ #include "profiler.h"
+ #include "bench.h"       // benchCyclesPerUs(), benchClockName()
+
+ static const char *const PROF_STAGE_NAMES[PROF_STAGE_COUNT] = {
+     "sensor", "filter", "gains", "pid", "pump", "buttons", "telemetry", "display"
+ };
+
+ static MODULE_STATE ProfStage s_stages[PROF_STAGE_COUNT];
+
+ static uint8_t histBucket(uint32_t cycles)
+ {
+     uint8_t b = cycles ? (uint8_t)(32 - __builtin_clz(cycles)) : 0;
+     return b < PROF_HIST_BUCKETS ? b : PROF_HIST_BUCKETS - 1;
+ }
+
+ static void clearStage(ProfStage &st)
+ {
+     st.count       = 0;
+     st.minCycles   = UINT32_MAX;
+     st.maxCycles   = 0;
+     st.totalCycles = 0;
+     for (uint8_t b = 0; b < PROF_HIST_BUCKETS; b++) st.hist[b] = 0;
+ }
+
+ void profRecord(uint8_t stage, uint32_t cycles)
+ {
+     ProfStage &st = s_stages[stage];
+     if (st.resetRequested.exchange(false, std::memory_order_relaxed) || st.count == 0) clearStage(st);
+
+     st.count++;
+     st.totalCycles += cycles;
+     if (cycles < st.minCycles) st.minCycles = cycles;
+     if (cycles > st.maxCycles) st.maxCycles = cycles;
+     st.hist[histBucket(cycles)]++;
+ }
+
+ void resetProfile()
+ {
+     for (uint8_t i = 0; i < PROF_STAGE_COUNT; i++)
+         s_stages[i].resetRequested.store(true, std::memory_order_relaxed);
+ }
+
+ /*──────────────────────── SERIAL DUMP ────────────────────────────────────*/
+ void printProfile(Print &out)
+ {
+ #if !PROFILER_ENABLED
+     out.println("[PROF] disabled (PROFILER_ENABLED 0)");
+ #else
+     float perUs = benchCyclesPerUs();
+     out.print("[PROF] clock=");
+     out.print(benchClockName());
+     out.print(" cyclesPerUs=");
+     out.print(perUs, 1);
+     out.println(" histBuckets=log2(cycles)");
+
+     for (uint8_t i = 0; i < PROF_STAGE_COUNT; i++) {
+         const ProfStage &st = s_stages[i];
+         uint32_t n = st.count;
+         out.print("[PROF] ");
+         out.print(PROF_STAGE_NAMES[i]);
+         out.print(" n=");        out.print(n);
+         if (n) {
+             float mean = (float)st.totalCycles / n;
+             out.print(" min=");  out.print(st.minCycles);
+             out.print(" mean="); out.print(mean, 0);
+             out.print(" max=");  out.print(st.maxCycles);
+             out.print(" meanUs="); out.print(mean / perUs, 2);
+             out.print(" maxUs=");  out.print(st.maxCycles / perUs, 2);
+         }
+         out.println();
+
+         // Trailing empty buckets are left out
+         uint8_t last = 0;
+         for (uint8_t b = 0; b < PROF_HIST_BUCKETS; b++) if (st.hist[b]) last = b;
+         out.print("[PROF]   hist=[");
+         for (uint8_t b = 0; n && b <= last; b++) {
+             out.print(b ? "," : "");
+             out.print(st.hist[b]);
+         }
+         out.println("]");
+     }
+ #endif
+ }
@@ -0,0 +1,112 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"      // PROFILER_ENABLED
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(ARDUINO_ARCH_ESP32)
+#include <chrono>
+#endif
+
+/*
+ * File: profiler.h
+ * Brief: Per-stage cycle-count probes for the control and I/O paths, with
+ *        min / mean / max and log2 histograms (serial command 'P').
+ *
+ *   A stage is timed either by a scope (PROFILE_SCOPE) or, for consecutive
+ *   stages inside one function, by a ProfLap whose split() closes a stage
+ *   and opens the next with a single counter read. Each stage is recorded
+ *   by one task only, so recording is plain stores; the dump reads the
+ *   counters live (a value may be one update stale). Times include any
+ *   preemption on that core (the acquisition task preempts control).
+ *
+ *   With PROFILER_ENABLED 0 the probes compile to nothing.
+ */
+
+enum {
+    PROF_SENSOR = 0,     // acquisition: SLF3S read + decode
+    PROF_FILTER,         // control: two-pole error filter
+    PROF_GAINS,          // control: gain curves + integrator rescale
+    PROF_PID,            // control: PID update, clamp, voltage mapping
+    PROF_PUMP,           // control: pump driver I2C (serviceBartels)
+    PROF_BUTTONS,        // I/O
+    PROF_TELEMETRY,      // I/O
+    PROF_DISPLAY,        // I/O
+    PROF_STAGE_COUNT
+};
+
+// Histogram buckets: bucket 0 = 0 cycles, bucket b = [2^(b-1), 2^b) cycles,
+// the last one also holds everything longer
+static const uint8_t PROF_HIST_BUCKETS = 24;
+
+typedef struct {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint32_t hist[PROF_HIST_BUCKETS];
+    std::atomic<bool> resetRequested;   // set by the dump side, honoured by the writer
+} ProfStage;
+
+// CPU cycle counter (TSC on x86 hosts, ns elsewhere)
+static inline uint32_t profCycles()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Adds one sample of `cycles` to a stage
+void profRecord(uint8_t stage, uint32_t cycles);
+
+// Prints every stage (cycles and µs) as [PROF] lines
+void printProfile(Print &out = Serial);
+
+// Clears all stages (each writer clears its own on its next sample)
+void resetProfile();
+
+#if PROFILER_ENABLED
+
+class ProfScope {
+public:
+    explicit ProfScope(uint8_t stage) : stage_(stage), start_(profCycles()) {}
+    ~ProfScope() { profRecord(stage_, profCycles() - start_); }
+private:
+    uint8_t  stage_;
+    uint32_t start_;
+};
+
+class ProfLap {
+public:
+    ProfLap() : last_(profCycles()) {}
+    // Ends `stage` here; the next stage starts now
+    void split(uint8_t stage)
+    {
+        uint32_t now = profCycles();
+        profRecord(stage, now - last_);
+        last_ = now;
+    }
+private:
+    uint32_t last_;
+};
+
+#define PROF_CONCAT2(a, b) a##b
+#define PROF_CONCAT(a, b)  PROF_CONCAT2(a, b)
+#define PROFILE_SCOPE(stage) ProfScope PROF_CONCAT(profScope_, __LINE__)(stage)
+
+#else
+
+class ProfLap {
+public:
+    void split(uint8_t) {}
+};
+
+#define PROFILE_SCOPE(stage) do {} while (0)
+
+#endif
@@ -1,63 +1,137 @@
 #include "report.h"
 #include "system_state.h"
+#include "config.h"      // MODULE_STATE
+#include "telemetry.h"
+#include "flow_guard.h"  // FLOW_PATH_*
 #include <Arduino.h>
 
-void reportAllStateJSON(const SystemState &s)
+static MODULE_STATE uint16_t s_binarySeq = 0;
+
+// Key with its separator; the first key printed replaces the ',' by '{'
+static bool jsonKey(Print &out, uint32_t fields, uint8_t field, bool &first, const char *key)
+{
+  if (!((fields >> field) & 1)) return false;
+  out.print(first ? "{" : ",");
+  out.print(key);
+  first = false;
+  return true;
+}
+
+void reportStateJSON(const SystemState &s, uint32_t fields, Print &out)
 {
-  Serial.print("{\"timeMs\":");
-  Serial.print(s.currentTimeMs);
+  fields |= TELEMETRY_REQUIRED_FIELDS;
+  bool first = true;
 
-  Serial.print(",\"flow\":");
-  Serial.print(s.flow, 3);
+  if (jsonKey(out, fields, TLM_FIELD_TIME, first, "\"timeMs\":"))
+    out.print(s.currentTimeMs);
 
-  Serial.print(",\"setpt\":");
-  Serial.print(s.setpoint, 3);
+  if (jsonKey(out, fields, TLM_FIELD_FLOW, first, "\"flow\":"))
+    out.print(s.flow, 3);
 
-  Serial.print(",\"errorPct\":");
-  Serial.print(s.errorPercent, 3);
+  if (jsonKey(out, fields, TLM_FIELD_SETPT, first, "\"setpt\":"))
+    out.print(s.setpoint, 3);
 
-  Serial.print(",\"pidOut\":");
-  Serial.print(s.pidOutput, 3);
+  if (jsonKey(out, fields, TLM_FIELD_ERROR_PCT, first, "\"errorPct\":"))
+    out.print(s.errorPercent, 3);
 
-  Serial.print(",\"volt\":");
-  Serial.print(s.desiredVoltage, 2);
+  if (jsonKey(out, fields, TLM_FIELD_PID_OUT, first, "\"pidOut\":"))
+    out.print(s.pidOutput, 3);
 
-  Serial.print(",\"temp\":");
-  Serial.print(s.temperature, 2);
+  if (jsonKey(out, fields, TLM_FIELD_VOLT, first, "\"volt\":"))
+    out.print(s.desiredVoltage, 2);
 
-  Serial.print(",\"bubble\":");
-  Serial.print(s.bubbleDetected ? "true" : "false");
+  if (jsonKey(out, fields, TLM_FIELD_TEMP, first, "\"temp\":"))
+    out.print(s.temperature, 2);
 
-  Serial.print(",\"on\":");
-  Serial.print(s.systemOn ? "true" : "false");
+  if (jsonKey(out, fields, TLM_FIELD_BUBBLE, first, "\"bubble\":"))
+    out.print(s.bubbleDetected ? "true" : "false");
+
+  if (jsonKey(out, fields, TLM_FIELD_ON, first, "\"on\":"))
+    out.print(s.systemOn ? "true" : "false");
 
   // Indicate which mode we're in (optional)
-  Serial.print(",\"mode\":");
-  Serial.print(s.controlMode == CONTROL_MODE_EXP ? "\"SIG\"" : "\"CONST\"");
+  if (jsonKey(out, fields, TLM_FIELD_MODE, first, "\"mode\":"))
+    out.print(s.controlMode == CONTROL_MODE_EXP ? "\"SIG\"" : "\"CONST\"");
+
+  if (jsonKey(out, fields, TLM_FIELD_FLOW_HOLD, first, "\"flowHold\":"))
+    out.print(s.flowPath == FLOW_PATH_HOLDOVER ? "true" : "false");
+
+  if (jsonKey(out, fields, TLM_FIELD_FLOW_FAULT, first, "\"flowFault\":"))
+    out.print(s.flowPath == FLOW_PATH_FAULT ? "true" : "false");
+
+  if (jsonKey(out, fields, TLM_FIELD_P, first, "\"P\":"))
+    out.print(s.pTerm, 3);
+
+  if (jsonKey(out, fields, TLM_FIELD_I, first, "\"I\":"))
+    out.print(s.iTerm, 3);
+
+  if (jsonKey(out, fields, TLM_FIELD_D, first, "\"D\":"))
+    out.print(s.dTerm, 3);
+
+  if (jsonKey(out, fields, TLM_FIELD_P_GAIN, first, "\"pGain\":"))
+    out.print(s.pGain, 3);
+
+  if (jsonKey(out, fields, TLM_FIELD_I_GAIN, first, "\"iGain\":"))
+    out.print(s.iGain, 3);
+
+  if (jsonKey(out, fields, TLM_FIELD_D_GAIN, first, "\"dGain\":"))
+    out.print(s.dGain, 3);
+
+  if (jsonKey(out, fields, TLM_FIELD_FILTERED_ERR, first, "\"filteredErr\":"))
+    out.print(s.filteredError, 3);
 
-  Serial.print(",\"P\":");
-  Serial.print(s.pTerm, 3);
+  if (jsonKey(out, fields, TLM_FIELD_ALPHA, first, "\"currentAlpha\":"))
+    out.print(s.currentAlpha, 3);
 
-  Serial.print(",\"I\":");
-  Serial.print(s.iTerm, 3);
+  if (jsonKey(out, fields, TLM_FIELD_PUMP_TX, first, "\"pumpTx\":"))
+    out.print(s.pumpBusTxns);
 
-  Serial.print(",\"D\":");
-  Serial.print(s.dTerm, 3);
+  if (jsonKey(out, fields, TLM_FIELD_PUMP_BYTES, first, "\"pumpBytes\":"))
+    out.print(s.pumpBusBytes);
 
-  Serial.print(",\"pGain\":");
-  Serial.print(s.pGain, 3);
+  if (jsonKey(out, fields, TLM_FIELD_PUMP_STOP_FAIL, first, "\"pumpStopFail\":"))
+    out.print(s.pumpStopFailures);
 
-  Serial.print(",\"iGain\":");
-  Serial.print(s.iGain, 3);
+  if (jsonKey(out, fields, TLM_FIELD_CRC_ERR, first, "\"crcErr\":"))
+    out.print(s.flowCrcErrors);
 
-  Serial.print(",\"dGain\":");
-  Serial.print(s.dGain, 3);
+  if (jsonKey(out, fields, TLM_FIELD_SHORT_RD, first, "\"shortRd\":"))
+    out.print(s.flowShortReads);
 
-  Serial.print(",\"filteredErr\":");
-  Serial.print(s.filteredError, 3);
+  if (jsonKey(out, fields, TLM_FIELD_NACK, first, "\"nack\":"))
+    out.print(s.flowNacks);
 
-  Serial.print(",\"currentAlpha\":");
-  Serial.print(s.currentAlpha, 3);
+  if (jsonKey(out, fields, TLM_FIELD_OUTAGES, first, "\"outages\":"))
+    out.print(s.flowOutages);
 
-  Serial.println("}");
+  if (jsonKey(out, fields, TLM_FIELD_FAULTS, first, "\"faults\":"))
+    out.print(s.flowFaults);
+
+  if (jsonKey(out, fields, TLM_FIELD_OUTAGE_MS, first, "\"outageMs\":"))
+    out.print(s.flowOutageMs);
+
+  if (jsonKey(out, fields, TLM_FIELD_MAX_OUTAGE_MS, first, "\"maxOutageMs\":"))
+    out.print(s.flowMaxOutageMs);
+
+  if (jsonKey(out, fields, TLM_FIELD_TX_DROP, first, "\"txDrop\":"))
+    out.print(s.txDrops);
+
+  out.println("}");
+}
+
+void reportAllStateJSON(const SystemState &s, Print &out)
+{
+  reportStateJSON(s, TELEMETRY_ALL_FIELDS, out);
+}
+
+void reportStateBinary(const SystemState &s, uint32_t fields, Print &out)
+{
+  uint8_t frame[TELEMETRY_FRAME_SIZE];
+  size_t  len = encodeTelemetryFrame(s, s_binarySeq++, fields, frame);
+  out.write(frame, len);
+}
+
+void reportAllStateBinary(const SystemState &s, Print &out)
+{
+  reportStateBinary(s, TELEMETRY_ALL_FIELDS, out);
 }
@@ -1,4 +1,13 @@
 #pragma once
+#include <Arduino.h>
 #include "system_state.h"
 
-void reportAllStateJSON(const SystemState &s);
+// One JSON telemetry line (Serial unless another sink is given)
+void reportAllStateJSON(const SystemState &s, Print &out = Serial);
+
+// One binary telemetry frame (telemetry.h); numbers the frames itself
+void reportAllStateBinary(const SystemState &s, Print &out = Serial);
+
+// The same with only the fields in a TELEMETRY_FIELDS mask (timeMs always)
+void reportStateJSON(const SystemState &s, uint32_t fields, Print &out = Serial);
+void reportStateBinary(const SystemState &s, uint32_t fields, Print &out = Serial);
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * File: sample_ring.h
+ * Brief: Lock-free ring of timestamped samples: one producer, any number of
+ *        independent readers, no copies.
+ *
+ *   The producer fills the next slot in place and publishes it by bumping
+ *   the head index; it never waits for readers. Each reader owns a
+ *   RingCursor and walks the samples through pointers into the ring.
+ *   A reader that falls more than N samples behind is moved forward and the
+ *   lost samples are counted in its cursor. Size N so that N / sample rate
+ *   comfortably exceeds the slowest reader's period.
+ */
+
+// Per-reader position
+struct RingCursor {
+    uint32_t next;        // sequence number of the next unread sample
+    uint32_t overruns;    // samples lost because the reader fell behind
+};
+
+template <typename T, uint32_t N>
+class SampleRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    /*──────── producer side ────────*/
+
+    // Slot to fill in place; it becomes visible on publish()
+    T &writeSlot() { return buf_[head_.load(std::memory_order_relaxed) & (N - 1)]; }
+
+    void publish() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /*──────── reader side ──────────*/
+
+    // Total samples ever published
+    uint32_t head() const { return head_.load(std::memory_order_acquire); }
+
+    // Newest sample, or nullptr if nothing was published yet
+    const T *latest() const
+    {
+        uint32_t h = head();
+        return h ? &buf_[(h - 1) & (N - 1)] : nullptr;
+    }
+
+    // Starts a cursor at the current head (only new samples will be read)
+    void attach(RingCursor &c) const { c.next = head(); c.overruns = 0; }
+
+    /*
+     * Contiguous block of unread samples starting at the cursor (stops at the
+     * physical end of the ring; call again after consume() for the rest).
+     * Returns the sample count and points `first` at the oldest one.
+     */
+    uint32_t peek(RingCursor &c, const T *&first) const
+    {
+        uint32_t h = head();
+        if (h - c.next > N - 1) {             // lapped: skip to the oldest safe slot
+            c.overruns += (h - c.next) - (N - 1);
+            c.next      = h - (N - 1);
+        }
+        uint32_t avail  = h - c.next;
+        uint32_t idx    = c.next & (N - 1);
+        uint32_t toEnd  = N - idx;
+        first = &buf_[idx];
+        return avail < toEnd ? avail : toEnd;
+    }
+
+    // Marks `count` samples returned by peek() as read
+    void consume(RingCursor &c, uint32_t count) const { c.next += count; }
+
+    // Number of unread samples for this cursor (capped at the ring size)
+    uint32_t available(const RingCursor &c) const
+    {
+        uint32_t avail = head() - c.next;
+        return avail < N ? avail : N;
+    }
+
+private:
+    std::atomic<uint32_t> head_{0};
+    T buf_[N] = {};
+};
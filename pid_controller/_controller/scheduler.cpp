@@ -0,0 +1,190 @@
+/*
+ * File: scheduler.cpp
+ * Brief: Base-tick timer and per-task timing statistics.
+ *
+ * The esp_timer callback only bumps the tick counter and notifies the
+ * attached tasks; all task bodies run in those tasks' own contexts. Release
+ * times are computed from the tick index (not from when we woke up), so
+ * jitter measures the real start-time lateness against the ideal grid.
+ */
+
+ #include "scheduler.h"
+ #include <esp_timer.h>
+ #include <freertos/FreeRTOS.h>
+ #include <freertos/task.h>
+
+ static const uint8_t SCHED_MAX_WAITERS = 3;
+
+ typedef struct {
+     TaskHandle_t task;
+     uint16_t     divider;
+ } SchedWaiter;
+
+ // Attaching tasks fill a slot under the lock, then publish it through the
+ // count (release); the tick callback reads only published slots (acquire)
+ static esp_timer_handle_t   s_timer      = nullptr;
+ static SchedWaiter          s_waiters[SCHED_MAX_WAITERS];
+ static std::atomic<uint8_t> s_waiterCount{0};
+ static portMUX_TYPE         s_waiterLock = portMUX_INITIALIZER_UNLOCKED;
+ static uint32_t           s_tickUs     = 0;
+ static uint32_t           s_startUs    = 0;
+ static volatile uint32_t  s_tickCount  = 0;
+
+ static void IRAM_ATTR onSchedTick(void *)
+ {
+     uint32_t tick = ++s_tickCount;
+     uint8_t  n    = s_waiterCount.load(std::memory_order_acquire);
+     for (uint8_t i = 0; i < n; i++) {
+         if (tick % s_waiters[i].divider == 0) xTaskNotifyGive(s_waiters[i].task);
+     }
+ }
+
+ // log2 bucket index of a microsecond value
+ static uint8_t histBucket(uint32_t us)
+ {
+     uint8_t b = 0;
+     while (us && b < SCHED_HIST_BUCKETS - 1) { us >>= 1; b++; }
+     return b;
+ }
+
+ /*──────────────────────── BASE TICK ──────────────────────────────────────*/
+ bool initScheduler(uint32_t tickUs)
+ {
+     s_tickUs  = tickUs;
+
+     esp_timer_create_args_t args = {};
+     args.callback        = &onSchedTick;
+     args.dispatch_method = ESP_TIMER_TASK;
+     args.name            = "sched";
+     if (esp_timer_create(&args, &s_timer) != ESP_OK) return false;
+
+     s_tickCount = 0;
+     s_startUs   = (uint32_t)micros();
+     return esp_timer_start_periodic(s_timer, tickUs) == ESP_OK;
+ }
+
+ bool schedAttachCurrentTask(uint16_t tickDivider)
+ {
+     TaskHandle_t self = xTaskGetCurrentTaskHandle();
+     bool ok;
+
+     portENTER_CRITICAL(&s_waiterLock);
+     uint8_t n = s_waiterCount.load(std::memory_order_relaxed);
+     ok = n < SCHED_MAX_WAITERS;
+     if (ok) {
+         s_waiters[n].task    = self;
+         s_waiters[n].divider = tickDivider ? tickDivider : 1;
+         s_waiterCount.store(n + 1, std::memory_order_release);
+     }
+     portEXIT_CRITICAL(&s_waiterLock);
+     return ok;
+ }
+
+ uint32_t schedWaitTick()
+ {
+     ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+     return s_tickCount;
+ }
+
+ /*──────────────────────── PER-TASK STATS ─────────────────────────────────*/
+ static void clearStats(SchedTask &t)
+ {
+     t.runs           = 0;
+     t.skipped        = 0;
+     t.deadlineMisses = 0;
+     t.maxJitterUs    = 0;
+     t.maxExecUs      = 0;
+     for (uint8_t b = 0; b < SCHED_HIST_BUCKETS; b++) {
+         t.jitterHist[b] = 0;
+         t.missHist[b]   = 0;
+     }
+ }
+
+ void initSchedTask(SchedTask &t, const char *name, uint16_t divider)
+ {
+     t.name        = name;
+     t.divider     = divider ? divider : 1;
+     t.lastRelease = 0;
+     t.started     = false;
+     clearStats(t);
+     t.resetRequested.store(false, std::memory_order_relaxed);
+ }
+
+ bool schedTaskDue(SchedTask &t, uint32_t tick)
+ {
+     if (t.resetRequested.exchange(false, std::memory_order_relaxed)) clearStats(t);
+
+     uint32_t release = tick / t.divider;
+     if (t.started && release == t.lastRelease) return false;
+
+     if (t.started && release - t.lastRelease > 1) {
+         t.skipped += release - t.lastRelease - 1;
+     }
+     t.lastRelease = release;
+     t.started     = true;
+     return true;
+ }
+
+ uint32_t schedTaskBegin(SchedTask &t)
+ {
+     uint32_t now       = (uint32_t)micros();
+     uint32_t releaseUs = s_startUs + t.lastRelease * t.divider * s_tickUs;
+     uint32_t jitter    = (int32_t)(now - releaseUs) > 0 ? now - releaseUs : 0;
+
+     t.runs++;
+     t.jitterHist[histBucket(jitter)]++;
+     if (jitter > t.maxJitterUs) t.maxJitterUs = jitter;
+     return now;
+ }
+
+ void schedTaskEnd(SchedTask &t, uint32_t startUs)
+ {
+     uint32_t now        = (uint32_t)micros();
+     uint32_t exec       = now - startUs;
+     uint32_t deadlineUs = s_startUs + (t.lastRelease + 1) * t.divider * s_tickUs;
+
+     if (exec > t.maxExecUs) t.maxExecUs = exec;
+     if ((int32_t)(now - deadlineUs) > 0) {
+         t.deadlineMisses++;
+         t.missHist[histBucket(now - deadlineUs)]++;
+     }
+ }
+
+ /*──────────────────────── SERIAL DUMP ────────────────────────────────────*/
+ static void printHist(Print &out, const char *label, const uint32_t *hist)
+ {
+     out.print(label);
+     for (uint8_t b = 0; b < SCHED_HIST_BUCKETS; b++) {
+         out.print(b ? "," : "");
+         out.print(hist[b]);
+     }
+     out.println("]");
+ }
+
+ void printSchedStats(const SchedTask *tasks, uint8_t count, Print &out)
+ {
+     out.print("[SCHED] tickUs=");
+     out.print(s_tickUs);
+     out.println(" histBuckets=log2(us)");
+
+     for (uint8_t i = 0; i < count; i++) {
+         const SchedTask &t = tasks[i];
+         out.print("[SCHED] ");
+         out.print(t.name);
+         out.print(" periodUs=");   out.print((uint32_t)t.divider * s_tickUs);
+         out.print(" runs=");       out.print(t.runs);
+         out.print(" skipped=");    out.print(t.skipped);
+         out.print(" misses=");     out.print(t.deadlineMisses);
+         out.print(" maxJitterUs=");out.print(t.maxJitterUs);
+         out.print(" maxExecUs=");  out.println(t.maxExecUs);
+         printHist(out, "[SCHED]   jitter=[", t.jitterHist);
+         printHist(out, "[SCHED]   miss=[",   t.missHist);
+     }
+ }
+
+ void resetSchedStats(SchedTask *tasks, uint8_t count)
+ {
+     for (uint8_t i = 0; i < count; i++) {
+         tasks[i].resetRequested.store(true, std::memory_order_relaxed);
+     }
+ }
@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+/*
+ * File: scheduler.h
+ * Brief: Fixed-rate scheduler paced by a hardware timer (esp_timer).
+ *        Every periodic activity runs on an integer multiple of one base
+ *        tick, and records its release jitter and deadline misses.
+ *        Several FreeRTOS tasks can share the same tick.
+ */
+
+// Histogram buckets: bucket 0 = 0 us, bucket b = [2^(b-1), 2^b) us
+static const uint8_t SCHED_HIST_BUCKETS = 16;
+
+/*──────── One periodic activity ────────*/
+typedef struct {
+    const char *name;
+    uint16_t    divider;          // runs every `divider` base ticks
+    uint32_t    lastRelease;      // release index of the last run
+    bool        started;
+
+    uint32_t    runs;
+    uint32_t    skipped;          // releases dropped because we were late
+    uint32_t    deadlineMisses;   // runs that finished after the next release
+    uint32_t    maxJitterUs;      // worst start-time lateness
+    uint32_t    maxExecUs;        // worst execution time
+    uint32_t    jitterHist[SCHED_HIST_BUCKETS];
+    uint32_t    missHist[SCHED_HIST_BUCKETS];   // overrun past deadline
+    std::atomic<bool> resetRequested;   // set by resetSchedStats(), honoured by the owning task
+} SchedTask;
+
+// Starts the base-tick timer
+bool     initScheduler(uint32_t tickUs);
+
+// Registers the calling task to be woken every `tickDivider` base ticks.
+// Task dividers used by that task should be multiples of tickDivider.
+// Safe to call from several tasks while the timer runs.
+bool     schedAttachCurrentTask(uint16_t tickDivider);
+
+// Blocks the calling (attached) task until its next tick; returns the tick index
+uint32_t schedWaitTick();
+
+// Prepares a task descriptor
+void     initSchedTask(SchedTask &t, const char *name, uint16_t divider);
+
+// True if the task has a release due at this tick (skipped releases are counted)
+bool     schedTaskDue(SchedTask &t, uint32_t tick);
+
+// Bracket a task body; record jitter, execution time and deadline misses
+uint32_t schedTaskBegin(SchedTask &t);
+void     schedTaskEnd  (SchedTask &t, uint32_t startUs);
+
+// Prints per-task statistics (to Serial unless another sink is given), or
+// has them cleared by each task on its next release (any task may call this)
+void     printSchedStats(const SchedTask *tasks, uint8_t count, Print &out = Serial);
+void     resetSchedStats(SchedTask *tasks, uint8_t count);
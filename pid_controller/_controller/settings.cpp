@@ -0,0 +1,129 @@
+/*
+ * File: settings.cpp
+ * Brief: Settings journal in the emulated EEPROM (see settings.h).
+ */
+
+ #include "settings.h"
+ #include "config.h"
+ #include "crc.h"
+ #include "system_state.h"
+ #include <Arduino.h>
+ #include <EEPROM.h>
+ #include <string.h>
+
+ // One journal slot as stored (16 bytes)
+ typedef struct __attribute__((packed)) {
+     uint32_t seq;           // increments with every commit; erased = 0xFFFFFFFF
+     float    setpoint;
+     float    errorPercent;
+     uint8_t  controlMode;
+     uint8_t  gainSet;
+     uint16_t crc;           // CRC-16/CCITT over everything before it
+ } SettingsRecord;
+
+ static_assert(sizeof(SettingsRecord) == 16, "settings record layout changed");
+ static_assert(SETTINGS_SLOTS * sizeof(SettingsRecord) <= SETTINGS_EEPROM_SIZE,
+               "settings journal does not fit in the EEPROM area");
+
+ // Before the journal: error % at 0 and setpoint at 4 (read once to migrate)
+ static const int LEGACY_ADDR_ERROR    = 0;
+ static const int LEGACY_ADDR_SETPOINT = 4;
+
+ static MODULE_STATE Settings      s_current;
+ static MODULE_STATE uint32_t      s_lastSeq      = 0;
+ static MODULE_STATE uint8_t       s_nextSlot     = 0;
+ static MODULE_STATE bool          s_dirty        = false;
+ static MODULE_STATE unsigned long s_lastChangeMs = 0;
+ static MODULE_STATE bool          s_wasOn        = false;
+
+ static uint16_t recordCrc(const SettingsRecord &r)
+ {
+     return crc16Ccitt((const uint8_t *)&r, offsetof(SettingsRecord, crc));
+ }
+
+ // Out-of-range values (an older firmware, a bad record) fall back to defaults
+ static void sanitize(Settings &s)
+ {
+     if (!(s.errorPercent >= ERROR_PERCENT_MIN && s.errorPercent <= ERROR_PERCENT_MAX)) {
+         s.errorPercent = 0.0f;
+     }
+     if (!(s.setpoint >= FLOW_SP_MIN && s.setpoint <= FLOW_SP_MAX)) {
+         s.setpoint = (FLOW_SP_MIN + FLOW_SP_MAX) * 0.5f;
+     }
+     if (s.controlMode > CONTROL_MODE_CONST_VOLTAGE) s.controlMode = CONTROL_MODE_EXP;
+     s.gainSet = 0;
+ }
+
+ bool initSettings()
+ {
+     s_dirty = false;
+     s_wasOn = false;
+
+     bool found = false;
+     for (uint8_t slot = 0; slot < SETTINGS_SLOTS; slot++) {
+         SettingsRecord r;
+         EEPROM.get(slot * sizeof(SettingsRecord), r);
+         if (r.seq == 0xFFFFFFFFu || r.crc != recordCrc(r)) continue;
+         if (found && (int32_t)(r.seq - s_lastSeq) <= 0) continue;
+
+         found      = true;
+         s_lastSeq  = r.seq;
+         s_nextSlot = (uint8_t)((slot + 1) % SETTINGS_SLOTS);
+         s_current.setpoint     = r.setpoint;
+         s_current.errorPercent = r.errorPercent;
+         s_current.controlMode  = r.controlMode;
+         s_current.gainSet      = r.gainSet;
+     }
+
+     if (!found) {
+         // No journal yet: keep what the old layout stored, if anything
+         EEPROM.get(LEGACY_ADDR_ERROR,    s_current.errorPercent);
+         EEPROM.get(LEGACY_ADDR_SETPOINT, s_current.setpoint);
+         s_current.controlMode = CONTROL_MODE_EXP;
+         s_current.gainSet     = 0;
+         s_lastSeq  = 0;
+         s_nextSlot = 0;
+     }
+     sanitize(s_current);
+     return found;
+ }
+
+ const Settings &currentSettings()
+ {
+     return s_current;
+ }
+
+ void changeSettings(const Settings &s)
+ {
+     if (memcmp(&s, &s_current, sizeof(Settings)) == 0) return;
+     s_current      = s;
+     s_dirty        = true;
+     s_lastChangeMs = millis();
+ }
+
+ // Writes the current settings into the next slot and commits
+ static void commitSettings()
+ {
+     SettingsRecord r;
+     memset(&r, 0, sizeof r);
+     r.seq          = ++s_lastSeq;
+     r.setpoint     = s_current.setpoint;
+     r.errorPercent = s_current.errorPercent;
+     r.controlMode  = s_current.controlMode;
+     r.gainSet      = s_current.gainSet;
+     r.crc          = recordCrc(r);
+
+     EEPROM.put(s_nextSlot * sizeof(SettingsRecord), r);
+     EEPROM.commit();
+     s_nextSlot = (uint8_t)((s_nextSlot + 1) % SETTINGS_SLOTS);
+     s_dirty    = false;
+ }
+
+ void serviceSettings(bool systemOn)
+ {
+     bool switchedOff = s_wasOn && !systemOn;
+     s_wasOn = systemOn;
+
+     if (!s_dirty) return;
+     if (switchedOff || millis() - s_lastChangeMs >= SETTINGS_QUIET_MS) commitSettings();
+ }
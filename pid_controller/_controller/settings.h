@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * File: settings.h
+ * Brief: Operator settings kept across power cycles: a journal of
+ *        CRC-checked, sequence-numbered records in the emulated EEPROM.
+ *
+ *   Each commit writes the next of SETTINGS_SLOTS slots, so the slots wear
+ *   evenly and a commit cut short by a power loss leaves the previous
+ *   record valid. At boot the newest record that passes its CRC is used.
+ *
+ *   Changes are held in RAM and committed by serviceSettings() once they
+ *   have been quiet for SETTINGS_QUIET_MS, or when the system switches
+ *   off. On the ESP32 a commit is a flash write that stalls both cores
+ *   for a few milliseconds, so it must not happen on every button step.
+ *   All calls come from the I/O task (setup() for initSettings()).
+ */
+
+typedef struct {
+    float   setpoint;       // mL/min
+    float   errorPercent;
+    uint8_t controlMode;    // ControlMode (system_state.h)
+    uint8_t gainSet;        // reserved: one gain schedule exists, always 0
+} Settings;
+
+// Loads the newest valid record (call after EEPROM.begin(SETTINGS_EEPROM_SIZE));
+// false if there is none and the defaults are used
+bool initSettings();
+
+// Settings as loaded or last changed
+const Settings &currentSettings();
+
+// Takes new settings; they are committed later by serviceSettings()
+void changeSettings(const Settings &s);
+
+// Commits pending changes when they have been quiet long enough or the
+// system has just switched off; call periodically from the I/O task
+void serviceSettings(bool systemOn);
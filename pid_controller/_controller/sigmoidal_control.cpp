@@ -9,11 +9,12 @@
  #include "filter.h"
  #include "pid.h"
  #include "bartels.h"
+ #include "log.h"
  #include <Arduino.h>
  
  // External PID integrator variables (declared in pid.cpp)
- extern float integralTerm;
- extern float g_lastIntegralIncrement;
+ extern MODULE_STATE float integralTerm;
+ extern MODULE_STATE float g_lastIntegralIncrement;
  
  // Stores the previous Ki to rescale integrator if Ki changes significantly
  static float s_lastKi = 0.0f;
@@ -46,8 +47,7 @@
      // For optional smoothed error logging
      g_errSmooth = 0.0f;
  
-     // Debug
-     Serial.println("[SIGMOIDAL] initSigmoidalController() -> PID + filter reset");
+     LOG_DEBUG(LOG_CAT_EXP_CONTROL, "initSigmoidalController() -> PID + filter reset");
  }
  
  /**
@@ -74,7 +74,7 @@
  {
      // If system is OFF, don't run PID
      if (!systemOn) {
-         Serial.println("[DEBUG] systemOn=false => skipping PID calculations");
+         LOG_DEBUG(LOG_CAT_EXP_CONTROL, "systemOn=false => skipping PID calculations");
          stopPump();
          pidFraction    = 0.0f;
          desiredVoltage = 0.0f;
@@ -100,28 +100,17 @@
      float ki = getSigmoidKi(absE);
      float kd = getSigmoidKd(absE);
  
-     // Optional debug: see old vs new Ki
-     Serial.print("[DEBUG] oldKi=");
-     Serial.print(s_lastKi, 6);
-     Serial.print(", newKi=");
-     Serial.print(ki, 6);
- 
      // Rescale integrator if Ki changed significantly
      if (fabs(s_lastKi - ki) > 1e-9) {
-         Serial.print(" -> Ki changed, rescaling integrator. Ratio=");
          if (fabs(s_lastKi) > 1e-9 && fabs(ki) > 1e-9) {
              float ratio = s_lastKi / ki;
              integralTerm *= ratio;
-             Serial.print(ratio, 6);
-             Serial.print(", integralTerm=");
-             Serial.print(integralTerm, 6);
+             LOG_DEBUG(LOG_CAT_EXP_CONTROL, "oldKi=%.6f, newKi=%.6f -> rescaling integrator. Ratio=%.6f, integralTerm=%.6f",
+                       s_lastKi, ki, ratio, integralTerm);
          } else {
-             Serial.print(" (skipped because Ki or s_lastKi=0?)");
+             LOG_DEBUG(LOG_CAT_EXP_CONTROL, "oldKi=%.6f, newKi=%.6f (rescale skipped, a Ki is 0)", s_lastKi, ki);
          }
-         Serial.println();
          s_lastKi = ki;
-     } else {
-         Serial.println(" (no significant change)");
      }
  
      // Apply new gains to PID
@@ -159,12 +148,7 @@
      // Command the pump hardware
      runSequence(desiredVoltage);
  
-     // Optional debug: final integrator after this loop
-     Serial.print("[DEBUG] PID loop done. integralTerm=");
-     Serial.print(integralTerm, 6);
-     Serial.print(", pidFraction=");
-     Serial.print(pidFraction, 6);
-     Serial.print(", desiredVoltage=");
-     Serial.println(desiredVoltage, 6);
+     LOG_DEBUG(LOG_CAT_EXP_CONTROL, "PID loop done. integralTerm=%.6f, pidFraction=%.6f, desiredVoltage=%.6f",
+               integralTerm, pidFraction, desiredVoltage);
  }
  
\ No newline at end of file
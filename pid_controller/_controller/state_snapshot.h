@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <string.h>
+
+/*
+ * File: state_snapshot.h
+ * Brief: Lock-free single-writer snapshot (seqlock) for handing a plain
+ *        struct from one core to the other.
+ *
+ *   Writer never waits. A reader copies the struct and retries if the
+ *   sequence number moved (or was odd) while it was copying, so it only
+ *   ever spins for the length of one memcpy on the other core.
+ */
+
+template <typename T>
+class SeqlockSnapshot {
+public:
+    // Single writer only
+    void publish(const T &value)
+    {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);      // odd = writing
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(data_, &value, sizeof(T));
+        seq_.store(seq + 2, std::memory_order_release);      // even = stable
+    }
+
+    // Any number of readers; returns the number of retries needed
+    uint32_t read(T &out) const
+    {
+        uint32_t retries = 0;
+        for (;;) {
+            uint32_t before = seq_.load(std::memory_order_acquire);
+            if ((before & 1u) == 0) {
+                memcpy(&out, data_, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq_.load(std::memory_order_relaxed) == before) return retries;
+            }
+            retries++;
+        }
+    }
+
+    // Increments on every publish (useful to detect "nothing new")
+    uint32_t version() const { return seq_.load(std::memory_order_acquire) >> 1; }
+
+private:
+    std::atomic<uint32_t> seq_{0};
+    alignas(alignof(T)) unsigned char data_[sizeof(T)] = {};
+};
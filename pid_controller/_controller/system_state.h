@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 // Forward-declare any enums if needed:
 enum ControlMode {
@@ -41,4 +42,24 @@ struct SystemState {
   // --- Filtered signals ---
   float filteredError;
   float currentAlpha;
+
+  // --- Pump driver bus cost (most recent update) ---
+  uint16_t pumpBusTxns;
+  uint16_t pumpBusBytes;
+  uint32_t pumpStopFailures;  // stops the driver did not acknowledge (running total)
+
+  // --- Flow sensor link health (running totals) ---
+  uint32_t flowCrcErrors;
+  uint32_t flowShortReads;
+  uint32_t flowNacks;
+
+  // --- Flow path outages (flow_guard.h) ---
+  uint8_t  flowPath;          // FLOW_PATH_*
+  uint32_t flowOutages;
+  uint32_t flowFaults;        // outages that outlasted FLOW_HOLDOVER_MS
+  uint32_t flowOutageMs;      // current outage so far, 0 = none
+  uint32_t flowMaxOutageMs;
+
+  // --- Serial output records dropped on a full buffer (I/O task fills in) ---
+  uint32_t txDrops;
 };
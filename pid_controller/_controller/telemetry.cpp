@@ -0,0 +1,272 @@
+/*
+ * File: telemetry.cpp
+ * Brief: Binary telemetry record, CRC-16 and COBS framing (see telemetry.h).
+ */
+
+ #include "telemetry.h"
+ #include "crc.h"
+ #include "flow_guard.h"   // FLOW_PATH_*
+ #include <string.h>
+ #include <math.h>
+
+ /*──────────────────────── HALF FLOATS ────────────────────────────────────*/
+ uint16_t floatToHalf(float v)
+ {
+     uint32_t x;
+     memcpy(&x, &v, sizeof x);
+     uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+     uint32_t e8   = (x >> 23) & 0xFF;
+     uint32_t mant = x & 0x7FFFFF;
+
+     if (e8 == 0xFF) return (uint16_t)(sign | 0x7C00 | (mant ? 0x200 : 0));   // inf / NaN
+     int32_t e5 = (int32_t)e8 - 127 + 15;
+     if (e5 >= 31) return (uint16_t)(sign | 0x7C00);                          // overflow → inf
+     if (e5 <= 0)  return sign;                                               // flush to zero
+
+     uint32_t h    = ((uint32_t)e5 << 10) | (mant >> 13);
+     uint32_t rest = mant & 0x1FFF;
+     if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) h++;   // nearest even; may carry into exp
+     return (uint16_t)(sign | h);
+ }
+
+ float halfToFloat(uint16_t h)
+ {
+     uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+     uint32_t e5   = (h >> 10) & 0x1F;
+     uint32_t mant = h & 0x3FF;
+
+     if (e5 == 0) {
+         float v = ldexpf((float)mant, -24);                  // zero / subnormal
+         return sign ? -v : v;
+     }
+     uint32_t x = (e5 == 31) ? (sign | 0x7F800000 | (mant << 13))
+                             : (sign | ((e5 - 15 + 127) << 23) | (mant << 13));
+     float v;
+     memcpy(&v, &x, sizeof v);
+     return v;
+ }
+
+ /*──────────────────────── RECORD ─────────────────────────────────────────*/
+ // Writes fields in TELEMETRY_FIELDS order; the table supplies type and scale,
+ // the mask says which are present
+ typedef struct {
+     uint8_t *p;
+     uint8_t  field;
+     uint32_t fields;
+     uint8_t *flags;
+ } TlmWriter;
+
+ // Next field in table order, or nullptr if it is not in the mask
+ static const TelemetryField *nextField(TlmWriter &w)
+ {
+     uint8_t i = w.field++;
+     return ((w.fields >> i) & 1) ? &TELEMETRY_FIELDS[i] : nullptr;
+ }
+
+ static void put16(TlmWriter &w, uint16_t v) { w.p[0] = (uint8_t)v; w.p[1] = (uint8_t)(v >> 8); w.p += 2; }
+
+ static void put32(TlmWriter &w, uint32_t v)
+ {
+     for (uint8_t i = 0; i < 4; i++) w.p[i] = (uint8_t)(v >> (8 * i));
+     w.p += 4;
+ }
+
+ static int32_t scaled(float v, float scale, int32_t lo, int32_t hi)
+ {
+     float s = v * scale;
+     if (!(s > (float)lo)) return lo;             // also catches NaN
+     if (s >= (float)hi)   return hi;
+     return (int32_t)(s + (s >= 0.0f ? 0.5f : -0.5f));
+ }
+
+ // Physical value, scaled and rounded to the field's integer type or half
+ static void putValue(TlmWriter &w, float v)
+ {
+     const TelemetryField *pf = nextField(w);
+     if (!pf) return;
+     const TelemetryField &f = *pf;
+     switch (f.type) {
+         case TLM_U8:  *w.p++ = (uint8_t)scaled(v, f.scale, 0, 255);              break;
+         case TLM_U16: put16(w, (uint16_t)scaled(v, f.scale, 0, 65535));           break;
+         case TLM_I16: put16(w, (uint16_t)(int16_t)scaled(v, f.scale, -32768, 32767)); break;
+         case TLM_F16: put16(w, floatToHalf(v));                                   break;
+         default:      put32(w, (uint32_t)scaled(v, f.scale, 0, 0x7FFFFFFF));      break;
+     }
+ }
+
+ // Exact integer (sequence, time, counters)
+ static void putCount(TlmWriter &w, uint32_t v)
+ {
+     const TelemetryField *f = nextField(w);
+     if (!f) return;
+     if (f->type == TLM_U32)      put32(w, v);
+     else if (f->type == TLM_U8)  *w.p++ = (uint8_t)v;
+     else                         put16(w, (uint16_t)v);
+ }
+
+ // The flags byte is allocated by the first present bit of its group
+ static void putBit(TlmWriter &w, bool b)
+ {
+     if (TELEMETRY_FIELDS[w.field].bit == 0) w.flags = nullptr;
+     const TelemetryField *f = nextField(w);
+     if (!f) return;
+     if (!w.flags) { w.flags = w.p++; *w.flags = 0; }
+     if (b) *w.flags |= (uint8_t)(1u << f->bit);
+ }
+
+ size_t encodeTelemetryRecord(const SystemState &s, uint16_t seq, uint32_t fields, uint8_t *record)
+ {
+     fields = (fields | TELEMETRY_REQUIRED_FIELDS) & TELEMETRY_ALL_FIELDS;
+     TlmWriter w = { record, 0, fields, nullptr };
+     *w.p++ = TELEMETRY_VERSION;
+     put32(w, fields);
+
+     putCount(w, seq);
+     putCount(w, (uint32_t)s.currentTimeMs);
+     putValue(w, s.flow);
+     putValue(w, s.setpoint);
+     putValue(w, s.errorPercent);
+     putValue(w, s.pidOutput);
+     putValue(w, s.desiredVoltage);
+     putValue(w, s.temperature);
+     putBit  (w, s.bubbleDetected);
+     putBit  (w, s.systemOn);
+     putBit  (w, s.controlMode != CONTROL_MODE_EXP);
+     putBit  (w, s.flowPath == FLOW_PATH_HOLDOVER);
+     putBit  (w, s.flowPath == FLOW_PATH_FAULT);
+     putValue(w, s.pTerm);
+     putValue(w, s.iTerm);
+     putValue(w, s.dTerm);
+     putValue(w, s.pGain);
+     putValue(w, s.iGain);
+     putValue(w, s.dGain);
+     putValue(w, s.filteredError);
+     putValue(w, s.currentAlpha);
+     putCount(w, s.pumpBusTxns);
+     putCount(w, s.pumpBusBytes);
+     putCount(w, s.pumpStopFailures < 0xFFFF ? s.pumpStopFailures : 0xFFFF);
+     putCount(w, s.flowCrcErrors);
+     putCount(w, s.flowShortReads);
+     putCount(w, s.flowNacks);
+     putCount(w, s.flowOutages);
+     putCount(w, s.flowFaults);
+     putCount(w, s.flowOutageMs    < 0xFFFF ? s.flowOutageMs    : 0xFFFF);
+     putCount(w, s.flowMaxOutageMs < 0xFFFF ? s.flowMaxOutageMs : 0xFFFF);
+     putCount(w, s.txDrops);
+
+     return (size_t)(w.p - record);
+ }
+
+ /*──────────────────────── FRAMING ────────────────────────────────────────*/
+ size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out)
+ {
+     size_t  codeAt = 0, o = 1;
+     uint8_t code   = 1;
+     for (size_t i = 0; i < len; i++) {
+         if (in[i] == 0) {
+             out[codeAt] = code;
+             codeAt = o++;
+             code   = 1;
+         } else {
+             out[o++] = in[i];
+             if (++code == 0xFF) {
+                 out[codeAt] = code;
+                 codeAt = o++;
+                 code   = 1;
+             }
+         }
+     }
+     out[codeAt] = code;
+     return o;
+ }
+
+ size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out)
+ {
+     size_t i = 0, o = 0;
+     while (i < len) {
+         uint8_t code = in[i++];
+         if (code == 0 || i + code - 1 > len) return 0;
+         for (uint8_t k = 1; k < code; k++) {
+             if (in[i] == 0) return 0;
+             out[o++] = in[i++];
+         }
+         if (code != 0xFF && i < len) out[o++] = 0;
+     }
+     return o;
+ }
+
+ size_t encodeTelemetryFrame(const SystemState &s, uint16_t seq, uint32_t fields, uint8_t *frame)
+ {
+     uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+     size_t  n   = encodeTelemetryRecord(s, seq, fields, payload);
+     uint16_t crc = crc16Ccitt(payload, n);
+     payload[n++] = (uint8_t)crc;
+     payload[n++] = (uint8_t)(crc >> 8);
+
+     size_t len = cobsEncode(payload, n, frame);
+     frame[len++] = 0x00;
+     return len;
+ }
+
+ /*──────────────────────── SUBSCRIPTIONS ──────────────────────────────────*/
+ int telemetryFieldIndex(const char *name)
+ {
+     for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++)
+         if (!strcmp(TELEMETRY_FIELDS[i].name, name)) return i;
+     return -1;
+ }
+
+ void subscribeAllTelemetry(TelemetrySubscription &sub, uint16_t divisor)
+ {
+     for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) sub.divisor[i] = divisor;
+ }
+
+ bool parseTelemetrySubscription(const char *list, TelemetrySubscription &sub,
+                                 const char **errorAt)
+ {
+     TelemetrySubscription next;
+     subscribeAllTelemetry(next, 0);
+
+     const char *p = list;
+     while (*p) {
+         const char *item = p;
+         char name[16];
+         uint8_t len = 0;
+         while (*p && *p != ':' && *p != ',') {
+             if (len + 1u >= sizeof name) { if (errorAt) *errorAt = item; return false; }
+             name[len++] = *p++;
+         }
+         name[len] = '\0';
+
+         uint32_t divisor = 1;
+         if (*p == ':') {
+             p++;
+             if (*p < '0' || *p > '9') { if (errorAt) *errorAt = item; return false; }
+             divisor = 0;
+             while (*p >= '0' && *p <= '9' && divisor <= 65535) divisor = divisor * 10 + (uint32_t)(*p++ - '0');
+             if (divisor > 65535 || (*p && *p != ',')) { if (errorAt) *errorAt = item; return false; }
+         }
+
+         if (!strcmp(name, "*")) {
+             subscribeAllTelemetry(next, (uint16_t)divisor);
+         } else {
+             int i = telemetryFieldIndex(name);
+             if (i < 0) { if (errorAt) *errorAt = item; return false; }
+             next.divisor[i] = (uint16_t)divisor;
+         }
+         if (*p == ',') p++;
+     }
+
+     sub = next;
+     return true;
+ }
+
+ uint32_t dueTelemetryFields(const TelemetrySubscription &sub, uint32_t run)
+ {
+     uint32_t due = 0;
+     for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+         uint16_t d = sub.divisor[i];
+         if (d && run % d == 0) due |= 1u << i;
+     }
+     return due ? (due | TELEMETRY_REQUIRED_FIELDS) : 0;
+ }
@@ -0,0 +1,179 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "system_state.h"
+
+/*
+ * File: telemetry.h
+ * Brief: Compact binary telemetry record, its framing, and the host's
+ *        field subscriptions.
+ *
+ *   frame  = COBS( record ‖ crc16Ccitt(record) ) 0x00
+ *   record = TELEMETRY_VERSION, u32 field mask, then the fields whose
+ *            mask bit is set, in TELEMETRY_FIELDS order, little-endian.
+ *            Flag bits share one byte, present if any of them is.
+ *
+ *   Signals are scaled integers at (at least) the resolution the JSON line
+ *   prints, PID internals are IEEE half floats (~3 significant digits),
+ *   link counters are kept whole. A full frame is 74 bytes against ~390
+ *   for the JSON line, and encoding is a handful of stores.
+ *
+ *   The host decoder (host/telemetry_decoder.*) walks TELEMETRY_FIELDS,
+ *   so a field is added here and in encodeTelemetryRecord() only; bump
+ *   TELEMETRY_VERSION whenever the layout changes.
+ */
+
+static const uint8_t TELEMETRY_VERSION = 5;
+
+enum {
+    TLM_U8 = 0,
+    TLM_U16,
+    TLM_U32,
+    TLM_I16,
+    TLM_F16,       // IEEE 754 half
+    TLM_BIT        // one bit of a flags byte; bit 0 starts a new byte
+};
+
+typedef struct {
+    const char *name;     // key used by the JSON line
+    uint8_t     type;     // TLM_*
+    uint8_t     bit;      // TLM_BIT only
+    float       scale;    // stored = value × scale (integer types)
+} TelemetryField;
+
+static constexpr TelemetryField TELEMETRY_FIELDS[] = {
+    { "seq",          TLM_U16, 0, 1.0f     },
+    { "timeMs",       TLM_U32, 0, 1.0f     },
+    { "flow",         TLM_I16, 0, 1000.0f  },
+    { "setpt",        TLM_I16, 0, 1000.0f  },
+    { "errorPct",     TLM_I16, 0, 100.0f   },
+    { "pidOut",       TLM_U16, 0, 10000.0f },
+    { "volt",         TLM_U16, 0, 100.0f   },
+    { "temp",         TLM_I16, 0, 100.0f   },
+    { "bubble",       TLM_BIT, 0, 1.0f     },
+    { "on",           TLM_BIT, 1, 1.0f     },
+    { "mode",         TLM_BIT, 2, 1.0f     },   // 0 = EXP, 1 = CONST
+    { "flowHold",     TLM_BIT, 3, 1.0f     },   // flow outage, pump held
+    { "flowFault",    TLM_BIT, 4, 1.0f     },   // outage past FLOW_HOLDOVER_MS, pump off
+    { "P",            TLM_F16, 0, 1.0f     },
+    { "I",            TLM_F16, 0, 1.0f     },
+    { "D",            TLM_F16, 0, 1.0f     },
+    { "pGain",        TLM_F16, 0, 1.0f     },
+    { "iGain",        TLM_F16, 0, 1.0f     },
+    { "dGain",        TLM_F16, 0, 1.0f     },
+    { "filteredErr",  TLM_F16, 0, 1.0f     },
+    { "currentAlpha", TLM_F16, 0, 1.0f     },
+    { "pumpTx",       TLM_U16, 0, 1.0f     },
+    { "pumpBytes",    TLM_U16, 0, 1.0f     },
+    { "pumpStopFail", TLM_U16, 0, 1.0f     },   // saturates at 65535
+    { "crcErr",       TLM_U32, 0, 1.0f     },
+    { "shortRd",      TLM_U32, 0, 1.0f     },
+    { "nack",         TLM_U32, 0, 1.0f     },
+    { "outages",      TLM_U16, 0, 1.0f     },
+    { "faults",       TLM_U16, 0, 1.0f     },
+    { "outageMs",     TLM_U16, 0, 1.0f     },   // saturates at 65535
+    { "maxOutageMs",  TLM_U16, 0, 1.0f     },
+    { "txDrop",       TLM_U32, 0, 1.0f     }
+};
+static constexpr uint8_t TELEMETRY_FIELD_COUNT =
+    sizeof(TELEMETRY_FIELDS) / sizeof(TELEMETRY_FIELDS[0]);
+
+// Field indices (TELEMETRY_FIELDS order) for the JSON writer
+enum {
+    TLM_FIELD_SEQ = 0, TLM_FIELD_TIME, TLM_FIELD_FLOW, TLM_FIELD_SETPT,
+    TLM_FIELD_ERROR_PCT, TLM_FIELD_PID_OUT, TLM_FIELD_VOLT, TLM_FIELD_TEMP,
+    TLM_FIELD_BUBBLE, TLM_FIELD_ON, TLM_FIELD_MODE,
+    TLM_FIELD_FLOW_HOLD, TLM_FIELD_FLOW_FAULT,
+    TLM_FIELD_P, TLM_FIELD_I, TLM_FIELD_D,
+    TLM_FIELD_P_GAIN, TLM_FIELD_I_GAIN, TLM_FIELD_D_GAIN,
+    TLM_FIELD_FILTERED_ERR, TLM_FIELD_ALPHA,
+    TLM_FIELD_PUMP_TX, TLM_FIELD_PUMP_BYTES, TLM_FIELD_PUMP_STOP_FAIL,
+    TLM_FIELD_CRC_ERR, TLM_FIELD_SHORT_RD, TLM_FIELD_NACK,
+    TLM_FIELD_OUTAGES, TLM_FIELD_FAULTS, TLM_FIELD_OUTAGE_MS, TLM_FIELD_MAX_OUTAGE_MS,
+    TLM_FIELD_TX_DROP,
+    TLM_FIELD_COUNT
+};
+static_assert(TLM_FIELD_COUNT == TELEMETRY_FIELD_COUNT, "field index enum out of sync");
+static_assert(TELEMETRY_FIELD_COUNT <= 32, "field mask is 32 bits");
+
+// Field mask bits; sequence number and time go with every record
+static constexpr uint32_t TELEMETRY_ALL_FIELDS =
+    TELEMETRY_FIELD_COUNT == 32 ? 0xFFFFFFFFu : (1u << TELEMETRY_FIELD_COUNT) - 1;
+static constexpr uint32_t TELEMETRY_REQUIRED_FIELDS =
+    (1u << TLM_FIELD_SEQ) | (1u << TLM_FIELD_TIME);
+
+static constexpr uint8_t telemetryFieldSize(const TelemetryField &f)
+{
+    return f.type == TLM_U32 ? 4
+         : f.type == TLM_U8  ? 1
+         : f.type == TLM_BIT ? (f.bit == 0 ? 1 : 0)
+         : 2;
+}
+
+// Record length for a field mask (a flags byte is present if any of its bits is)
+static constexpr uint8_t telemetryRecordSize(uint32_t fields)
+{
+    uint8_t n = 1 + 4;                               // version, field mask
+    bool flagsByte = false;
+    for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+        const TelemetryField &f = TELEMETRY_FIELDS[i];
+        bool present = (fields >> i) & 1;
+        if (f.type == TLM_BIT) {
+            if (f.bit == 0) flagsByte = false;
+            if (present && !flagsByte) { n++; flagsByte = true; }
+        } else if (present) {
+            n += telemetryFieldSize(f);
+        }
+    }
+    return n;
+}
+
+static constexpr uint8_t TELEMETRY_RECORD_SIZE = telemetryRecordSize(TELEMETRY_ALL_FIELDS);   // largest
+static constexpr uint8_t TELEMETRY_MIN_RECORD_SIZE = telemetryRecordSize(TELEMETRY_REQUIRED_FIELDS);
+static constexpr uint8_t TELEMETRY_PAYLOAD_SIZE = TELEMETRY_RECORD_SIZE + 2;      // + CRC-16
+static constexpr uint8_t TELEMETRY_COBS_SIZE    = TELEMETRY_PAYLOAD_SIZE + 1;     // one code byte per 254
+static constexpr uint8_t TELEMETRY_FRAME_SIZE   = TELEMETRY_COBS_SIZE + 1;        // + 0x00 delimiter
+static_assert(TELEMETRY_PAYLOAD_SIZE < 254, "frame needs more than one COBS code byte");
+
+// Packs the masked fields of one sample (plus TELEMETRY_REQUIRED_FIELDS);
+// returns telemetryRecordSize() of the mask actually written
+size_t   encodeTelemetryRecord(const SystemState &s, uint16_t seq, uint32_t fields, uint8_t *record);
+
+// Record + CRC + COBS + delimiter into frame[TELEMETRY_FRAME_SIZE]; returns the length
+size_t   encodeTelemetryFrame(const SystemState &s, uint16_t seq, uint32_t fields, uint8_t *frame);
+
+// COBS: out needs len + len/254 + 1 bytes; decode returns 0 on a malformed block
+size_t   cobsEncode(const uint8_t *in, size_t len, uint8_t *out);
+size_t   cobsDecode(const uint8_t *in, size_t len, uint8_t *out);
+
+// IEEE 754 half conversion (round to nearest, subnormals flush to zero)
+uint16_t floatToHalf(float v);
+float    halfToFloat(uint16_t h);
+
+/*──────── subscriptions ────────*/
+
+/*
+ * Per-field rate divisors, in telemetry runs (TELEMETRY_BINARY_DIVIDER):
+ * a field is sent on runs where run % divisor == 0, 0 = not sent. A record
+ * goes out when any field is due and carries only the due ones.
+ */
+typedef struct {
+    uint16_t divisor[TELEMETRY_FIELD_COUNT];
+} TelemetrySubscription;
+
+// Every field at one divisor
+void     subscribeAllTelemetry(TelemetrySubscription &sub, uint16_t divisor);
+
+/*
+ * Parses "flow:1,setpt,pGain:50" (no divisor = 1, "*" = every field).
+ * Fields not listed are off. On error `sub` is unchanged and `errorAt`
+ * points at the offending item.
+ */
+bool     parseTelemetrySubscription(const char *list, TelemetrySubscription &sub,
+                                    const char **errorAt = nullptr);
+
+// Fields due on this telemetry run (0 = nothing to send)
+uint32_t dueTelemetryFields(const TelemetrySubscription &sub, uint32_t run);
+
+// Index of a field by its JSON key, or -1
+int      telemetryFieldIndex(const char *name);
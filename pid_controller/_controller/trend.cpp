@@ -0,0 +1,54 @@
+/*
+ * File: trend.cpp
+ * Brief: Min/max-decimated flow history (see trend.h).
+ */
+
+ #include "trend.h"
+
+ static MODULE_STATE TrendColumn s_columns[TREND_COLUMNS];
+ static MODULE_STATE uint32_t    s_count = 0;       // completed columns
+
+ // Column being filled
+ static MODULE_STATE int16_t  s_min     = 0;
+ static MODULE_STATE int16_t  s_max     = 0;
+ static MODULE_STATE uint16_t s_samples = 0;
+
+ static int16_t toMicroLitres(float mLmin)
+ {
+     float ul = mLmin * 1000.0f;
+     if (ul >  32767.0f) ul =  32767.0f;
+     if (ul < -32768.0f) ul = -32768.0f;
+     return (int16_t)lroundf(ul);
+ }
+
+ void initTrend()
+ {
+     s_count   = 0;
+     s_samples = 0;
+ }
+
+ bool pushTrendSample(float flow, float setpoint)
+ {
+     int16_t f = toMicroLitres(flow);
+     if (s_samples == 0 || f < s_min) s_min = f;
+     if (s_samples == 0 || f > s_max) s_max = f;
+     if (++s_samples < TREND_SAMPLES_PER_COLUMN) return false;
+
+     TrendColumn &c = s_columns[s_count % TREND_COLUMNS];
+     c.flowMin  = s_min;
+     c.flowMax  = s_max;
+     c.setpoint = toMicroLitres(setpoint);
+     s_count++;
+     s_samples = 0;
+     return true;
+ }
+
+ uint32_t trendColumnCount()
+ {
+     return s_count;
+ }
+
+ const TrendColumn &getTrendColumn(uint32_t n)
+ {
+     return s_columns[n % TREND_COLUMNS];
+ }
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+/*
+ * File: trend.h
+ * Brief: Flow vs setpoint history for the OLED trend page: a fixed ring of
+ *        TREND_COLUMNS min/max-decimated columns, one per screen column.
+ *
+ *   A column covers TREND_SAMPLES_PER_COLUMN control-rate samples and keeps
+ *   the lowest and highest flow and the last setpoint, so a short spike
+ *   survives the decimation. Memory does not depend on TREND_SECONDS.
+ *   Columns are numbered by a running count, so a reader can tell which
+ *   ones it has not drawn yet. Written and read by the I/O task only.
+ */
+
+typedef struct {
+    int16_t flowMin;      // µL/min
+    int16_t flowMax;      // µL/min
+    int16_t setpoint;     // µL/min
+} TrendColumn;
+
+// Empties the history
+void initTrend();
+
+// Adds one sample; returns true when it completed a column
+bool pushTrendSample(float flow, float setpoint);
+
+// Columns completed since initTrend()
+uint32_t trendColumnCount();
+
+// Column number n (only the last TREND_COLUMNS are kept)
+const TrendColumn &getTrendColumn(uint32_t n);
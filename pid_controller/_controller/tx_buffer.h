@@ -0,0 +1,124 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * File: tx_buffer.h
+ * Brief: Non-blocking serial transmit: a task formats into a pre-allocated
+ *        byte ring, a low-priority task drains it into the driver.
+ *
+ *   One producer task and one draining task per buffer. The producer uses
+ *   it as a Print; bytes become visible to the drain only when a record is
+ *   complete. A record is a line (committed at each '\n'), or everything
+ *   between beginRecord() and endRecord() for binary data that may contain
+ *   '\n'. A record that does not fit in the free space is dropped whole
+ *   and counted, so a full buffer never blocks the producer and never
+ *   emits half a line or half a frame.
+ *
+ *   drain() writes no more than the caller's byte budget (the driver's
+ *   free space), so it never blocks either.
+ */
+
+template <uint32_t N>
+class TxBuffer : public Print {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "buffer size must be a power of two");
+
+public:
+    /*──────── producer side ────────*/
+
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t *buf, size_t n) override
+    {
+        if (explicit_) {
+            append(buf, n);
+            return n;
+        }
+        size_t left = n;
+        while (left) {
+            const uint8_t *nl = (const uint8_t *)memchr(buf, '\n', left);
+            size_t chunk = nl ? (size_t)(nl - buf) + 1 : left;
+            append(buf, chunk);
+            if (nl) commit();
+            buf  += chunk;
+            left -= chunk;
+        }
+        return n;
+    }
+
+    // Binary record: newlines inside it do not commit
+    void beginRecord() { explicit_ = true; }
+    void endRecord()   { explicit_ = false; commit(); }
+
+    // Records dropped because the buffer was full
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /*──────── drain side ───────────*/
+
+    // Committed bytes not yet drained
+    uint32_t pending() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Writes committed bytes to `out`, at most `room` (decremented by what
+     * was written). Returns true if it stopped on a record boundary.
+     */
+    bool drain(Print &out, size_t &room)
+    {
+        uint32_t h = head_.load(std::memory_order_acquire);
+        uint32_t t = tail_.load(std::memory_order_relaxed);
+        while (t != h && room) {
+            uint32_t idx   = t & (N - 1);
+            size_t   chunk = h - t;
+            if (chunk > N - idx) chunk = N - idx;
+            if (chunk > room)    chunk = room;
+            size_t done = out.write(&buf_[idx], chunk);
+            if (!done) break;
+            t    += (uint32_t)done;
+            room -= done;
+        }
+        tail_.store(t, std::memory_order_release);
+        return t == h;
+    }
+
+private:
+    // Adds to the open record, or starts dropping it once it no longer fits
+    void append(const uint8_t *p, size_t n)
+    {
+        if (dropping_) return;
+        if (n > N - (pending_ - tail_.load(std::memory_order_acquire))) {
+            dropping_ = true;
+            pending_  = head_.load(std::memory_order_relaxed);
+            return;
+        }
+        uint32_t idx   = pending_ & (N - 1);
+        size_t   first = n < N - idx ? n : N - idx;
+        memcpy(&buf_[idx], p, first);
+        memcpy(&buf_[0], p + first, n - first);
+        pending_ += (uint32_t)n;
+    }
+
+    void commit()
+    {
+        if (dropping_) {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            dropping_ = false;
+        } else {
+            head_.store(pending_, std::memory_order_release);
+        }
+    }
+
+    std::atomic<uint32_t> head_{0};       // end of the last committed record
+    std::atomic<uint32_t> tail_{0};       // drain position
+    std::atomic<uint32_t> dropped_{0};
+    uint32_t pending_  = 0;               // end of the open record (producer only)
+    bool     explicit_ = false;
+    bool     dropping_ = false;
+    uint8_t  buf_[N]   = {};
+};
@@ -0,0 +1,54 @@
+/*
+ * File: bench_main.cpp
+ * Brief: Runs the hot-path micro-benchmarks (bench.h) on the host.
+ *
+ *   controller_bench [--out FILE]
+ *
+ *   Prints one JSON object (the same format as the target's 'B' command)
+ *   to stdout, or appends it to FILE, so results can be collected per
+ *   commit. The display is the null SSD1306 shim, so showStatus+render is
+ *   the retained-text diff and cursor placement, not the glyph drawing.
+ */
+
+ #include "bench.h"
+ #include "display.h"
+ #include <Arduino.h>
+ #include <stdio.h>
+ #include <string.h>
+
+ int main(int argc, char **argv)
+ {
+     const char *outPath = nullptr;
+     for (int i = 1; i < argc; i++) {
+         if (!strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+         else { fprintf(stderr, "usage: %s [--out FILE]\n", argv[0]); return 2; }
+     }
+
+     FILE *out = outPath ? fopen(outPath, "a") : stdout;
+     if (!out) { fprintf(stderr, "[BENCH] cannot open %s\n", outPath); return 2; }
+
+     hostSerialSetOutput(nullptr);
+     initDisplay();
+
+     SystemState sample = {};
+     sample.currentTimeMs  = 123456;
+     sample.flow           = 0.497f;
+     sample.setpoint       = 0.5f;
+     sample.errorPercent   = 8.0f;
+     sample.desiredVoltage = 71.2f;
+     sample.temperature    = 24.6f;
+     sample.systemOn       = true;
+     sample.filteredError  = 0.003f;
+     sample.currentAlpha   = 0.49f;
+
+     BenchReport report;
+     initBenchReport(report);
+     benchControlPath(report);
+     benchIoPath(report, sample);
+
+     hostSerialSetOutput(out);
+     printBenchJSON(Serial, report);
+     Serial.flush();
+     if (outPath) fclose(out);
+     return 0;
+ }
@@ -0,0 +1,520 @@
+/*
+ * File: checks_main.cpp
+ * Brief: Round-trip and edge-case checks of the pure firmware modules.
+ *
+ *   controller_checks          (run by ctest)
+ *
+ *   Covers the checksums, COBS framing, half floats, telemetry record
+ *   sizing and decoding, the TxBuffer whole-record drop rule, the settings
+ *   journal, the flow guard state machine and the pump driver's stop
+ *   retries. Prints each failed check and exits non-zero if there was one.
+ */
+
+ #include "bartels.h"
+ #include "crc.h"
+ #include "config.h"
+ #include "flow_guard.h"
+ #include "i2c_bus.h"
+ #include "settings.h"
+ #include "sim_devices.h"
+ #include "system_state.h"
+ #include "telemetry.h"
+ #include "telemetry_decoder.h"
+ #include "tx_buffer.h"
+ #include <Arduino.h>
+ #include <EEPROM.h>
+ #include <Wire.h>
+ #include <math.h>
+ #include <stdio.h>
+ #include <string.h>
+ #include <string>
+
+ static int s_checks   = 0;
+ static int s_failures = 0;
+
+ #define CHECK(cond)                                                          \
+     do {                                                                     \
+         s_checks++;                                                          \
+         if (!(cond)) {                                                       \
+             s_failures++;                                                    \
+             fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+         }                                                                    \
+     } while (0)
+
+ /*──────────────────────── CRC ────────────────────────────────────────────*/
+ static void checkCrc()
+ {
+     const uint8_t text[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+     CHECK(crc16Ccitt(text, sizeof text) == 0x29B1);
+     CHECK(crc16Ccitt(text + 4, 5, crc16Ccitt(text, 4)) == 0x29B1);   // chained
+
+     const uint8_t word[] = { 0xBE, 0xEF };
+     CHECK(crc8Sensirion(word, sizeof word) == 0x92);
+ }
+
+ /*──────────────────────── COBS ───────────────────────────────────────────*/
+ // Encodes and decodes `in`; true if the block is zero-free, within the
+ // documented size bound and decodes back to `in`
+ static bool cobsRoundTrip(const uint8_t *in, size_t len)
+ {
+     uint8_t enc[1200], dec[1200];
+     size_t n = cobsEncode(in, len, enc);
+     if (n > len + len / 254 + 1) return false;
+     if (memchr(enc, 0, n)) return false;
+     return cobsDecode(enc, n, dec) == len && memcmp(dec, in, len) == 0;
+ }
+
+ static void checkCobs()
+ {
+     uint8_t buf[1024];
+
+     const uint8_t zeros[] = { 0x00, 0x00, 0x00 };
+     CHECK(cobsRoundTrip(zeros, 1));
+     CHECK(cobsRoundTrip(zeros, 3));
+     const uint8_t mixed[] = { 0x11, 0x00, 0x00, 0x22, 0x33, 0x00 };
+     CHECK(cobsRoundTrip(mixed, sizeof mixed));
+
+     // Runs of non-zero bytes around the 254-byte block limit
+     const size_t runs[] = { 1, 253, 254, 255, 508, 509, 1000 };
+     for (size_t len : runs) {
+         for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)(i % 255 + 1);
+         CHECK(cobsRoundTrip(buf, len));
+         buf[0] = 0x00;                         // leading zero
+         CHECK(cobsRoundTrip(buf, len));
+         buf[0] = 0x01;
+         buf[len - 1] = 0x00;                   // trailing zero
+         CHECK(cobsRoundTrip(buf, len));
+     }
+
+     // 254 non-zero bytes fill one maximal block; a 0x01 code ends the frame
+     uint8_t enc[300];
+     memset(buf, 0xAB, 254);
+     CHECK(cobsEncode(buf, 254, enc) == 256);
+     CHECK(enc[0] == 0xFF && enc[255] == 0x01);
+
+     // Zeros every few bytes
+     for (size_t i = 0; i < sizeof buf; i++) buf[i] = (i % 7 == 3) ? 0x00 : (uint8_t)i | 1;
+     CHECK(cobsRoundTrip(buf, sizeof buf));
+
+     // Malformed blocks
+     uint8_t out[16];
+     const uint8_t zeroCode[] = { 0x00, 0x01 };
+     const uint8_t overrun[]  = { 0x05, 0x01, 0x02 };
+     const uint8_t inner0[]   = { 0x03, 0x01, 0x00 };
+     CHECK(cobsDecode(zeroCode, sizeof zeroCode, out) == 0);
+     CHECK(cobsDecode(overrun,  sizeof overrun,  out) == 0);
+     CHECK(cobsDecode(inner0,   sizeof inner0,   out) == 0);
+ }
+
+ /*──────────────────────── HALF FLOAT ─────────────────────────────────────*/
+ static void checkHalf()
+ {
+     CHECK(floatToHalf(0.0f)    == 0x0000);
+     CHECK(floatToHalf(-0.0f)   == 0x8000);
+     CHECK(floatToHalf(1.0f)    == 0x3C00);
+     CHECK(floatToHalf(-2.0f)   == 0xC000);
+     CHECK(floatToHalf(65504.0f) == 0x7BFF);               // largest half
+     CHECK(halfToFloat(0x7BFF)  == 65504.0f);
+
+     // Round to nearest, ties to even
+     CHECK(floatToHalf(1.0f + ldexpf(1.0f, -11)) == 0x3C00);                     // tie → even
+     CHECK(floatToHalf(1.0f + 3.0f * ldexpf(1.0f, -11)) == 0x3C02);              // tie → even
+     CHECK(floatToHalf(1.0f + ldexpf(1.0f, -11) + ldexpf(1.0f, -20)) == 0x3C01); // above tie
+     CHECK(floatToHalf(2047.0f / 1024.0f) == 0x3FFF);
+     CHECK(floatToHalf(4095.0f / 2048.0f) == 0x4000);      // mantissa carries into the exponent
+
+     // Overflow, infinity and NaN
+     CHECK(floatToHalf(65519.0f) == 0x7BFF);
+     CHECK(floatToHalf(65520.0f) == 0x7C00);               // rounds up past the largest half
+     CHECK(floatToHalf(1e6f)     == 0x7C00);
+     CHECK(floatToHalf(-1e6f)    == 0xFC00);
+     CHECK(floatToHalf(INFINITY) == 0x7C00);
+     CHECK(isinf(halfToFloat(0x7C00)) && halfToFloat(0xFC00) < 0.0f);
+     uint16_t nan = floatToHalf(NAN);
+     CHECK((nan & 0x7C00) == 0x7C00 && (nan & 0x03FF) != 0);
+     CHECK(isnan(halfToFloat(nan)));
+
+     // Smallest normal survives, below it flushes to a signed zero
+     CHECK(floatToHalf(ldexpf(1.0f, -14))  == 0x0400);
+     CHECK(floatToHalf(ldexpf(1.0f, -15))  == 0x0000);
+     CHECK(floatToHalf(-ldexpf(1.0f, -15)) == 0x8000);
+
+     // Every finite normal half round-trips exactly
+     bool exact = true;
+     for (uint32_t h = 0; h <= 0xFFFF; h++) {
+         uint32_t e5 = (h >> 10) & 0x1F;
+         if (e5 == 0 || e5 == 31) continue;
+         if (floatToHalf(halfToFloat((uint16_t)h)) != h) exact = false;
+     }
+     CHECK(exact);
+ }
+
+ /*──────────────────────── TELEMETRY ──────────────────────────────────────*/
+ static uint32_t bit(int field) { return 1u << field; }
+
+ static SystemState telemetrySample()
+ {
+     SystemState s = {};
+     s.currentTimeMs  = 123456;
+     s.flow           = 0.497f;
+     s.setpoint       = 0.5f;
+     s.errorPercent   = -8.25f;
+     s.pidOutput      = 0.4321f;
+     s.desiredVoltage = 71.2f;
+     s.temperature    = 24.6f;
+     s.bubbleDetected = false;
+     s.systemOn       = true;
+     s.controlMode    = CONTROL_MODE_EXP;
+     s.flowPath       = FLOW_PATH_HOLDOVER;
+     s.pTerm          = 0.123f;
+     s.iTerm          = -1.5f;
+     s.iGain          = 250.0f;
+     s.flowNacks      = 70000;
+     s.flowOutageMs   = 100000;      // saturates at 65535 on the wire
+     s.txDrops        = 3;
+     return s;
+ }
+
+ static void checkTelemetry()
+ {
+     const uint32_t req = TELEMETRY_REQUIRED_FIELDS;
+     CHECK(TELEMETRY_MIN_RECORD_SIZE == 11);                      // version, mask, seq, time
+     CHECK(telemetryRecordSize(req | bit(TLM_FIELD_FLOW)) == 13);
+
+     // Flag bits share one byte, allocated by the first one present
+     CHECK(telemetryRecordSize(req | bit(TLM_FIELD_FLOW_FAULT)) == 12);
+     CHECK(telemetryRecordSize(req | bit(TLM_FIELD_BUBBLE) | bit(TLM_FIELD_FLOW_FAULT)) == 12);
+     CHECK(telemetryRecordSize(req | bit(TLM_FIELD_BUBBLE) | bit(TLM_FIELD_ON) | bit(TLM_FIELD_MODE)
+                               | bit(TLM_FIELD_FLOW_HOLD) | bit(TLM_FIELD_FLOW_FAULT)) == 12);
+
+     // The encoder writes exactly the size the mask implies
+     SystemState s = telemetrySample();
+     uint8_t record[TELEMETRY_RECORD_SIZE];
+     const uint32_t masks[] = {
+         req, req | bit(TLM_FIELD_FLOW), req | bit(TLM_FIELD_ON) | bit(TLM_FIELD_P),
+         req | bit(TLM_FIELD_FLOW_FAULT) | bit(TLM_FIELD_TX_DROP), TELEMETRY_ALL_FIELDS
+     };
+     for (uint32_t m : masks) CHECK(encodeTelemetryRecord(s, 7, m, record) == telemetryRecordSize(m));
+     CHECK(encodeTelemetryRecord(s, 7, 0, record) == TELEMETRY_MIN_RECORD_SIZE);   // required added
+
+     // Full frame through the decoder
+     uint8_t frame[TELEMETRY_FRAME_SIZE];
+     size_t len = encodeTelemetryFrame(s, 4242, TELEMETRY_ALL_FIELDS, frame);
+     CHECK(len == TELEMETRY_FRAME_SIZE);
+
+     TelemetryDecoder dec;
+     initTelemetryDecoder(dec);
+     TelemetrySample got = {};
+     int samples = 0;
+     auto onSample = [&](const TelemetrySample &t) { got = t; samples++; };
+     feedTelemetryDecoder(dec, frame, 5, onSample);               // any chunking
+     feedTelemetryDecoder(dec, frame + 5, len - 5, onSample);
+     CHECK(samples == 1 && dec.stats.frames == 1);
+     CHECK(got.fields == TELEMETRY_ALL_FIELDS);
+     CHECK(got.values[TLM_FIELD_SEQ]  == 4242);
+     CHECK(got.values[TLM_FIELD_TIME] == 123456);
+     CHECK(fabs(got.values[TLM_FIELD_FLOW]      - 0.497)  < 0.5e-3);
+     CHECK(fabs(got.values[TLM_FIELD_ERROR_PCT] + 8.25)   < 0.5e-2);
+     CHECK(fabs(got.values[TLM_FIELD_PID_OUT]   - 0.4321) < 0.5e-4);
+     CHECK(fabs(got.values[TLM_FIELD_VOLT]      - 71.2)   < 0.5e-2);
+     CHECK(got.values[TLM_FIELD_ON] == 1 && got.values[TLM_FIELD_BUBBLE] == 0);
+     CHECK(got.values[TLM_FIELD_FLOW_HOLD] == 1 && got.values[TLM_FIELD_FLOW_FAULT] == 0);
+     CHECK(fabs(got.values[TLM_FIELD_P] - 0.123) < 0.123 * 1e-3);
+     CHECK(got.values[TLM_FIELD_I] == -1.5 && got.values[TLM_FIELD_I_GAIN] == 250.0);
+     CHECK(got.values[TLM_FIELD_NACK] == 70000);
+     CHECK(got.values[TLM_FIELD_OUTAGE_MS] == 65535);
+     CHECK(got.values[TLM_FIELD_TX_DROP] == 3);
+
+     // A subset record leaves the other fields absent
+     len = encodeTelemetryFrame(s, 4243, bit(TLM_FIELD_FLOW), frame);
+     CHECK(len == 17);
+     feedTelemetryDecoder(dec, frame, len, onSample);
+     CHECK(samples == 2 && got.fields == (req | bit(TLM_FIELD_FLOW)));
+     CHECK(got.values[TLM_FIELD_VOLT] == 0 && dec.stats.seqGaps == 0);
+
+     // A damaged payload is rejected by its CRC
+     uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+     len = encodeTelemetryFrame(s, 4244, TELEMETRY_ALL_FIELDS, frame);
+     size_t n = cobsDecode(frame, len - 1, payload);
+     CHECK(n == TELEMETRY_PAYLOAD_SIZE);
+     payload[20] ^= 0x01;
+     len = cobsEncode(payload, n, frame);
+     frame[len++] = 0x00;
+     feedTelemetryDecoder(dec, frame, len, onSample);
+     CHECK(samples == 2 && dec.stats.crcErrors == 1);
+ }
+
+ /*──────────────────────── TX BUFFER ──────────────────────────────────────*/
+ class CaptureSink : public Print {
+ public:
+     using Print::write;
+     size_t write(uint8_t c) override { text += (char)c; return 1; }
+     std::string text;
+ };
+
+ static void checkTxBuffer()
+ {
+     TxBuffer<16> tx;
+     CaptureSink out;
+     size_t room = 100;
+
+     tx.print("abc\n");
+     CHECK(tx.pending() == 4);
+     tx.print("0123456789abc\n");             // 14 bytes, 12 free: dropped whole
+     CHECK(tx.pending() == 4 && tx.dropped() == 1);
+     tx.print("xy");                          // open line: not visible yet
+     CHECK(tx.pending() == 4);
+     tx.print("\n");
+     CHECK(tx.drain(out, room) && out.text == "abc\nxy\n");
+
+     // A line that stops fitting halfway is dropped whole, not cut
+     out.text.clear();
+     tx.print("0123456789");
+     tx.print("abcdefgh\n");
+     CHECK(tx.pending() == 0 && tx.dropped() == 2);
+     tx.print("ok\n");
+     room = 100;
+     CHECK(tx.drain(out, room) && out.text == "ok\n");
+
+     // Binary records commit at endRecord(), not at '\n'
+     const uint8_t bin[] = { 0x01, '\n', 0x02 };
+     tx.beginRecord();
+     tx.write(bin, sizeof bin);
+     CHECK(tx.pending() == 0);
+     tx.endRecord();
+     CHECK(tx.pending() == 3);
+
+     // drain() stops at the byte budget
+     out.text.clear();
+     room = 2;
+     CHECK(!tx.drain(out, room) && room == 0 && out.text.size() == 2);
+     room = 100;
+     CHECK(tx.drain(out, room) && out.text == std::string((const char *)bin, sizeof bin));
+
+     // A record of exactly the buffer size fits, wrapping around the end
+     tx.print("0123456789abcde\n");
+     CHECK(tx.pending() == 16 && tx.dropped() == 2);
+ }
+
+ /*──────────────────────── SETTINGS JOURNAL ───────────────────────────────*/
+ static const int SLOT_SIZE = 16;            // SettingsRecord (settings.cpp)
+
+ static void eraseEeprom()
+ {
+     memset(EEPROM.hostData(), 0xFF, SETTINGS_EEPROM_SIZE);
+ }
+
+ static uint32_t slotSeq(int slot)
+ {
+     uint32_t seq = 0;
+     EEPROM.get(slot * SLOT_SIZE, seq);
+     return seq;
+ }
+
+ // Changes the setpoint and lets the quiet time commit it
+ static void commitSetpoint(float setpoint)
+ {
+     Settings s = currentSettings();
+     s.setpoint = setpoint;
+     changeSettings(s);
+     hostAdvanceMicros((uint64_t)SETTINGS_QUIET_MS * 1000);
+     serviceSettings(false);
+ }
+
+ static void checkSettings()
+ {
+     hostResetClock();
+     EEPROM.begin(SETTINGS_EEPROM_SIZE);
+
+     // Empty journal, legacy values present
+     eraseEeprom();
+     EEPROM.put(0, 12.5f);                   // old layout: error % at 0
+     EEPROM.put(4, 1.25f);                   // setpoint at 4
+     CHECK(!initSettings());
+     CHECK(currentSettings().errorPercent == 12.5f && currentSettings().setpoint == 1.25f);
+     CHECK(currentSettings().controlMode == CONTROL_MODE_EXP);
+
+     // Erased flash: defaults
+     eraseEeprom();
+     CHECK(!initSettings());
+     CHECK(currentSettings().errorPercent == 0.0f);
+     CHECK(currentSettings().setpoint == (FLOW_SP_MIN + FLOW_SP_MAX) * 0.5f);
+
+     // Changes wait for the quiet time, or commit at switch-off
+     uint32_t commits = EEPROM.hostCommits();
+     Settings s = currentSettings();
+     s.setpoint = 0.75f;
+     changeSettings(s);
+     serviceSettings(true);
+     hostAdvanceMicros((uint64_t)(SETTINGS_QUIET_MS - 1) * 1000);
+     serviceSettings(true);
+     CHECK(EEPROM.hostCommits() == commits && slotSeq(0) == 0xFFFFFFFFu);
+     serviceSettings(false);                 // switched off
+     CHECK(EEPROM.hostCommits() == commits + 1 && slotSeq(0) == 1);
+     changeSettings(currentSettings());      // no change, no commit
+     hostAdvanceMicros((uint64_t)SETTINGS_QUIET_MS * 1000);
+     serviceSettings(false);
+     CHECK(EEPROM.hostCommits() == commits + 1);
+
+     commitSetpoint(0.8f);
+     CHECK(slotSeq(1) == 2);
+     CHECK(initSettings() && currentSettings().setpoint == 0.8f);
+
+     // Torn newest slot: the one before it loads, and the next commit
+     // goes after it
+     EEPROM.hostData()[1 * SLOT_SIZE + 5] ^= 0x40;
+     CHECK(initSettings() && currentSettings().setpoint == 0.75f);
+     commitSetpoint(0.9f);
+     CHECK(slotSeq(1) == 2);                 // overwritten with the next seq
+     CHECK(initSettings() && currentSettings().setpoint == 0.9f);
+
+     // Wrap past the last slot: the newest sequence number wins, not the
+     // highest slot
+     for (int i = 0; i < SETTINGS_SLOTS; i++) commitSetpoint(1.0f + i * 0.01f);
+     float newest = 1.0f + (SETTINGS_SLOTS - 1) * 0.01f;
+     CHECK(slotSeq(1) == 2 + SETTINGS_SLOTS && slotSeq(2) == 3);
+     CHECK(initSettings() && currentSettings().setpoint == newest);
+     commitSetpoint(0.6f);
+     CHECK(slotSeq(2) == 3 + SETTINGS_SLOTS);
+     CHECK(initSettings() && currentSettings().setpoint == 0.6f);
+
+     // A torn slot right after the wrap point
+     EEPROM.hostData()[2 * SLOT_SIZE + 14] ^= 0x01;        // CRC byte
+     CHECK(initSettings() && currentSettings().setpoint == newest);
+
+     // Every slot torn: back to the legacy/default path
+     for (int i = 0; i < SETTINGS_SLOTS; i++) EEPROM.hostData()[i * SLOT_SIZE + 8] ^= 0x01;
+     CHECK(!initSettings());
+ }
+
+ /*──────────────────────── FLOW GUARD ─────────────────────────────────────*/
+ static FlowSample flowSample(uint32_t timeUs, uint8_t quality)
+ {
+     FlowSample s = {};
+     s.timeUs  = timeUs;
+     s.flow    = 0.5f;
+     s.quality = quality;
+     return s;
+ }
+
+ static void checkFlowGuard()
+ {
+     const uint32_t startupUs  = FLOW_STARTUP_MS * 1000;
+     const uint32_t holdoverUs = FLOW_HOLDOVER_MS * 1000;
+     FlowGuard g;
+
+     // OK → HOLDOVER → FAULT → OK
+     uint32_t t = 5000000;
+     initFlowGuard(g, t);
+     CHECK(flowGuardSample(g, flowSample(t, FLOW_QUALITY_VALID)));
+     CHECK(updateFlowGuard(g, t + FLOW_OUTAGE_US) == FLOW_PATH_OK);
+     CHECK(!flowGuardSample(g, flowSample(t + 1000, FLOW_QUALITY_STALE)));
+     CHECK(!flowGuardSample(g, flowSample(t + 2000, FLOW_QUALITY_MISSING)));
+     CHECK(g.staleSamples == 1 && g.missingSamples == 1);
+     CHECK(updateFlowGuard(g, t + FLOW_OUTAGE_US + 1) == FLOW_PATH_HOLDOVER);
+     CHECK(g.outages == 1 && g.faults == 0);
+     CHECK(updateFlowGuard(g, t + holdoverUs - 1000) == FLOW_PATH_HOLDOVER);
+     CHECK(updateFlowGuard(g, t + holdoverUs) == FLOW_PATH_FAULT);
+     CHECK(g.faults == 1 && g.outageMs == FLOW_HOLDOVER_MS);
+     CHECK(updateFlowGuard(g, t + holdoverUs + 50000) == FLOW_PATH_FAULT);
+     CHECK(g.outages == 1 && g.faults == 1);
+     t += holdoverUs + 60000;
+     flowGuardSample(g, flowSample(t, FLOW_QUALITY_VALID));
+     CHECK(updateFlowGuard(g, t + 1000) == FLOW_PATH_OK);
+     CHECK(g.outageMs == 0 && g.maxOutageMs == FLOW_HOLDOVER_MS + 50);
+
+     // A short outage recovers without a fault
+     CHECK(updateFlowGuard(g, t + FLOW_OUTAGE_US + 1) == FLOW_PATH_HOLDOVER);
+     flowGuardSample(g, flowSample(t + 2 * FLOW_OUTAGE_US, FLOW_QUALITY_VALID));
+     CHECK(updateFlowGuard(g, t + 2 * FLOW_OUTAGE_US) == FLOW_PATH_OK);
+     CHECK(g.outages == 2 && g.faults == 1);
+
+     // No sample at all: the start-up allowance, then the same stop
+     t = 1000;
+     initFlowGuard(g, t);
+     CHECK(updateFlowGuard(g, t + startupUs + FLOW_OUTAGE_US) == FLOW_PATH_OK);
+     CHECK(updateFlowGuard(g, t + startupUs + FLOW_OUTAGE_US + 1) == FLOW_PATH_HOLDOVER);
+     CHECK(updateFlowGuard(g, t + startupUs + holdoverUs) == FLOW_PATH_FAULT);
+     CHECK(g.faults == 1);
+
+     // Across the 32-bit micros() wrap
+     t = 0xFFFFFFFFu - 10000;
+     initFlowGuard(g, t);
+     flowGuardSample(g, flowSample(t, FLOW_QUALITY_VALID));
+     CHECK(updateFlowGuard(g, t + FLOW_OUTAGE_US) == FLOW_PATH_OK);
+     CHECK(updateFlowGuard(g, t + holdoverUs) == FLOW_PATH_FAULT);
+     flowGuardSample(g, flowSample(t + holdoverUs, FLOW_QUALITY_VALID));
+     CHECK(updateFlowGuard(g, t + holdoverUs) == FLOW_PATH_OK);
+ }
+
+ /*──────────────────────── PUMP DRIVER ────────────────────────────────────*/
+ // Posts `volts` (or a stop, if negative) every control period for `ms`,
+ // as the control cycle does
+ static void drivePump(float volts, uint32_t ms)
+ {
+     for (uint32_t t = 0; t < ms * 1000; t += CONTROL_PERIOD_US) {
+         if (volts < 0.0f) stopPump(); else runSequence(volts);
+         serviceBartels();
+         hostAdvanceMicros(CONTROL_PERIOD_US);
+     }
+ }
+
+ static void checkPumpStop()
+ {
+     hostResetClock();
+     Wire.begin();
+     initI2cBus();
+     BartelsDriverSim pump;
+     hostI2cAttach(BARTELS_DRIVER_ADDR, &pump);
+     initBartels();
+     resetBartelsBusStats();
+
+     drivePump(60.0f, 500);
+     CHECK(pump.amplitudeVolts() > 50.0f);
+
+     // A clean stop: one configuration, then no traffic
+     drivePump(-1.0f, 500);
+     const BartelsBusStats &stats = getBartelsBusStats();
+     uint32_t tx = stats.transactions;
+     CHECK(pump.amplitudeVolts() == 0.0f && stats.stopsFailed == 0);
+     drivePump(-1.0f, 1000);
+     CHECK(stats.transactions == tx);
+
+     // Dead driver: the stop is retried with a doubling back-off
+     // (80, 160, ... ms, capped at 5 s), not every control cycle
+     drivePump(60.0f, 500);
+     pump.setSilent(true);
+     drivePump(-1.0f, 10000);
+     CHECK(stats.stopsFailed >= 6 && stats.stopsFailed <= 8);
+     uint32_t failed = stats.stopsFailed;
+     drivePump(-1.0f, 10000);
+     CHECK(stats.stopsFailed == failed + 2);                  // capped at 5 s
+
+     // The driver answers again: the next retry goes through, then quiet
+     pump.setSilent(false);
+     drivePump(-1.0f, 6000);
+     CHECK(pump.amplitudeVolts() == 0.0f);
+     failed = stats.stopsFailed;
+     tx     = stats.transactions;
+     drivePump(-1.0f, 10000);
+     CHECK(stats.stopsFailed == failed && stats.transactions == tx);
+
+     hostI2cDetach(BARTELS_DRIVER_ADDR);
+ }
+
+ int main()
+ {
+     hostSerialSetOutput(nullptr);
+
+     checkCrc();
+     checkCobs();
+     checkHalf();
+     checkTelemetry();
+     checkTxBuffer();
+     checkSettings();
+     checkFlowGuard();
+     checkPumpStop();
+
+     printf("[CHECKS] %d checks, %d failed\n", s_checks, s_failures);
+     return s_failures ? 1 : 0;
+ }
@@ -0,0 +1,161 @@
+/*
+ * File: host_main.cpp
+ * Brief: Runs the controller on the host, faster than real time.
+ *
+ *   controller_host [--seconds S] [--setpoint mL/min] [--error-pct P]
+ *                   [--seed N] [--const] [--json | --binary] [--baud B]
+ *                   [--subscribe LIST] [--dropout T:MS] [--profile]
+ *
+ *   The button on D6 switches the system on at t = 0; the loop then runs
+ *   S seconds of virtual time against the fitted plant model (plant_sim.h)
+ *   and reports the step response, the speed-up over real time and the
+ *   wall-clock cost of the control cycle. --seed draws this run's plant
+ *   gain and pump phase from the fitted spread (0 = nominal plant).
+ *   --json prints the firmware's telemetry lines to stdout, --binary its
+ *   binary telemetry frames (pipe into controller_telemetry to read them).
+ *   --baud limits the telemetry to what a serial link of that rate drains
+ *   (10 bits per byte), to see records dropped and counted in "txDrop".
+ *   --subscribe takes the serial 'S' command's field list, e.g.
+ *   "flow,setpt,pGain:50" (divisors in ≈ 6.7 ms telemetry runs).
+ *   --dropout silences the flow sensor for MS milliseconds from T seconds,
+ *   to watch the hold-over and fault handling (flow_guard.h); with T = 0
+ *   the sensor is already missing at setup.
+ *   --profile prints the per-stage cycle profile (serial 'P') and the I2C
+ *   occupancy per device (serial 'I') at the end.
+ */
+
+ #include "host_rig.h"
+ #include "plant_sim.h"
+ #include "profiler.h"
+ #include "i2c_bus.h"
+ #include "step_metrics.h"
+ #include <Arduino.h>
+ #include <Wire.h>
+ #include <chrono>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+
+ static HostRig  s_rig;
+ static PlantSim s_plant;
+
+ // Firmware printers (printProfile) onto stderr
+ class StderrPrint : public Print {
+ public:
+     using Print::write;
+     size_t write(uint8_t c) override { return fputc(c, stderr) == EOF ? 0 : 1; }
+ };
+
+ int main(int argc, char **argv)
+ {
+     double      seconds  = 60.0;
+     float       setpoint = 1.0f;
+     float       errorPct = 0.0f;
+     ControlMode mode     = CONTROL_MODE_EXP;
+     bool        json     = false;
+     bool        binary   = false;
+     uint64_t    seed     = 0;
+     double      baud     = 0.0;
+     const char *fields   = nullptr;
+     bool        profile  = false;
+     const char *dropout  = nullptr;
+
+     for (int i = 1; i < argc; i++) {
+         if      (!strcmp(argv[i], "--seconds")   && i + 1 < argc) seconds  = atof(argv[++i]);
+         else if (!strcmp(argv[i], "--setpoint")  && i + 1 < argc) setpoint = (float)atof(argv[++i]);
+         else if (!strcmp(argv[i], "--error-pct") && i + 1 < argc) errorPct = (float)atof(argv[++i]);
+         else if (!strcmp(argv[i], "--seed")      && i + 1 < argc) seed     = strtoull(argv[++i], nullptr, 0);
+         else if (!strcmp(argv[i], "--baud")      && i + 1 < argc) baud     = atof(argv[++i]);
+         else if (!strcmp(argv[i], "--subscribe") && i + 1 < argc) fields   = argv[++i];
+         else if (!strcmp(argv[i], "--dropout")   && i + 1 < argc) dropout  = argv[++i];
+         else if (!strcmp(argv[i], "--const"))  mode = CONTROL_MODE_CONST_VOLTAGE;
+         else if (!strcmp(argv[i], "--json"))   json = true;
+         else if (!strcmp(argv[i], "--binary")) binary = true;
+         else if (!strcmp(argv[i], "--profile")) profile = true;
+         else {
+             fprintf(stderr, "usage: %s [--seconds S] [--setpoint F] [--error-pct P] [--seed N] [--const] [--json | --binary] [--baud B] [--subscribe LIST] [--dropout T:MS] [--profile]\n", argv[0]);
+             return 2;
+         }
+     }
+
+     double dropoutS = -1.0, dropoutMs = 0.0;
+     if (dropout && sscanf(dropout, "%lf:%lf", &dropoutS, &dropoutMs) != 2) {
+         fprintf(stderr, "[HOST] bad --dropout (want T:MS): %s\n", dropout);
+         return 2;
+     }
+     const double dropoutEnd = dropoutS + dropoutMs * 1e-3;
+
+     if (!json && !binary) hostSerialSetOutput(nullptr);
+     setHostRigLog(stderr);
+     s_rig.sensor.setSilent(dropoutS <= 0.0 && dropoutEnd > 0.0);   // absent at boot
+     initHostRig(s_rig, setpoint, errorPct, mode);
+     s_rig.telemetry       = json;
+     s_rig.binaryTelemetry = binary;
+     s_rig.linkBytesPerSec = baud / 10.0;
+     if (binary) subscribeAllTelemetry(s_rig.subscription, 1);
+     const char *badField = nullptr;
+     if (fields && !parseTelemetrySubscription(fields, s_rig.subscription, &badField)) {
+         fprintf(stderr, "[HOST] bad --subscribe item: %s\n", badField);
+         return 2;
+     }
+     pressHostButton(s_rig, D6);
+
+     const double dt    = SCHED_TICK_US * 1e-6;
+     const uint32_t end = (uint32_t)(seconds / dt);
+     initPlantSim(s_plant, defaultPlantParams(), dt, seed);
+
+     StepMetrics step;
+     initStepMetrics(step, setpoint, 0.05f, 0.8 * seconds);
+
+     uint64_t controlNs = 0, maxControlNs = 0, cycles = 0;
+     auto wallStart = std::chrono::steady_clock::now();
+
+     while (s_rig.tick < end) {
+         stepPlantSim(s_plant, s_rig.pump.amplitudeVolts(), dt);
+         s_rig.sensor.setFlow(plantSensorFlow(s_plant));
+         double t = hostRigTimeSec(s_rig);
+         s_rig.sensor.setSilent(t >= dropoutS && t < dropoutEnd);
+         addStepSample(step, t, dt, s_plant.meanFlow);
+
+         auto t0 = std::chrono::steady_clock::now();
+         uint32_t ran = stepHostRig(s_rig);
+         auto t1 = std::chrono::steady_clock::now();
+
+         if (ran & HOST_RAN_CONTROL) {
+             uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+             controlNs += ns;
+             if (ns > maxControlNs) maxControlNs = ns;
+             cycles++;
+         }
+     }
+
+     // Let the link finish what was already queued
+     size_t queued = s_rig.tx.pending();
+     s_rig.tx.drain(Serial, queued);
+
+     double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+     const HostI2cStats &bus = hostI2cStats();
+
+     fprintf(stderr, "[HOST] step 0 -> %.3f mL/min: rise=%.2f s overshoot=%.1f%% settle(5%%)=%.2f s "
+                     "IAE=%.3f tail mean=%+.4f rms=%.4f\n",
+             setpoint, step.riseS, stepOvershootPct(step), step.settleS,
+             step.iae, stepTailMean(step), stepTailRms(step));
+     fprintf(stderr, "[HOST] simulated %.1f s in %.3f s wall (x%.0f real time)\n",
+             hostRigTimeSec(s_rig), wall, wall > 0 ? hostRigTimeSec(s_rig) / wall : 0.0);
+     fprintf(stderr, "[HOST] control cycles=%llu mean=%.0f ns max=%llu ns (tick incl. sensor/buttons)\n",
+             (unsigned long long)cycles, cycles ? (double)controlNs / cycles : 0.0,
+             (unsigned long long)maxControlNs);
+     fprintf(stderr, "[HOST] i2c txns=%u bytes=%u nacks=%u busy=%.1f%%\n",
+             bus.transactions, bus.bytes, bus.nacks,
+             100.0 * bus.busTimeUs / (hostRigTimeSec(s_rig) * 1e6));
+     if (json || binary)
+         fprintf(stderr, "[HOST] telemetry records dropped=%u\n", s_rig.tx.dropped());
+     fprintf(stderr, "[HOST] final flow=%.3f setpoint=%.3f volt=%.1f\n",
+             s_rig.state.flow, s_rig.state.setpoint, s_rig.state.desiredVoltage);
+     if (profile) {
+         StderrPrint err;
+         printProfile(err);
+         printI2cBusStats(err);
+     }
+     return 0;
+ }
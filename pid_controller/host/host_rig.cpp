@@ -0,0 +1,199 @@
+/*
+ * File: host_rig.cpp
+ * Brief: Host-side scheduler loop around the unmodified control sources.
+ */
+
+ #include "host_rig.h"
+ #include "bartels.h"
+ #include "buttons.h"
+ #include "constant_voltage_control.h"
+ #include "display.h"
+ #include "exp_control.h"
+ #include "i2c_bus.h"
+ #include "log.h"
+ #include "profiler.h"
+ #include "report.h"
+ #include "settings.h"
+ #include "trend.h"
+ #include <Arduino.h>
+ #include <EEPROM.h>
+ #include <Wire.h>
+
+ // Log sink of the controller sources on this thread (LOG_*)
+ class HostLogSink : public Print {
+ public:
+     FILE *out = nullptr;   // nullptr = discard
+
+     using Print::write;
+     size_t write(uint8_t c) override
+     {
+         if (out) fputc(c, out);
+         return 1;
+     }
+     size_t write(const uint8_t *buf, size_t n) override
+     {
+         if (out) fwrite(buf, 1, n, out);
+         return n;
+     }
+ };
+ static MODULE_STATE HostLogSink s_logSink;
+
+ // Pin held low by pressHostButton(), released once the press is debounced
+ // and seen by updateButtons()
+ static MODULE_STATE int      s_pressedPin     = -1;
+ static MODULE_STATE uint32_t s_releaseAtTick  = 0;
+
+ // Debounced press + release (used to force a known state)
+ static void tapButton(uint8_t pin)
+ {
+     hostSetPin(pin, LOW);
+     for (uint8_t i = 0; i < BUTTON_DEBOUNCE_SAMPLES; i++) sampleButtons();
+     updateButtons();
+     hostSetPin(pin, HIGH);
+     for (uint8_t i = 0; i < BUTTON_DEBOUNCE_SAMPLES; i++) sampleButtons();
+     updateButtons();
+ }
+
+ void initHostRig(HostRig &rig, float setpoint, float errorPct, ControlMode mode)
+ {
+     hostResetClock();
+     hostI2cResetStats();
+     s_pressedPin = -1;
+     logAttachCurrentTask(s_logSink);
+
+     Wire.begin();
+     Wire.setClock(I2C_CLOCK_HZ);
+     initI2cBus();
+     EEPROM.begin(SETTINGS_EEPROM_SIZE);
+     initSettings();
+     Settings seed     = currentSettings();
+     seed.setpoint     = setpoint;
+     seed.errorPercent = errorPct;
+     seed.controlMode  = mode;
+     changeSettings(seed);
+
+     hostI2cAttach(SLF_FLOW_SENSOR_ADDR, &rig.sensor);
+     hostI2cAttach(BARTELS_DRIVER_ADDR,  &rig.pump);
+     hostI2cAttach(SSD1306_DISPLAY_ADDR, &rig.display);
+
+     initButtons();
+     if (isSystemOn()) tapButton(D6);   // left on by an earlier run on this thread
+     initBartels();
+     resetBartelsBusStats();
+     initDisplay();
+     initTrend();
+
+     rig.state = {};
+     initExpController(rig.state);
+     initConstantVoltageControl();
+     rig.mode = mode;
+     rig.state.controlMode = mode;
+     rig.telemetry = false;
+     rig.binaryTelemetry = false;
+     subscribeAllTelemetry(rig.subscription, TELEMETRY_DIVIDER / TELEMETRY_BINARY_DIVIDER);
+     rig.telemetryRuns = 0;
+     rig.linkBytesPerSec = 0.0;
+     rig.linkCredit = 0.0;
+     rig.tick = 0;
+
+     startFlowMeasurement();
+
+     initControlCycle(rig.cycle, rig.flowRing);
+ }
+
+ void setHostRigLog(FILE *out)
+ {
+     s_logSink.out = out;
+ }
+
+ void pressHostButton(HostRig &rig, uint8_t pin)
+ {
+     hostSetPin(pin, LOW);
+     s_pressedPin    = pin;
+     s_releaseAtTick = rig.tick + BUTTON_DEBOUNCE_SAMPLES + BUTTONS_DIVIDER;
+ }
+
+ double hostRigTimeSec(const HostRig &rig)
+ {
+     return (double)rig.tick * SCHED_TICK_US * 1e-6;
+ }
+
+ /*──────────────────────── SERIAL LINK ────────────────────────────────────*/
+
+ // Sends what the link rate allows this tick; an idle link banks no credit
+ static void drainHostLink(HostRig &rig)
+ {
+     size_t room = rig.tx.pending();
+     if (rig.linkBytesPerSec > 0.0) {
+         rig.linkCredit += rig.linkBytesPerSec * SCHED_TICK_US * 1e-6;
+         if (room > (size_t)rig.linkCredit) room = (size_t)rig.linkCredit;
+     }
+     size_t budget = room;
+     rig.tx.drain(Serial, room);
+     if (rig.linkBytesPerSec > 0.0) {
+         rig.linkCredit -= (double)(budget - room);
+         if (rig.tx.pending() == 0 && rig.linkCredit > 1.0) rig.linkCredit = 1.0;
+     }
+ }
+
+ /*──────────────────────── BASE TICK ──────────────────────────────────────*/
+ uint32_t stepHostRig(HostRig &rig)
+ {
+     uint32_t ran  = 0;
+     uint32_t tick = rig.tick;
+     hostSetMicros((uint64_t)tick * SCHED_TICK_US);
+
+     if (tick % SENSOR_DIVIDER == 0) {
+         PROFILE_SCOPE(PROF_SENSOR);
+         FlowSample &slot = rig.flowRing.writeSlot();
+         if (acquireFlowSample(slot)) rig.flowRing.publish();
+         ran |= HOST_RAN_SENSOR;
+     }
+
+     if (s_pressedPin >= 0 && tick >= s_releaseAtTick) {
+         hostSetPin((uint8_t)s_pressedPin, HIGH);
+         s_pressedPin = -1;
+     }
+     sampleButtons();   // the firmware's sampling timer, at base-tick rate here
+     if (tick % BUTTONS_DIVIDER == 0) {
+         PROFILE_SCOPE(PROF_BUTTONS);
+         updateButtons();
+         serviceSettings(isSystemOn());
+         ran |= HOST_RAN_BUTTONS;
+     }
+
+     if (tick % CONTROL_DIVIDER == 0) {
+         runControlCycle(rig.cycle, rig.flowRing, rig.state, rig.mode);
+         ran |= HOST_RAN_CONTROL;
+     }
+
+     if ((rig.telemetry || rig.binaryTelemetry) && tick % TELEMETRY_BINARY_DIVIDER == 0) {
+         PROFILE_SCOPE(PROF_TELEMETRY);
+         uint32_t fields = dueTelemetryFields(rig.subscription, rig.telemetryRuns++);
+         rig.state.txDrops = rig.tx.dropped();
+         if (fields && rig.binaryTelemetry) {
+             rig.tx.beginRecord();
+             reportStateBinary(rig.state, fields, rig.tx);
+             rig.tx.endRecord();
+         } else if (fields) {
+             reportStateJSON(rig.state, fields, rig.tx);
+         }
+         if (fields) ran |= HOST_RAN_TELEMETRY;
+     }
+     drainHostLink(rig);
+
+     if (tick % DISPLAY_DIVIDER == 0) {
+         showStatus(rig.state.flow, rig.state.setpoint, rig.state.errorPercent,
+                    rig.state.desiredVoltage, rig.state.systemOn,
+                    rig.state.temperature, rig.state.bubbleDetected);
+         ran |= HOST_RAN_DISPLAY;
+     }
+     if (tick % IO_TICK_DIVIDER == 0) {
+         pushTrendSample(rig.state.flow, rig.state.setpoint);
+         PROFILE_SCOPE(PROF_DISPLAY);
+         serviceDisplay();
+     }
+
+     rig.tick++;
+     return ran;
+ }
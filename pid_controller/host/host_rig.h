@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "config.h"
+#include "control_cycle.h"
+#include "system_state.h"
+#include "sim_devices.h"
+#include "tx_buffer.h"
+#include "telemetry.h"
+
+/*
+ * File: host_rig.h
+ * Brief: The firmware's scheduled activities driven from a plain loop on
+ *        the host, against simulated devices and the virtual clock.
+ *
+ *   One stepHostRig() call is one base tick (SCHED_TICK_US). Activities
+ *   run on the same dividers and in the same order as on the target:
+ *   acquisition, then buttons, then the control cycle (control_cycle.cpp,
+ *   the code the sketch's control task runs). Whatever drives the flow (a
+ *   plant model, a replay) updates rig.sensor between steps and reads
+ *   rig.pump back.
+ *
+ *   Telemetry goes through the sketch's I/O TxBuffer. With linkBytesPerSec
+ *   set, it is drained at that rate, as a serial link would, so buffer
+ *   overflow and the txDrop count can be reproduced; 0 drains it every tick.
+ */
+
+// Bits returned by stepHostRig(): which activities ran this tick
+enum {
+    HOST_RAN_SENSOR    = 1 << 0,
+    HOST_RAN_BUTTONS   = 1 << 1,
+    HOST_RAN_CONTROL   = 1 << 2,
+    HOST_RAN_TELEMETRY = 1 << 3,
+    HOST_RAN_DISPLAY   = 1 << 4
+};
+
+struct HostRig {
+    SlfSensorSim     sensor;
+    BartelsDriverSim pump;
+    Ssd1306Sim       display;
+
+    FlowRing         flowRing;
+    ControlCycle     cycle;
+
+    SystemState      state;
+    ControlMode      mode;
+    bool             telemetry;        // JSON reports
+    bool             binaryTelemetry;  // binary frames instead
+    TelemetrySubscription subscription;   // fields and rates (default: all, 25 Hz)
+    uint32_t         telemetryRuns;
+    TxBuffer<TX_IO_BUFFER_SIZE> tx;    // telemetry output, drained to Serial
+    double           linkBytesPerSec;  // drain rate (0 = unlimited)
+    double           linkCredit;       // bytes the link may still send
+    uint32_t         tick;
+};
+
+// Seeds EEPROM with the setpoint/error%, attaches the devices and runs the
+// same initialisation as setup(). Resets the virtual clock and leaves the
+// system off, so a thread can run any number of simulations back to back.
+void initHostRig(HostRig &rig, float setpoint, float errorPct, ControlMode mode);
+
+// Sends the log lines (LOG_*) of this thread's rig to `out`, e.g. stderr;
+// nullptr (the default) discards them
+void setHostRigLog(FILE *out);
+
+// Holds a button pin low until the debounced press is applied (next stepHostRig calls)
+void pressHostButton(HostRig &rig, uint8_t pin);
+
+// Runs one base tick; returns HOST_RAN_* bits
+uint32_t stepHostRig(HostRig &rig);
+
+// Virtual time of the current tick in seconds
+double hostRigTimeSec(const HostRig &rig);
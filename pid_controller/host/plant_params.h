@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * File: plant_params.h
+ * Brief: Plant model parameters fitted from the recorded runs.
+ *
+ *   GENERATED by curve_tools/fit_plant.py – rerun it after adding runs
+ *   instead of editing by hand. Median over the runs marked '*':
+ *
+ *   run                                         n     K       V0    tau   L     drift/h  R2
+ *   * demo_1_RodePeters_20250508_111236            289 0.00602   0.0  0.61 0.80   5.429  0.98
+ *   * demo_1_RodePeters_20250509_153728           2154 0.00583   0.0  0.33 0.00   0.468  0.82
+ *   * demo_1_RodePeters_20250509_154650           1309 0.00550   2.5  0.18 0.30   0.900  0.99
+ *     demo_1_RodePeters_20250509_162814           8141 0.00377   0.0  0.14 1.80  -1.002 -0.11
+ *     demo_1_RodePeters_20250509_165635           1645 0.00512   0.0  0.10 0.15   0.050 -7.08
+ *     demo_1_RodePeters_20250509_170211          13194 0.00409   0.0  2.01 0.00  -0.256 -0.52
+ *   * cartridge_flow_test_0.50_RodePeters_202504 11659 0.00664   0.0  0.45 0.80   0.028  0.72
+ *   * cartridge_flow_test_0.75_RodePeters_202504 14579 0.00629   0.0  0.33 0.80   0.086  0.79
+ *   * cartridge_flow_test_1.0_RodePeters_2025042 11295 0.00611   0.0  0.61 0.80   0.059  0.87
+ *     cartridge_flow_test_1.25_RodePeters_202504 13906 0.00607   0.0  1.10 0.50   0.255 -0.74
+ *     cartridge_flow_test_1.50_RodePeters_202504 11538 0.00471   0.0  0.33 1.80  -0.001 -7.23
+ *     cartridge_flow_test_cal_RodePeters_2025042 14640 0.00790   0.0  0.10 0.50   0.343  0.36
+ *
+ *   Pulsation at BARTELS_FREQ is not visible in ~6 Hz logs; its amplitude
+ *   is an assumption and the sensor noise is what remains of the residual.
+ */
+
+static const float PLANT_GAIN_MLMIN_PER_V = 0.006066f;   // K
+static const float PLANT_DEADBAND_V       = 0.00f;      // V0
+static const float PLANT_TAU_S            = 0.390f;     // fluidic lag
+static const float PLANT_DELAY_S          = 0.800f;     // transport delay
+static const float PLANT_DRIFT_PER_HOUR   = 0.2767f;    // gain loss while pumping
+static const float PLANT_GAIN_SPREAD      = 0.0588f;    // run-to-run std of K / K
+static const float PLANT_PULSE_REL        = 0.100f;     // ripple amplitude / mean flow (assumed)
+static const float PLANT_SENSOR_NOISE     = 0.00221f;   // mL/min, 1 sigma per read
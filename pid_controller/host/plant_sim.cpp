@@ -0,0 +1,100 @@
+/*
+ * File: plant_sim.cpp
+ * Brief: Pump + fluidics plant model (see plant_sim.h).
+ */
+
+ #include "plant_sim.h"
+ #include "plant_params.h"
+ #include "config.h"
+ #include <math.h>
+ #include <string.h>
+
+ // xorshift64* — deterministic per seed, no global state
+ static uint64_t nextRandom(uint64_t &s)
+ {
+     s ^= s >> 12;
+     s ^= s << 25;
+     s ^= s >> 27;
+     return s * 2685821657736338717ULL;
+ }
+
+ static double uniform01(uint64_t &s)
+ {
+     return ((nextRandom(s) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+ }
+
+ static float gaussian(uint64_t &s)
+ {
+     double u1 = uniform01(s), u2 = uniform01(s);
+     return (float)(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2));
+ }
+
+ PlantParams defaultPlantParams()
+ {
+     PlantParams p;
+     p.gainMlMinPerV = PLANT_GAIN_MLMIN_PER_V;
+     p.deadbandV     = PLANT_DEADBAND_V;
+     p.tauS          = PLANT_TAU_S;
+     p.delayS        = PLANT_DELAY_S;
+     p.driftPerHour  = PLANT_DRIFT_PER_HOUR;
+     p.pulseRel      = PLANT_PULSE_REL;
+     p.sensorNoise   = PLANT_SENSOR_NOISE;
+     return p;
+ }
+
+ void initPlantSim(PlantSim &sim, const PlantParams &p, double dtS, uint64_t seed)
+ {
+     memset(&sim, 0, sizeof(sim));
+     sim.p   = p;
+     sim.rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+
+     sim.gain = p.gainMlMinPerV;
+     if (seed) {
+         sim.gain *= 1.0f + PLANT_GAIN_SPREAD * gaussian(sim.rng);
+         if (sim.gain < 0.0f) sim.gain = 0.0f;
+         sim.phase = uniform01(sim.rng);
+     }
+
+     uint32_t steps = (uint32_t)lround(p.delayS / dtS);
+     sim.delaySteps = steps < PLANT_DELAY_SLOTS ? steps : PLANT_DELAY_SLOTS - 1;
+ }
+
+ float stepPlantSim(PlantSim &sim, float driveV, double dtS)
+ {
+     const PlantParams &p = sim.p;
+
+     // The driver applies a new amplitude at the start of a pump cycle
+     sim.phase += dtS * BARTELS_FREQ;
+     if (sim.phase >= 1.0) {
+         sim.phase -= floor(sim.phase);
+         sim.latchedV = driveV;
+     }
+
+     float drive = sim.latchedV - p.deadbandV;
+     if (drive < 0.0f) drive = 0.0f;
+     if (drive > 0.0f) sim.pumpingS += dtS;
+
+     float drift  = 1.0f - p.driftPerHour * (float)(sim.pumpingS / 3600.0);
+     if (drift < 0.0f) drift = 0.0f;
+     float target = sim.gain * drift * drive;
+
+     // Transport delay, then the fluidic lag
+     float delayed = target;
+     if (sim.delaySteps > 0) {
+         uint32_t out = (sim.delayIdx + PLANT_DELAY_SLOTS - sim.delaySteps) % PLANT_DELAY_SLOTS;
+         delayed = sim.delay[out];
+         sim.delay[sim.delayIdx] = target;
+         sim.delayIdx = (sim.delayIdx + 1) % PLANT_DELAY_SLOTS;
+     }
+     float a = (p.tauS > 0.0f) ? (float)(1.0 - exp(-dtS / p.tauS)) : 1.0f;
+     sim.meanFlow += a * (delayed - sim.meanFlow);
+
+     sim.timeS += dtS;
+     return sim.meanFlow * (1.0f + p.pulseRel * (float)sin(2.0 * M_PI * sim.phase));
+ }
+
+ float plantSensorFlow(PlantSim &sim)
+ {
+     float flow = sim.meanFlow * (1.0f + sim.p.pulseRel * (float)sin(2.0 * M_PI * sim.phase));
+     return flow + sim.p.sensorNoise * gaussian(sim.rng);
+ }
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * File: plant_sim.h
+ * Brief: Pump + fluidics plant for closed-loop runs on the host.
+ *
+ *   drive (V, as programmed in the driver's 8-bit amplitude register)
+ *     → amplitude latched at the next pump cycle (BARTELS_FREQ)
+ *     → dead band, gain K (with run-to-run spread and slow drift)
+ *     → transport delay L → first-order fluidic lag tau
+ *     → stroke pulsation at BARTELS_FREQ
+ *     → sensor noise (SLF3S scaling/quantization is applied by SlfSensorSim)
+ *
+ *   Default parameters come from plant_params.h, fitted to the recorded
+ *   runs by curve_tools/fit_plant.py.
+ */
+
+struct PlantParams {
+    float gainMlMinPerV;
+    float deadbandV;
+    float tauS;
+    float delayS;
+    float driftPerHour;
+    float pulseRel;
+    float sensorNoise;     // mL/min, 1 sigma
+};
+
+static const uint32_t PLANT_DELAY_SLOTS = 4096;   // delay line length (steps)
+
+struct PlantSim {
+    PlantParams p;
+    float    gain;           // K for this run (spread applied)
+    float    latchedV;       // amplitude the pump is running at
+    float    meanFlow;       // lag state, mL/min
+    double   phase;          // pump cycle phase [0, 1)
+    double   pumpingS;       // time with the pump driven (for drift)
+    double   timeS;
+    float    delay[PLANT_DELAY_SLOTS];
+    uint32_t delayIdx;
+    uint32_t delaySteps;
+    uint64_t rng;
+};
+
+// Parameters from plant_params.h
+PlantParams defaultPlantParams();
+
+// dtS is the step used for every stepPlantSim() call; seed != 0 also draws
+// this run's gain from the fitted run-to-run spread
+void initPlantSim(PlantSim &sim, const PlantParams &p, double dtS, uint64_t seed);
+
+// Advances by dtS with the pump driven at driveV; returns the true
+// instantaneous flow (mean + pulsation), mL/min
+float stepPlantSim(PlantSim &sim, float driveV, double dtS);
+
+// What the sensor reports right now (instantaneous flow + noise)
+float plantSensorFlow(PlantSim &sim);
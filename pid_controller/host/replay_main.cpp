@@ -0,0 +1,234 @@
+/*
+ * File: replay_main.cpp
+ * Brief: Replays recorded runs through the control hot path.
+ *
+ *   controller_replay [--repeat N] [--save-ref FILE] [--check-ref FILE] run.csv...
+ *
+ *   Each stage is fed the recorded value of its own input, at the
+ *   recorded timestamps, so a change in one stage does not smear into the
+ *   next:
+ *     filter  setpt − flow          → updateTwoPoleFilter()  vs filteredErr, currentAlpha
+ *     gains   |filteredErr|         → computeExpGains()      vs pGain, iGain, dGain
+ *     pid     filteredErr + gains   → stepExpPid()           vs pidOut
+ *   (exp_control's integrator rescale, PID update and clamp).
+ *
+ *   The logs hold 3 decimals and older firmware, so the diff against them
+ *   is a sanity check. For refactors, --save-ref writes the recomputed
+ *   values as exact hex floats and --check-ref compares a later build
+ *   against them bit for bit (exit code 1 on any mismatch). Every stage is
+ *   also timed over N passes of each run and reported in ns/sample.
+ */
+
+ #include "trace_csv.h"
+ #include "exp_control.h"
+ #include "filter.h"
+ #include "pid.h"
+ #include <Arduino.h>
+ #include <algorithm>
+ #include <chrono>
+ #include <math.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <vector>
+
+ static const float LOG_RESOLUTION = 0.0005f;   // half of the logged 3rd decimal
+
+ enum { OUT_FILTERED_ERR = 0, OUT_ALPHA, OUT_KP, OUT_KI, OUT_KD, OUT_PID, OUT_COUNT };
+ static const char *const OUT_NAMES[OUT_COUNT] = {
+     "filteredErr", "currentAlpha", "pGain", "iGain", "dGain", "pidOut"
+ };
+
+ enum { STAGE_FILTER = 0, STAGE_GAINS, STAGE_PID, STAGE_COUNT };
+ static const char *const STAGE_NAMES[STAGE_COUNT] = { "filter", "gains", "pid" };
+
+ struct ReplayOut { float v[OUT_COUNT]; };
+
+ struct FieldDiff {
+     double maxAbs;
+     double sumSq;
+     uint32_t within;    // |Δ| ≤ LOG_RESOLUTION
+     uint32_t n;
+ };
+
+ /*──────────────────────── STAGES ─────────────────────────────────────────*/
+ static float recordedField(const TraceRow &r, int k)
+ {
+     switch (k) {
+         case OUT_FILTERED_ERR: return r.filteredErr;
+         case OUT_ALPHA:        return r.currentAlpha;
+         case OUT_KP:           return r.pGain;
+         case OUT_KI:           return r.iGain;
+         case OUT_KD:           return r.dGain;
+         default:               return r.pidOut;
+     }
+ }
+
+ static void runFilterStage(const std::vector<TraceRow> &rows, std::vector<ReplayOut> &out)
+ {
+     TwoPoleFilter f;
+     initTwoPoleFilter(f);
+     for (size_t i = 0; i < rows.size(); i++) {
+         if (rows[i].segmentStart) initTwoPoleFilter(f);
+         out[i].v[OUT_FILTERED_ERR] = updateTwoPoleFilter(f, rows[i].setpoint - rows[i].flow);
+         out[i].v[OUT_ALPHA]        = f.dyn.currentAlpha;
+     }
+ }
+
+ static void runGainStage(const std::vector<TraceRow> &rows, std::vector<ReplayOut> &out)
+ {
+     for (size_t i = 0; i < rows.size(); i++)
+         computeExpGains(fabsf(rows[i].filteredErr), out[i].v[OUT_KP], out[i].v[OUT_KI], out[i].v[OUT_KD]);
+ }
+
+ // micros() follows the recording; a reboot mid-log restarts the clock
+ static void setTraceClock(uint32_t timeMs)
+ {
+     uint64_t us = (uint64_t)timeMs * 1000;
+     if (us < hostMicros()) hostResetClock();
+     hostSetMicros(us);
+ }
+
+ // Step 4 of updateExpController(), with the logged error and gains
+ static void runPidStage(const std::vector<TraceRow> &rows, std::vector<ReplayOut> &out)
+ {
+     float lastKi = 0.0f;
+     hostResetClock();
+     for (size_t i = 0; i < rows.size(); i++) {
+         const TraceRow &r = rows[i];
+         setTraceClock(r.timeMs);
+         if (r.segmentStart) { initPID(); lastKi = 0.0f; }
+
+         float p, in, d;
+         out[i].v[OUT_PID] = stepExpPid(r.filteredErr, r.pGain, r.iGain, r.dGain, lastKi, p, in, d);
+     }
+ }
+
+ typedef void (*StageFn)(const std::vector<TraceRow> &, std::vector<ReplayOut> &);
+ static const StageFn STAGES[STAGE_COUNT] = { runFilterStage, runGainStage, runPidStage };
+
+ /*──────────────────────── REFERENCE FILE ─────────────────────────────────*/
+ // One line per row: "<file index> <row> <hex float> × OUT_COUNT"
+ static void saveReference(FILE *f, uint32_t file, const std::vector<ReplayOut> &out)
+ {
+     for (size_t i = 0; i < out.size(); i++) {
+         fprintf(f, "%u %zu", file, i);
+         for (int k = 0; k < OUT_COUNT; k++) fprintf(f, " %a", out[i].v[k]);
+         fprintf(f, "\n");
+     }
+ }
+
+ // Returns the number of mismatching rows; prints the first few
+ static uint32_t checkReference(FILE *f, uint32_t file, const char *name,
+                                const std::vector<ReplayOut> &out)
+ {
+     uint32_t bad = 0;
+     for (size_t i = 0; i < out.size(); i++) {
+         unsigned refFile;
+         size_t   refRow;
+         float    ref[OUT_COUNT];
+         bool ok = fscanf(f, "%u %zu", &refFile, &refRow) == 2 && refFile == file && refRow == i;
+         for (int k = 0; ok && k < OUT_COUNT; k++) {
+             char tok[64];
+             ok = fscanf(f, "%63s", tok) == 1;
+             ref[k] = ok ? strtof(tok, nullptr) : 0.0f;
+         }
+         if (!ok) {
+             fprintf(stderr, "[REPLAY] %s: reference ends or is out of step at row %zu\n", name, i);
+             return bad + (uint32_t)(out.size() - i);
+         }
+         for (int k = 0; k < OUT_COUNT; k++) {
+             if (memcmp(&ref[k], &out[i].v[k], sizeof(float)) == 0) continue;
+             if (bad < 5)
+                 fprintf(stderr, "[REPLAY] %s row %zu %s: %a (ref %a)\n",
+                         name, i, OUT_NAMES[k], out[i].v[k], ref[k]);
+             bad++;
+             break;
+         }
+     }
+     return bad;
+ }
+
+ /*──────────────────────── MAIN ───────────────────────────────────────────*/
+ int main(int argc, char **argv)
+ {
+     uint32_t repeat = 20;
+     const char *saveRef = nullptr, *checkRef = nullptr;
+     std::vector<const char *> paths;
+
+     for (int i = 1; i < argc; i++) {
+         const char *a = argv[i];
+         const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+         if      (!strcmp(a, "--repeat")    && v) { repeat = (uint32_t)std::max(1, atoi(v)); i++; }
+         else if (!strcmp(a, "--save-ref")  && v) { saveRef  = v; i++; }
+         else if (!strcmp(a, "--check-ref") && v) { checkRef = v; i++; }
+         else if (a[0] == '-') {
+             fprintf(stderr, "usage: %s [--repeat N] [--save-ref FILE] [--check-ref FILE] run.csv...\n",
+                     argv[0]);
+             return 2;
+         }
+         else paths.push_back(a);
+     }
+     if (paths.empty()) { fprintf(stderr, "[REPLAY] no runs given\n"); return 2; }
+
+     FILE *ref = nullptr;
+     if (saveRef || checkRef) {
+         ref = fopen(saveRef ? saveRef : checkRef, saveRef ? "w" : "r");
+         if (!ref) { fprintf(stderr, "[REPLAY] cannot open %s\n", saveRef ? saveRef : checkRef); return 2; }
+     }
+     hostSerialSetOutput(nullptr);
+
+     FieldDiff diff[OUT_COUNT] = {};
+     double   stageNs[STAGE_COUNT] = {};
+     uint64_t samples = 0;
+     uint32_t mismatches = 0;
+
+     std::vector<TraceRow>  rows;
+     std::vector<ReplayOut> out;
+     for (uint32_t fi = 0; fi < paths.size(); fi++) {
+         if (!loadTraceCsv(paths[fi], rows)) return 2;
+         if (rows.empty()) continue;
+         out.assign(rows.size(), ReplayOut{});
+
+         for (int s = 0; s < STAGE_COUNT; s++) {
+             auto t0 = std::chrono::steady_clock::now();
+             for (uint32_t r = 0; r < repeat; r++) STAGES[s](rows, out);
+             auto t1 = std::chrono::steady_clock::now();
+             stageNs[s] += std::chrono::duration<double, std::nano>(t1 - t0).count();
+         }
+         samples += (uint64_t)rows.size() * repeat;
+
+         for (size_t i = 0; i < rows.size(); i++)
+             for (int k = 0; k < OUT_COUNT; k++) {
+                 double d = fabs((double)out[i].v[k] - recordedField(rows[i], k));
+                 diff[k].maxAbs = std::max(diff[k].maxAbs, d);
+                 diff[k].sumSq += d * d;
+                 diff[k].within += d <= LOG_RESOLUTION;
+                 diff[k].n++;
+             }
+
+         if (saveRef)  saveReference(ref, fi, out);
+         if (checkRef) mismatches += checkReference(ref, fi, paths[fi], out);
+     }
+     if (ref) fclose(ref);
+
+     fprintf(stderr, "[REPLAY] %zu runs, %u rows with the system on, %u passes\n",
+             paths.size(), diff[0].n, repeat);
+     for (int k = 0; k < OUT_COUNT; k++) {
+         const FieldDiff &d = diff[k];
+         fprintf(stderr, "[REPLAY] %-12s vs log: max|d|=%.5f rms=%.5f within %.4f: %.1f%%\n",
+                 OUT_NAMES[k], d.maxAbs, d.n ? sqrt(d.sumSq / d.n) : 0.0, LOG_RESOLUTION,
+                 d.n ? 100.0 * d.within / d.n : 0.0);
+     }
+     for (int s = 0; s < STAGE_COUNT; s++)
+         fprintf(stderr, "[REPLAY] %-6s %.1f ns/sample\n", STAGE_NAMES[s],
+                 samples ? stageNs[s] / samples : 0.0);
+
+     if (saveRef) fprintf(stderr, "[REPLAY] reference written to %s\n", saveRef);
+     if (checkRef) {
+         fprintf(stderr, "[REPLAY] reference %s: %s (%u rows differ)\n", checkRef,
+                 mismatches ? "MISMATCH" : "bit-exact", mismatches);
+         if (mismatches) return 1;
+     }
+     return 0;
+ }
@@ -0,0 +1,30 @@
+/*
+ * File: runtime_tuning.cpp
+ * Brief: Per-thread parameter set for CONTROLLER_RUNTIME_TUNING builds.
+ */
+
+ #include "config.h"
+
+ thread_local TuningParams g_tuning = TUNING_DEFAULTS;
+
+ bool tuningParamsValid(const TuningParams &p)
+ {
+     if (!(p.kiB > 0.0f && p.kiK > p.kiA)) return false;
+     if (!(FILTER_SECONDARY_A2 >= 0.0f && p.filterK2 <= 1.0f &&
+           FILTER_SECONDARY_A2 < p.filterK2)) return false;
+     if (!(p.emaAlpha > 0.0f && p.emaAlpha <= 1.0f)) return false;
+
+     // f2' peaks at B2 = 1/T_REF with value (K2 − A2)·e⁻¹ / T_REF
+     double peak = (p.filterK2 - FILTER_SECONDARY_A2) * 0.36787944 / FILTER_T_REF;
+     return peak >= filterExpSlope(FILTER_T_REF, p.kiA, p.kiK, p.kiB);
+ }
+
+ bool setTuningParams(const TuningParams &p)
+ {
+     if (!tuningParamsValid(p)) return false;
+     g_tuning = p;
+     g_tuning.filterB2 = solveFilterB2(p.kiA, p.kiK, p.kiB,
+                                       FILTER_SECONDARY_A2, p.filterK2,
+                                       FILTER_T_REF);
+     return true;
+ }
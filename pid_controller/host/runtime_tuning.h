@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * File: runtime_tuning.h
+ * Brief: Per-thread gain-schedule/filter constants for host sweep builds.
+ *
+ *   Included at the end of config.h only when CONTROLLER_RUNTIME_TUNING is
+ *   defined. The names the controller sources use (EXP_KI_*, EMA_ALPHA,
+ *   FILTER_SECONDARY_K2, FILTER_B2) are redirected to g_tuning, so the same
+ *   source files run with different parameters on every sweep thread.
+ */
+
+struct TuningParams {
+    float kiA, kiK, kiB, kiC;
+    float emaAlpha;
+    float filterK2;
+    float filterB2;      // derived: slope-matched to the Ki curve
+};
+
+// The compiled config.h values (captured before the names are redirected)
+static constexpr TuningParams TUNING_DEFAULTS = {
+    EXP_KI_A, EXP_KI_K, EXP_KI_B, EXP_KI_C,
+    EMA_ALPHA, FILTER_SECONDARY_K2, FILTER_B2
+};
+
+extern thread_local TuningParams g_tuning;
+
+// Same checks as the config.h static_asserts; true if p can be used
+bool tuningParamsValid(const TuningParams &p);
+
+// Validates p, solves its FILTER_B2 and makes it this thread's parameter
+// set. Returns false (and leaves the current set) if p is rejected.
+bool setTuningParams(const TuningParams &p);
+
+#undef EXP_KI_A
+#undef EXP_KI_K
+#undef EXP_KI_B
+#undef EXP_KI_C
+#undef EMA_ALPHA
+#define EXP_KI_A            (g_tuning.kiA)
+#define EXP_KI_K            (g_tuning.kiK)
+#define EXP_KI_B            (g_tuning.kiB)
+#define EXP_KI_C            (g_tuning.kiC)
+#define EMA_ALPHA           (g_tuning.emaAlpha)
+#define FILTER_SECONDARY_K2 (g_tuning.filterK2)
+#define FILTER_B2           (g_tuning.filterB2)
@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * File: Adafruit_GFX.h (host shim)
+ * Brief: Text-only stand-in for Adafruit_GFX. Printed text lands in a
+ *        character grid (6×8 px cells of the classic font at size 1,
+ *        placed by the cursor) so a host tool can look at the screen.
+ */
+
+#include <Arduino.h>
+
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : width_(w), height_(h) { clearText(); }
+
+    void setCursor(int16_t x, int16_t y) { cursorX_ = x; cursorY_ = y; }
+    void setTextSize(uint8_t s) { textSize_ = s ? s : 1; }
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setRotation(uint8_t r) { rotation_ = r & 3; }
+    void drawPixel(int16_t, int16_t, uint16_t) {}                 // graphics are not kept
+    void drawFastVLine(int16_t, int16_t, int16_t, uint16_t) {}
+    int16_t width() const  { return width_; }
+    int16_t height() const { return height_; }
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+
+    // The character grid, one '\n'-terminated line per text row, trailing
+    // blanks trimmed
+    const char *hostText() const;
+
+protected:
+    static const int16_t GRID_COLS = 32, GRID_ROWS = 16;
+
+    void clearText();
+
+    int16_t width_, height_;
+    int16_t cursorX_ = 0, cursorY_ = 0;
+    uint8_t textSize_ = 1;
+    uint8_t rotation_ = 0;
+    char    grid_[GRID_ROWS][GRID_COLS];
+    mutable char text_[GRID_ROWS * (GRID_COLS + 1) + 1];
+};
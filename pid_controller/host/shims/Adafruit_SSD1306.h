@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * File: Adafruit_SSD1306.h (host shim)
+ * Brief: Null SSD1306 driver: begin() succeeds, display() counts frames.
+ *        Neither generates I²C traffic; the frame buffer stays blank
+ *        (text is kept by the GFX shim) but can be pushed by the caller.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK        0
+#define SSD1306_WHITE        1
+#define SSD1306_INVERSE      2
+#define SSD1306_EXTERNALVCC  0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi = &Wire, int8_t rstPin = -1)
+        : Adafruit_GFX(w, h) { (void)twi; (void)rstPin; }
+
+    bool begin(uint8_t vccState = SSD1306_SWITCHCAPVCC, uint8_t addr = 0,
+               bool reset = true, bool periphBegin = true)
+    {
+        (void)vccState; (void)addr; (void)reset; (void)periphBegin;
+        return true;
+    }
+
+    void clearDisplay() { clearText(); }
+    void display()      { frames_++; }
+    void dim(bool)      {}
+    void invertDisplay(bool) {}
+
+    uint8_t *getBuffer() { return buffer_; }
+
+    uint32_t hostFrames() const { return frames_; }
+
+private:
+    uint32_t frames_ = 0;
+    uint8_t  buffer_[128 * 64 / 8] = {};
+};
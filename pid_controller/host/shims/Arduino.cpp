@@ -0,0 +1,154 @@
+/*
+ * File: Arduino.cpp (host shim)
+ * Brief: Virtual clock, GPIO levels, Serial, EEPROM storage and GFX text
+ *        capture for the host build; also defines the Wire/EEPROM globals.
+ */
+
+ #include <Arduino.h>
+ #include <EEPROM.h>
+ #include <Wire.h>
+ #include <Adafruit_GFX.h>
+ #include <deque>
+
+ // Everything is per thread so independent simulations can share a process
+ thread_local HardwareSerial Serial;
+ thread_local TwoWire        Wire;
+ thread_local EEPROMClass    EEPROM;
+
+ static thread_local uint64_t s_nowUs = 0;
+ static thread_local int      s_pinLevel[64];
+ static thread_local FILE    *s_serialOut = stdout;
+ static thread_local std::deque<uint8_t> s_serialIn;
+
+ /*──────── time ────────*/
+ uint64_t hostMicros()                { return s_nowUs; }
+ void     hostAdvanceMicros(uint64_t us) { s_nowUs += us; }
+ void     hostSetMicros(uint64_t us)  { if (us > s_nowUs) s_nowUs = us; }
+ void     hostResetClock()            { s_nowUs = 0; }
+
+ unsigned long millis()               { return (unsigned long)(s_nowUs / 1000); }
+ unsigned long micros()               { return (unsigned long)s_nowUs; }
+ void delay(unsigned long ms)         { s_nowUs += (uint64_t)ms * 1000; }
+ void delayMicroseconds(unsigned int us) { s_nowUs += us; }
+
+ /*──────── GPIO ────────*/
+ void pinMode(uint8_t pin, uint8_t mode)
+ {
+     if (pin < 64 && mode == INPUT_PULLUP) s_pinLevel[pin] = HIGH;
+ }
+
+ int digitalRead(uint8_t pin)             { return pin < 64 ? s_pinLevel[pin] : LOW; }
+ void digitalWrite(uint8_t pin, uint8_t level) { if (pin < 64) s_pinLevel[pin] = level ? HIGH : LOW; }
+ void hostSetPin(uint8_t pin, int level)  { digitalWrite(pin, (uint8_t)level); }
+
+ /*──────── Print ────────*/
+ size_t Print::print(double v, int digits)
+ {
+     char buf[64];
+     if (digits < 0)  digits = 0;
+     if (digits > 20) digits = 20;
+     int n = snprintf(buf, sizeof(buf), "%.*f", digits, v);
+     return write((const uint8_t *)buf, n > 0 ? (size_t)n : 0);
+ }
+
+ size_t Print::printSigned(long long v, int base)
+ {
+     if (v < 0 && base == DEC) {
+         size_t n = write('-');
+         return n + printNumber((unsigned long long)(-(v + 1)) + 1, base);
+     }
+     return printNumber((unsigned long long)v, base);
+ }
+
+ size_t Print::printNumber(unsigned long long v, int base)
+ {
+     if (base < 2) base = DEC;
+     char buf[66];
+     char *p = &buf[sizeof(buf) - 1];
+     *p = '\0';
+     do {
+         unsigned d = (unsigned)(v % base);
+         *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+         v /= base;
+     } while (v);
+     return write(p);
+ }
+
+ /*──────── Serial ────────*/
+ size_t HardwareSerial::write(uint8_t c)
+ {
+     if (s_serialOut) fputc(c, s_serialOut);
+     return 1;
+ }
+
+ size_t HardwareSerial::write(const uint8_t *buf, size_t n)
+ {
+     if (s_serialOut) fwrite(buf, 1, n, s_serialOut);
+     return n;
+ }
+
+ void HardwareSerial::flush() { if (s_serialOut) fflush(s_serialOut); }
+
+ int HardwareSerial::available() { return (int)s_serialIn.size(); }
+
+ int HardwareSerial::read()
+ {
+     if (s_serialIn.empty()) return -1;
+     int c = s_serialIn.front();
+     s_serialIn.pop_front();
+     return c;
+ }
+
+ int HardwareSerial::peek() { return s_serialIn.empty() ? -1 : s_serialIn.front(); }
+
+ void hostSerialSetOutput(FILE *out) { s_serialOut = out; }
+
+ void hostSerialFeed(const char *text)
+ {
+     while (*text) s_serialIn.push_back((uint8_t)*text++);
+ }
+
+ /*──────── EEPROM ────────*/
+ bool EEPROMClass::begin(size_t size)
+ {
+     if (size == 0 || size > MAX_SIZE) return false;
+     if (size_ == 0) memset(data_, 0xFF, sizeof(data_));   // fresh flash
+     size_ = size;
+     return true;
+ }
+
+ /*──────── GFX text capture ────────*/
+ void Adafruit_GFX::clearText()
+ {
+     memset(grid_, ' ', sizeof(grid_));
+     cursorX_ = cursorY_ = 0;
+ }
+
+ size_t Adafruit_GFX::write(uint8_t c)
+ {
+     if (c == '\n') {
+         cursorX_ = 0;
+         cursorY_ += 8 * textSize_;
+     } else if (c != '\r') {
+         int16_t col = cursorX_ / 6, row = cursorY_ / 8;
+         if (col >= 0 && col < GRID_COLS && row >= 0 && row < GRID_ROWS) grid_[row][col] = (char)c;
+         cursorX_ += 6 * textSize_;
+     }
+     return 1;
+ }
+
+ const char *Adafruit_GFX::hostText() const
+ {
+     int16_t rows = height_ / 8 < GRID_ROWS ? height_ / 8 : GRID_ROWS;
+     int16_t cols = width_ / 6 < GRID_COLS ? width_ / 6 : GRID_COLS;
+     size_t  n    = 0;
+     for (int16_t r = 0; r < rows; r++) {
+         int16_t len = cols;
+         while (len > 0 && grid_[r][len - 1] == ' ') len--;
+         memcpy(text_ + n, grid_[r], len);
+         n += len;
+         text_[n++] = '\n';
+     }
+     text_[n] = '\0';
+     return text_;
+ }
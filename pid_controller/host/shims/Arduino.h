@@ -0,0 +1,121 @@
+#pragma once
+
+/*
+ * File: Arduino.h (host shim)
+ * Brief: Just enough of the Arduino core to build the controller sources
+ *        on a desktop: a virtual clock, GPIO levels and Print/Serial.
+ *
+ *   Time never moves on its own: millis()/micros() read a virtual clock
+ *   that only delay(), I²C bus traffic (Wire shim) and the host runner
+ *   advance. The controller therefore runs as fast as the CPU allows and
+ *   its timing is fully reproducible.
+ *
+ *   All shim state (clock, pins, Serial, Wire, EEPROM) is thread_local, so
+ *   each thread of a host sweep drives its own simulated board.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define F(s) (s)
+
+#define LOW          0
+#define HIGH         1
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// Seeed XIAO ESP32-S3 pin map
+enum {
+    D0 = 1, D1 = 2, D2 = 3, D3 = 4, D4 = 5, D5 = 6,
+    D6 = 43, D7 = 44, D8 = 7, D9 = 8, D10 = 9
+};
+
+/*──────── time (virtual) ────────*/
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/*──────── GPIO ────────*/
+void pinMode(uint8_t pin, uint8_t mode);
+int  digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+
+/*──────── Print / Serial ────────*/
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t n)
+    {
+        size_t done = 0;
+        while (n--) done += write(*buf++);
+        return done;
+    }
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const char *s)                 { return write(s); }
+    size_t print(char c)                        { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return printNumber((unsigned long long)v, base); }
+    size_t print(int v, int base = DEC)           { return printSigned(v, base); }
+    size_t print(unsigned int v, int base = DEC)  { return printNumber(v, base); }
+    size_t print(long v, int base = DEC)          { return printSigned(v, base); }
+    size_t print(unsigned long v, int base = DEC) { return printNumber(v, base); }
+    size_t print(long long v, int base = DEC)     { return printSigned(v, base); }
+    size_t print(unsigned long long v, int base = DEC) { return printNumber(v, base); }
+    size_t print(double v, int digits = 2);
+
+    size_t println() { return write('\n'); }
+    template <typename T> size_t println(T v)         { size_t n = print(v);    return n + println(); }
+    template <typename T> size_t println(T v, int f)  { size_t n = print(v, f); return n + println(); }
+
+private:
+    size_t printSigned(long long v, int base);
+    size_t printNumber(unsigned long long v, int base);
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    void flush();
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t n) override;
+
+    int available();
+    int read();
+    int peek();
+    int availableForWrite() { return 4096; }
+
+    explicit operator bool() const { return true; }
+};
+
+extern thread_local HardwareSerial Serial;
+
+/*──────── host-only hooks (not part of the Arduino API) ────────*/
+uint64_t hostMicros();                     // virtual clock, µs since start
+void     hostAdvanceMicros(uint64_t us);   // move the clock forward
+void     hostSetMicros(uint64_t us);       // jump forward (never backwards)
+void     hostResetClock();                 // back to 0 for a new simulation
+void     hostSetPin(uint8_t pin, int level);
+
+// Serial output goes to stdout by default; nullptr discards it
+void     hostSerialSetOutput(FILE *out);
+// Queues bytes that Serial.read() will return
+void     hostSerialFeed(const char *text);
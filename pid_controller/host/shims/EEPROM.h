@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * File: EEPROM.h (host shim)
+ * Brief: RAM-backed EEPROM emulation (same API as arduino-esp32).
+ *        Contents start erased (0xFF); commits are only counted.
+ */
+
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    static const size_t MAX_SIZE = 4096;
+
+    bool   begin(size_t size);
+    bool   commit() { commits_++; return true; }
+    void   end() {}
+    size_t length() const { return size_; }
+
+    uint8_t read(int addr) const { return inRange(addr, 1) ? data_[addr] : 0; }
+    void    write(int addr, uint8_t v) { if (inRange(addr, 1)) data_[addr] = v; }
+
+    template <typename T> T &get(int addr, T &t) const
+    {
+        if (inRange(addr, sizeof(T))) memcpy(&t, &data_[addr], sizeof(T));
+        return t;
+    }
+    template <typename T> const T &put(int addr, const T &t)
+    {
+        if (inRange(addr, sizeof(T))) memcpy(&data_[addr], &t, sizeof(T));
+        return t;
+    }
+
+    uint8_t *hostData() { return data_; }
+    uint32_t hostCommits() const { return commits_; }
+
+private:
+    bool inRange(int addr, size_t n) const { return addr >= 0 && (size_t)addr + n <= size_; }
+
+    uint8_t  data_[MAX_SIZE];
+    size_t   size_    = 0;
+    uint32_t commits_ = 0;
+};
+
+extern thread_local EEPROMClass EEPROM;
@@ -0,0 +1,83 @@
+/*
+ * File: Wire.cpp (host shim)
+ * Brief: I²C transactions routed to simulated devices, with bus timing.
+ */
+
+ #include <Wire.h>
+
+ static thread_local HostI2cDevice *s_devices[128];
+ static thread_local HostI2cStats   s_stats = {};
+
+ void hostI2cAttach(uint8_t addr, HostI2cDevice *dev) { if (addr < 128) s_devices[addr] = dev; }
+ void hostI2cDetach(uint8_t addr)                     { if (addr < 128) s_devices[addr] = nullptr; }
+ const HostI2cStats &hostI2cStats()                   { return s_stats; }
+ void hostI2cResetStats()                             { s_stats = {}; }
+
+ // Start + address byte + payload (9 clocks per byte incl. ACK) + stop
+ void TwoWire::chargeBusTime(size_t bytes)
+ {
+     uint64_t bits = 2 + 9 * (1 + (uint64_t)bytes);
+     uint64_t us   = (bits * 1000000ULL + clockHz_ - 1) / clockHz_;
+     hostAdvanceMicros(us);
+     s_stats.busTimeUs += us;
+     s_stats.transactions++;
+     s_stats.bytes += (uint32_t)bytes;
+ }
+
+ void TwoWire::beginTransmission(uint8_t addr)
+ {
+     txAddr_ = addr;
+     txLen_  = 0;
+ }
+
+ size_t TwoWire::write(uint8_t b)
+ {
+     if (txLen_ >= BUFFER_LENGTH) return 0;
+     txBuf_[txLen_++] = b;
+     return 1;
+ }
+
+ size_t TwoWire::write(const uint8_t *data, size_t len)
+ {
+     size_t done = 0;
+     while (done < len && write(data[done])) done++;
+     return done;
+ }
+
+ // Returns 0 on success, 2 on address NACK, 3 on data NACK (as arduino-esp32)
+ uint8_t TwoWire::endTransmission(bool sendStop)
+ {
+     (void)sendStop;
+     HostI2cDevice *dev = (txAddr_ < 128) ? s_devices[txAddr_] : nullptr;
+     if (!dev) {
+         chargeBusTime(0);
+         s_stats.nacks++;
+         return 2;
+     }
+     chargeBusTime(txLen_);
+     if (!dev->onWrite(txBuf_, txLen_)) {
+         s_stats.nacks++;
+         return 3;
+     }
+     return 0;
+ }
+
+ uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t qty, bool sendStop)
+ {
+     (void)sendStop;
+     rxLen_ = rxPos_ = 0;
+     if (qty > BUFFER_LENGTH) qty = BUFFER_LENGTH;
+
+     HostI2cDevice *dev = (addr < 128) ? s_devices[addr] : nullptr;
+     size_t got = dev ? dev->onRead(rxBuf_, qty) : 0;
+     if (got > qty) got = qty;
+     chargeBusTime(got);
+     if (got == 0) s_stats.nacks++;
+
+     rxLen_ = got;
+     return (uint8_t)got;
+ }
+
+ int TwoWire::available() { return (int)(rxLen_ - rxPos_); }
+ int TwoWire::read()      { return rxPos_ < rxLen_ ? rxBuf_[rxPos_++] : -1; }
+ int TwoWire::peek()      { return rxPos_ < rxLen_ ? rxBuf_[rxPos_] : -1; }
@@ -0,0 +1,73 @@
+#pragma once
+
+/*
+ * File: Wire.h (host shim)
+ * Brief: TwoWire on top of simulated I²C devices.
+ *
+ *   Devices register at an address with hostI2cAttach(). A write
+ *   transaction is delivered to onWrite() in one piece at
+ *   endTransmission(); requestFrom() asks onRead() for the bytes.
+ *   Unclaimed addresses NACK. Each transaction advances the virtual
+ *   clock by its time on the bus at the configured SCL rate (9 bits per
+ *   byte including the address, plus start/stop).
+ */
+
+#include <Arduino.h>
+
+class HostI2cDevice {
+public:
+    virtual ~HostI2cDevice() {}
+
+    // Master write; return false to NACK the data
+    virtual bool   onWrite(const uint8_t *data, size_t len) = 0;
+    // Master read; fill up to len bytes and return how many were sent
+    // (0 = address NACK)
+    virtual size_t onRead(uint8_t *data, size_t len) = 0;
+};
+
+struct HostI2cStats {
+    uint32_t transactions;
+    uint32_t bytes;          // payload bytes, both directions
+    uint32_t nacks;
+    uint64_t busTimeUs;
+};
+
+class TwoWire {
+public:
+    static const size_t BUFFER_LENGTH = 128;   // same as arduino-esp32
+
+    bool begin() { return true; }
+    void setClock(uint32_t hz) { clockHz_ = hz ? hz : 100000; }
+    uint32_t getClock() const  { return clockHz_; }
+
+    void    beginTransmission(uint8_t addr);
+    void    beginTransmission(int addr) { beginTransmission((uint8_t)addr); }
+    size_t  write(uint8_t b);
+    size_t  write(const uint8_t *data, size_t len);
+    uint8_t endTransmission(bool sendStop = true);
+
+    uint8_t requestFrom(uint8_t addr, uint8_t qty, bool sendStop = true);
+    uint8_t requestFrom(int addr, int qty) { return requestFrom((uint8_t)addr, (uint8_t)qty); }
+    int     available();
+    int     read();
+    int     peek();
+
+private:
+    void    chargeBusTime(size_t bytes);
+
+    uint32_t clockHz_ = 100000;
+    uint8_t  txAddr_  = 0;
+    uint8_t  txBuf_[BUFFER_LENGTH];
+    size_t   txLen_   = 0;
+    uint8_t  rxBuf_[BUFFER_LENGTH];
+    size_t   rxLen_   = 0;
+    size_t   rxPos_   = 0;
+};
+
+extern thread_local TwoWire Wire;
+
+/*──────── host-only hooks ────────*/
+void hostI2cAttach(uint8_t addr, HostI2cDevice *dev);
+void hostI2cDetach(uint8_t addr);
+const HostI2cStats &hostI2cStats();
+void hostI2cResetStats();
@@ -0,0 +1,95 @@
+/*
+ * File: sim_devices.cpp
+ * Brief: Behaviour of the simulated flow sensor and pump driver.
+ */
+
+ #include "sim_devices.h"
+ #include "config.h"
+ #include "crc.h"
+
+ /*──────────────────────── SLF3S FLOW SENSOR ─────────────────────────────*/
+ bool SlfSensorSim::onWrite(const uint8_t *data, size_t len)
+ {
+     if (silent_) return false;
+     if (len == 2 && data[0] == SLF_START_CMD) measuring_ = true;
+     if (len == 2 && data[0] == SLF_STOP_CMD)  measuring_ = false;
+     return true;
+ }
+
+ static void putWord(uint8_t *p, uint16_t w)
+ {
+     p[0] = (uint8_t)(w >> 8);
+     p[1] = (uint8_t)(w & 0xFF);
+     p[2] = crc8Sensirion(p, 2);
+ }
+
+ static int16_t toRaw(float value, float scale)
+ {
+     float raw = roundf(value * scale);
+     if (raw >  32767.0f) raw =  32767.0f;
+     if (raw < -32768.0f) raw = -32768.0f;
+     return (int16_t)raw;
+ }
+
+ // Not measuring: the sensor does not answer a read
+ size_t SlfSensorSim::onRead(uint8_t *data, size_t len)
+ {
+     if (!measuring_ || silent_) return 0;
+
+     uint8_t frame[9];
+     putWord(&frame[0], (uint16_t)toRaw(flow_,  SLF_SCALE_FACTOR_FLOW));
+     putWord(&frame[3], (uint16_t)toRaw(tempC_, SLF_SCALE_FACTOR_TEMP));
+     putWord(&frame[6], flags_);
+
+     size_t n = len < sizeof(frame) ? len : sizeof(frame);
+     memcpy(data, frame, n);
+     return n;
+ }
+
+ /*──────────────────────── MP-LOWDRIVER ───────────────────────────────────*/
+ BartelsDriverSim::BartelsDriverSim() : page_(0)
+ {
+     memset(regs_, 0, sizeof(regs_));
+ }
+
+ // First byte is the register address; the rest auto-increment from there
+ bool BartelsDriverSim::onWrite(const uint8_t *data, size_t len)
+ {
+     if (silent_) return false;
+     if (len == 0) return true;
+     uint8_t r = data[0];
+     if (r == BARTELS_PAGE_REGISTER) {
+         if (len >= 2) page_ = data[1] & 1;
+         return true;
+     }
+     for (size_t i = 1; i < len; i++) {
+         regs_[page_][(uint8_t)(r + i - 1)] = data[i];
+     }
+     return true;
+ }
+
+ size_t BartelsDriverSim::onRead(uint8_t *data, size_t len)
+ {
+     memset(data, 0, len);
+     return len;
+ }
+
+ float BartelsDriverSim::amplitudeVolts() const
+ {
+     return regs_[1][6] / 255.0f * BARTELS_ABSOLUTE_MAX;
+ }
+
+ float BartelsDriverSim::frequencyHz() const
+ {
+     return regs_[1][7] * 7.8125f;
+ }
+
+ /*──────────────────────── SSD1306 ────────────────────────────────────────*/
+ // Control byte 0x40 = GDDRAM data follows, anything else = commands
+ bool Ssd1306Sim::onWrite(const uint8_t *data, size_t len)
+ {
+     if (len == 0) return true;
+     if (data[0] == 0x40) dataBytes_    += (uint32_t)(len - 1);
+     else                 commandBytes_ += (uint32_t)(len - 1);
+     return true;
+ }
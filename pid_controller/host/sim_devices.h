@@ -0,0 +1,67 @@
+#pragma once
+#include <Wire.h>
+
+/*
+ * File: sim_devices.h
+ * Brief: Simulated I²C peripherals for the host build.
+ *
+ *   SlfSensorSim     – SLF3S flow sensor: start/stop commands, 9-byte
+ *                      frames (flow, temperature, flags) with CRC-8;
+ *                      can be silenced to simulate an outage.
+ *   BartelsDriverSim – mp-Lowdriver register file (two pages behind the
+ *                      page register, auto-increment writes); exposes the
+ *                      programmed amplitude as a drive voltage; can be
+ *                      silenced to simulate a dead driver.
+ *   Ssd1306Sim       – display: acknowledges everything, counts command
+ *                      and GDDRAM bytes.
+ */
+
+class SlfSensorSim : public HostI2cDevice {
+public:
+    bool   onWrite(const uint8_t *data, size_t len) override;
+    size_t onRead(uint8_t *data, size_t len) override;
+
+    void setFlow(float mLmin)  { flow_ = mLmin; }
+    void setTempC(float c)     { tempC_ = c; }
+    void setFlags(uint16_t f)  { flags_ = f; }
+    void setSilent(bool s)     { silent_ = s; }   // NACK everything (sensor absent or dead)
+    bool isMeasuring() const   { return measuring_; }
+
+private:
+    float    flow_      = 0.0f;
+    float    tempC_     = 23.0f;
+    uint16_t flags_     = 0;
+    bool     measuring_ = false;
+    bool     silent_    = false;
+};
+
+class BartelsDriverSim : public HostI2cDevice {
+public:
+    BartelsDriverSim();
+
+    bool   onWrite(const uint8_t *data, size_t len) override;
+    size_t onRead(uint8_t *data, size_t len) override;
+
+    uint8_t reg(uint8_t page, uint8_t r) const { return regs_[page & 1][r]; }
+    float   amplitudeVolts() const;   // page 1, register 6
+    float   frequencyHz() const;      // page 1, register 7
+    void    setSilent(bool s) { silent_ = s; }   // NACK every write
+
+private:
+    uint8_t page_;
+    uint8_t regs_[2][256];
+    bool    silent_ = false;
+};
+
+class Ssd1306Sim : public HostI2cDevice {
+public:
+    bool   onWrite(const uint8_t *data, size_t len) override;
+    size_t onRead(uint8_t *, size_t) override { return 0; }
+
+    uint32_t commandBytes() const { return commandBytes_; }
+    uint32_t dataBytes() const    { return dataBytes_; }
+
+private:
+    uint32_t commandBytes_ = 0;
+    uint32_t dataBytes_    = 0;
+};
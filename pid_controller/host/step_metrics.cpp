@@ -0,0 +1,48 @@
+/*
+ * File: step_metrics.cpp
+ * Brief: Streaming step-response figures (see step_metrics.h).
+ */
+
+ #include "step_metrics.h"
+ #include <math.h>
+
+ void initStepMetrics(StepMetrics &m, float setpoint, float band, double tailFromS)
+ {
+     m = {};
+     m.setpoint  = setpoint;
+     m.band      = band;
+     m.tailFromS = tailFromS;
+     m.riseS     = -1.0;
+ }
+
+ void addStepSample(StepMetrics &m, double tS, double dtS, float flow)
+ {
+     float err = m.setpoint - flow;
+
+     if (m.riseS < 0.0 && flow >= 0.9f * m.setpoint) m.riseS = tS;
+     if (flow > m.peak) m.peak = flow;
+     if (fabsf(err) > m.band * m.setpoint) m.settleS = tS;
+     m.iae += fabs(err) * dtS;
+
+     if (tS >= m.tailFromS) {
+         m.tailSum += err;
+         m.tailSq  += (double)err * err;
+         m.tailN++;
+     }
+ }
+
+ float stepOvershootPct(const StepMetrics &m)
+ {
+     if (m.setpoint <= 0.0f || m.peak <= m.setpoint) return 0.0f;
+     return 100.0f * (m.peak - m.setpoint) / m.setpoint;
+ }
+
+ float stepTailMean(const StepMetrics &m)
+ {
+     return m.tailN ? (float)(m.tailSum / m.tailN) : 0.0f;
+ }
+
+ float stepTailRms(const StepMetrics &m)
+ {
+     return m.tailN ? (float)sqrt(m.tailSq / m.tailN) : 0.0f;
+ }
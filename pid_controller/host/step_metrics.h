@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * File: step_metrics.h
+ * Brief: Setpoint-step response figures for a closed-loop run, accumulated
+ *        one sample at a time (no history kept).
+ *
+ *   riseS      first time the flow crosses 90 % of the setpoint
+ *   overshoot  peak above the setpoint, % of the setpoint
+ *   settleS    last time the flow was outside ±band of the setpoint
+ *   iae        ∫|error| dt (mL)·(60 s/min), i.e. mL/min·s
+ *   tailMean / tailRms
+ *              mean and RMS error after tailFromS (steady state)
+ */
+
+struct StepMetrics {
+    float  setpoint;
+    float  band;          // settling band, fraction of setpoint
+    double tailFromS;
+
+    double riseS;         // < 0 until reached
+    float  peak;
+    double settleS;
+    double iae;
+    double tailSum, tailSq;
+    uint32_t tailN;
+};
+
+void  initStepMetrics(StepMetrics &m, float setpoint, float band, double tailFromS);
+void  addStepSample(StepMetrics &m, double tS, double dtS, float flow);
+
+float stepOvershootPct(const StepMetrics &m);
+float stepTailMean(const StepMetrics &m);
+float stepTailRms(const StepMetrics &m);
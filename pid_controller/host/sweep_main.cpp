@@ -0,0 +1,290 @@
+/*
+ * File: sweep_main.cpp
+ * Brief: Parallel sweep of the Ki gain schedule and error-filter constants.
+ *
+ *   controller_sweep [--threads N] [--seconds S] [--setpoint F] [--seeds K]
+ *                    [--ki-a LIST] [--ki-k LIST] [--ki-b LIST] [--ki-c LIST]
+ *                    [--ema LIST] [--k2 LIST] [--out FILE.csv]
+ *
+ *   LIST is comma separated (0.001,0.002) or lo:hi:n (n points, linear).
+ *   Every combination is one job: K closed-loop step responses (0 →
+ *   setpoint, one plant draw per seed) through the real exp_control /
+ *   filter / pid / bartels code, scored on settling time, overshoot,
+ *   IAE and pump writes (mean over seeds). Jobs are spread over the
+ *   threads with work stealing. Prints the Pareto front and a config.h
+ *   block for the most balanced point; --out writes every job as CSV.
+ */
+
+ #include "host_rig.h"
+ #include "plant_sim.h"
+ #include "step_metrics.h"
+ #include "work_stealing.h"
+ #include "bartels.h"
+ #include <Arduino.h>
+ #include <algorithm>
+ #include <chrono>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <string>
+ #include <vector>
+
+ static const float SETTLE_BAND = 0.05f;   // ±5 % of setpoint
+
+ enum { OBJ_SETTLE = 0, OBJ_OVERSHOOT, OBJ_IAE, OBJ_WRITES, OBJ_COUNT };
+ static const char *const OBJ_NAMES[OBJ_COUNT] = { "settle_s", "overshoot_pct", "iae", "pump_writes" };
+
+ struct SweepJob {
+     TuningParams params;
+     bool   valid;
+     float  score[OBJ_COUNT];
+     bool   pareto;
+ };
+
+ struct SweepSpec {
+     std::vector<float> kiA, kiK, kiB, kiC, ema, k2;
+     double   seconds  = 60.0;
+     float    setpoint = 0.5f;
+     uint32_t seeds    = 3;
+ };
+
+ /*──────────────────────── ARGUMENTS ──────────────────────────────────────*/
+ static std::vector<float> parseList(const char *arg)
+ {
+     std::vector<float> out;
+     float lo, hi;
+     int   n;
+     if (sscanf(arg, "%f:%f:%d", &lo, &hi, &n) == 3 && n >= 1) {
+         for (int i = 0; i < n; i++) out.push_back(n == 1 ? lo : lo + (hi - lo) * i / (n - 1));
+         return out;
+     }
+     std::string s(arg);
+     size_t pos = 0;
+     while (pos <= s.size()) {
+         size_t comma = s.find(',', pos);
+         if (comma == std::string::npos) comma = s.size();
+         if (comma > pos) out.push_back((float)atof(s.substr(pos, comma - pos).c_str()));
+         pos = comma + 1;
+     }
+     return out;
+ }
+
+ /*──────────────────────── ONE SIMULATION ─────────────────────────────────*/
+ static void runCase(const SweepSpec &spec, uint64_t seed, float score[OBJ_COUNT])
+ {
+     HostRig  rig;
+     PlantSim plant;
+     StepMetrics step;
+
+     const double dt    = SCHED_TICK_US * 1e-6;
+     const uint32_t end = (uint32_t)(spec.seconds / dt);
+
+     initHostRig(rig, spec.setpoint, 0.0f, CONTROL_MODE_EXP);
+     initPlantSim(plant, defaultPlantParams(), dt, seed);
+     initStepMetrics(step, spec.setpoint, SETTLE_BAND, 0.8 * spec.seconds);
+     pressHostButton(rig, D6);
+
+     while (rig.tick < end) {
+         stepPlantSim(plant, rig.pump.amplitudeVolts(), dt);
+         rig.sensor.setFlow(plantSensorFlow(plant));
+         addStepSample(step, hostRigTimeSec(rig), dt, plant.meanFlow);
+         stepHostRig(rig);
+     }
+
+     // Never inside the band at the end: charge the whole run
+     bool settled = fabsf(spec.setpoint - plant.meanFlow) <= SETTLE_BAND * spec.setpoint;
+     score[OBJ_SETTLE]    = settled ? (float)step.settleS : (float)spec.seconds;
+     score[OBJ_OVERSHOOT] = stepOvershootPct(step);
+     score[OBJ_IAE]       = (float)step.iae;
+     score[OBJ_WRITES]    = (float)getBartelsBusStats().updates;
+ }
+
+ static void runJob(const SweepSpec &spec, SweepJob &job)
+ {
+     job.valid = setTuningParams(job.params);
+     if (!job.valid) return;
+     job.params = g_tuning;             // keeps the solved FILTER_B2
+
+     float sum[OBJ_COUNT] = {};
+     for (uint32_t s = 0; s < spec.seeds; s++) {
+         float score[OBJ_COUNT];
+         runCase(spec, 1000 + s, score);
+         for (int k = 0; k < OBJ_COUNT; k++) sum[k] += score[k];
+     }
+     for (int k = 0; k < OBJ_COUNT; k++) job.score[k] = sum[k] / spec.seeds;
+ }
+
+ /*──────────────────────── PARETO / OUTPUT ────────────────────────────────*/
+ static bool dominates(const SweepJob &a, const SweepJob &b)
+ {
+     bool better = false;
+     for (int k = 0; k < OBJ_COUNT; k++) {
+         if (a.score[k] > b.score[k]) return false;
+         if (a.score[k] < b.score[k]) better = true;
+     }
+     return better;
+ }
+
+ static void markPareto(std::vector<SweepJob> &jobs)
+ {
+     for (auto &a : jobs) {
+         a.pareto = a.valid;
+         for (const auto &b : jobs) {
+             if (!a.pareto) break;
+             if (b.valid && &a != &b && dominates(b, a)) a.pareto = false;
+         }
+     }
+ }
+
+ // Front point with the smallest sum of min-max normalised objectives
+ static const SweepJob *balancedPoint(const std::vector<const SweepJob *> &front)
+ {
+     float lo[OBJ_COUNT], hi[OBJ_COUNT];
+     for (int k = 0; k < OBJ_COUNT; k++) { lo[k] = 1e30f; hi[k] = -1e30f; }
+     for (auto *j : front)
+         for (int k = 0; k < OBJ_COUNT; k++) {
+             lo[k] = std::min(lo[k], j->score[k]);
+             hi[k] = std::max(hi[k], j->score[k]);
+         }
+
+     const SweepJob *best = nullptr;
+     float bestSum = 1e30f;
+     for (auto *j : front) {
+         float sum = 0.0f;
+         for (int k = 0; k < OBJ_COUNT; k++)
+             if (hi[k] > lo[k]) sum += (j->score[k] - lo[k]) / (hi[k] - lo[k]);
+         if (sum < bestSum) { bestSum = sum; best = j; }
+     }
+     return best;
+ }
+
+ // %g with a decimal point, so the value pastes as a float literal
+ static const char *floatLiteral(char *buf, size_t len, float v)
+ {
+     snprintf(buf, len, "%g", v);
+     if (!strpbrk(buf, ".e")) strncat(buf, ".0", len - strlen(buf) - 1);
+     strncat(buf, "f", len - strlen(buf) - 1);
+     return buf;
+ }
+
+ static void printConfigBlock(const SweepJob &j)
+ {
+     const TuningParams &p = j.params;
+     printf("\n// ── config.h (sweep: settle %.2f s, overshoot %.1f %%, IAE %.3f, %.0f pump writes) ──\n",
+            j.score[OBJ_SETTLE], j.score[OBJ_OVERSHOOT], j.score[OBJ_IAE], j.score[OBJ_WRITES]);
+     printf("// Ki parameters\n");
+     char b[32];
+     printf("#define EXP_KI_A  %s\n", floatLiteral(b, sizeof b, p.kiA));
+     printf("#define EXP_KI_K  %s\n", floatLiteral(b, sizeof b, p.kiK));
+     printf("#define EXP_KI_B  %s\n", floatLiteral(b, sizeof b, p.kiB));
+     printf("#define EXP_KI_C  %s\n", floatLiteral(b, sizeof b, p.kiC));
+     printf("\nstatic constexpr float FILTER_SECONDARY_K2 = %s;   // FILTER_B2 solves to %g\n",
+            floatLiteral(b, sizeof b, p.filterK2), p.filterB2);
+     printf("\n#define EMA_ALPHA   %s\n", floatLiteral(b, sizeof b, p.emaAlpha));
+ }
+
+ static void writeCsv(const char *path, const std::vector<SweepJob> &jobs)
+ {
+     FILE *f = fopen(path, "w");
+     if (!f) { fprintf(stderr, "[SWEEP] cannot write %s\n", path); return; }
+     fprintf(f, "ki_a,ki_k,ki_b,ki_c,ema_alpha,k2,b2,valid,pareto");
+     for (int k = 0; k < OBJ_COUNT; k++) fprintf(f, ",%s", OBJ_NAMES[k]);
+     fprintf(f, "\n");
+     for (const auto &j : jobs) {
+         const TuningParams &p = j.params;
+         fprintf(f, "%g,%g,%g,%g,%g,%g,%g,%d,%d", p.kiA, p.kiK, p.kiB, p.kiC,
+                 p.emaAlpha, p.filterK2, j.valid ? p.filterB2 : 0.0f, j.valid, j.pareto);
+         for (int k = 0; k < OBJ_COUNT; k++) fprintf(f, ",%g", j.valid ? j.score[k] : 0.0f);
+         fprintf(f, "\n");
+     }
+     fclose(f);
+ }
+
+ /*──────────────────────── MAIN ───────────────────────────────────────────*/
+ int main(int argc, char **argv)
+ {
+     SweepSpec spec;
+     const TuningParams &d = TUNING_DEFAULTS;
+     spec.kiA = { d.kiA * 0.5f, d.kiA, d.kiA * 2.0f };
+     spec.kiK = { 0.1f, 0.15f, d.kiK, 0.3f, 0.4f };
+     spec.kiB = { 25.0f, 50.0f, d.kiB, 200.0f };
+     spec.kiC = { d.kiC };
+     spec.ema = { 0.6f, 0.75f, d.emaAlpha, 0.95f };
+     spec.k2  = { 0.3f, d.filterK2, 0.7f };
+
+     uint32_t    threads = std::max(1u, std::thread::hardware_concurrency());
+     const char *outPath = nullptr;
+
+     for (int i = 1; i < argc; i++) {
+         const char *a = argv[i];
+         const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+         if      (!strcmp(a, "--threads")  && v) { threads = (uint32_t)atoi(v); i++; }
+         else if (!strcmp(a, "--seconds")  && v) { spec.seconds  = atof(v); i++; }
+         else if (!strcmp(a, "--setpoint") && v) { spec.setpoint = (float)atof(v); i++; }
+         else if (!strcmp(a, "--seeds")    && v) { spec.seeds    = (uint32_t)std::max(1, atoi(v)); i++; }
+         else if (!strcmp(a, "--ki-a")     && v) { spec.kiA = parseList(v); i++; }
+         else if (!strcmp(a, "--ki-k")     && v) { spec.kiK = parseList(v); i++; }
+         else if (!strcmp(a, "--ki-b")     && v) { spec.kiB = parseList(v); i++; }
+         else if (!strcmp(a, "--ki-c")     && v) { spec.kiC = parseList(v); i++; }
+         else if (!strcmp(a, "--ema")      && v) { spec.ema = parseList(v); i++; }
+         else if (!strcmp(a, "--k2")       && v) { spec.k2  = parseList(v); i++; }
+         else if (!strcmp(a, "--out")      && v) { outPath = v; i++; }
+         else {
+             fprintf(stderr, "usage: %s [--threads N] [--seconds S] [--setpoint F] [--seeds K]\n"
+                             "       [--ki-a L] [--ki-k L] [--ki-b L] [--ki-c L] [--ema L] [--k2 L]"
+                             " [--out FILE]\n   L = a,b,c or lo:hi:n\n", argv[0]);
+             return 2;
+         }
+     }
+
+     std::vector<SweepJob> jobs;
+     for (float a : spec.kiA) for (float k : spec.kiK) for (float b : spec.kiB)
+     for (float c : spec.kiC) for (float e : spec.ema) for (float k2 : spec.k2) {
+         SweepJob j = {};
+         j.params = { a, k, b, c, e, k2, 0.0f };
+         jobs.push_back(j);
+     }
+     if (jobs.empty()) { fprintf(stderr, "[SWEEP] empty grid\n"); return 2; }
+
+     fprintf(stderr, "[SWEEP] %zu parameter sets x %u seeds x %.0f s on %u threads\n",
+             jobs.size(), spec.seeds, spec.seconds, threads);
+
+     WorkStealingPool pool(threads);
+     auto wallStart = std::chrono::steady_clock::now();
+     pool.run((uint32_t)jobs.size(), [&](uint32_t j, uint32_t) {
+         hostSerialSetOutput(nullptr);
+         runJob(spec, jobs[j]);
+     });
+     double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+     markPareto(jobs);
+     std::vector<const SweepJob *> front;
+     size_t valid = 0;
+     for (const auto &j : jobs) {
+         valid += j.valid;
+         if (j.pareto) front.push_back(&j);
+     }
+     std::sort(front.begin(), front.end(), [](const SweepJob *a, const SweepJob *b) {
+         return a->score[OBJ_IAE] < b->score[OBJ_IAE];
+     });
+
+     double simSeconds = (double)valid * spec.seeds * spec.seconds;
+     fprintf(stderr, "[SWEEP] %zu valid, %zu rejected by the config.h checks; %.0f s simulated in %.2f s"
+                     " (x%.0f), %llu steals\n",
+             valid, jobs.size() - valid, simSeconds, wall, wall > 0 ? simSeconds / wall : 0.0,
+             (unsigned long long)pool.steals());
+
+     printf("Pareto front (%zu points, sorted by IAE):\n", front.size());
+     printf("  %-9s %-7s %-7s %-7s %-6s %-6s %9s %10s %7s %11s\n", "ki_a", "ki_k", "ki_b", "ki_c",
+            "ema", "k2", "settle_s", "overshoot%", "iae", "pump_writes");
+     for (auto *j : front) {
+         const TuningParams &p = j->params;
+         printf("  %-9g %-7g %-7g %-7g %-6g %-6g %9.2f %10.1f %7.3f %11.0f\n",
+                p.kiA, p.kiK, p.kiB, p.kiC, p.emaAlpha, p.filterK2,
+                j->score[OBJ_SETTLE], j->score[OBJ_OVERSHOOT], j->score[OBJ_IAE], j->score[OBJ_WRITES]);
+     }
+
+     if (const SweepJob *pick = balancedPoint(front)) printConfigBlock(*pick);
+     if (outPath) writeCsv(outPath, jobs);
+     return 0;
+ }
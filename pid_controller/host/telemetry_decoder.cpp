@@ -0,0 +1,186 @@
+/*
+ * File: telemetry_decoder.cpp
+ * Brief: Binary telemetry stream decoder (see telemetry_decoder.h).
+ */
+
+ #include "telemetry_decoder.h"
+ #include "crc.h"
+ #include <stdio.h>
+ #include <string.h>
+
+ void initTelemetryDecoder(TelemetryDecoder &d)
+ {
+     d.len      = 0;
+     d.overflow = false;
+     d.haveSeq  = false;
+     d.lastSeq  = 0;
+     d.text.clear();
+     d.stats    = {};
+ }
+
+ bool decodeTelemetryRecord(const uint8_t *record, size_t len, TelemetrySample &out)
+ {
+     if (len < TELEMETRY_MIN_RECORD_SIZE || record[0] != TELEMETRY_VERSION) return false;
+     uint32_t fields = (uint32_t)record[1] | (uint32_t)record[2] << 8 |
+                       (uint32_t)record[3] << 16 | (uint32_t)record[4] << 24;
+     if ((fields & ~TELEMETRY_ALL_FIELDS) ||
+         (fields & TELEMETRY_REQUIRED_FIELDS) != TELEMETRY_REQUIRED_FIELDS ||
+         len != telemetryRecordSize(fields)) return false;
+     out.version = record[0];
+     out.fields  = fields;
+
+     const uint8_t *p = record + 5;
+     const uint8_t *flags = nullptr;
+     for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+         const TelemetryField &f = TELEMETRY_FIELDS[i];
+         if (f.type == TLM_BIT && f.bit == 0) flags = nullptr;
+         out.values[i] = 0.0;
+         if (!((fields >> i) & 1)) continue;
+
+         double raw;
+         switch (f.type) {
+             case TLM_U8:  raw = p[0]; break;
+             case TLM_U16: raw = (uint16_t)(p[0] | p[1] << 8); break;
+             case TLM_I16: raw = (int16_t)(p[0] | p[1] << 8); break;
+             case TLM_F16: raw = halfToFloat((uint16_t)(p[0] | p[1] << 8)); break;
+             case TLM_U32: raw = (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+                                 (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; break;
+             default:
+                 if (!flags) flags = p++;
+                 raw = (*flags >> f.bit) & 1;
+                 break;
+         }
+         if (f.type != TLM_BIT) p += telemetryFieldSize(f);
+         bool integer = f.type != TLM_F16 && f.type != TLM_BIT;
+         out.values[i] = integer ? raw / f.scale : raw;
+     }
+     return true;
+ }
+
+ enum { TAIL_NONE = 0, TAIL_BAD_CRC, TAIL_OK };
+
+ // The last `len` bytes of the chunk as a frame
+ static uint8_t tryTail(const TelemetryDecoder &d, size_t len, TelemetrySample &s)
+ {
+     uint8_t payload[TELEMETRY_COBS_SIZE];
+     size_t  n = cobsDecode(d.buf + d.len - len, len, payload);
+     if (n < TELEMETRY_MIN_RECORD_SIZE + 2 || n > TELEMETRY_PAYLOAD_SIZE) return TAIL_NONE;
+     if (!decodeTelemetryRecord(payload, n - 2, s)) return TAIL_NONE;
+
+     uint16_t crc = (uint16_t)(payload[n - 2] | payload[n - 1] << 8);
+     return crc16Ccitt(payload, n - 2) == crc ? TAIL_OK : TAIL_BAD_CRC;
+ }
+
+ static bool isText(const uint8_t *p, size_t n)
+ {
+     for (size_t i = 0; i < n; i++)
+         if ((p[i] < 0x20 || p[i] > 0x7E) && p[i] != '\n' && p[i] != '\r' && p[i] != '\t') return false;
+     return true;
+ }
+
+ /*
+  * One complete chunk (delimiter stripped): text prefix, then a frame.
+  * Frames vary in length with the field mask, so the longest tail that
+  * decodes to a consistent record is taken; a chunk with no such tail is
+  * text, or a damaged frame if it is not printable.
+  */
+ static void handleChunk(TelemetryDecoder &d, const TelemetrySampleFn &onSample,
+                         const TelemetryTextFn &onText)
+ {
+     TelemetrySample s;
+     size_t  maxTail  = d.len < TELEMETRY_COBS_SIZE ? d.len : TELEMETRY_COBS_SIZE;
+     size_t  frameLen = 0, badLen = 0;
+     for (size_t len = maxTail; len >= TELEMETRY_MIN_RECORD_SIZE + 3 && !frameLen; len--) {
+         uint8_t r = tryTail(d, len, s);
+         if (r == TAIL_OK) frameLen = len;
+         else if (r == TAIL_BAD_CRC && !badLen) badLen = len;
+     }
+
+     size_t textLen = d.len - (frameLen ? frameLen : badLen);
+     if (!frameLen && !badLen && !isText(d.buf, d.len)) {
+         d.stats.framingErrors++;
+         textLen = 0;
+     }
+     if (textLen || d.overflow) {
+         d.text.append((const char *)d.buf, textLen);
+         if (onText) onText(d.text);
+     }
+     d.text.clear();
+     if (!frameLen) {
+         if (badLen) d.stats.crcErrors++;
+         return;
+     }
+
+     uint16_t seq = (uint16_t)s.values[0];
+     if (d.haveSeq) d.stats.seqGaps += (uint16_t)(seq - d.lastSeq - 1);
+     d.haveSeq = true;
+     d.lastSeq = seq;
+     d.stats.frames++;
+     onSample(s);
+ }
+
+ void feedTelemetryDecoder(TelemetryDecoder &d, const uint8_t *data, size_t len,
+                           const TelemetrySampleFn &onSample, const TelemetryTextFn &onText)
+ {
+     for (size_t i = 0; i < len; i++) {
+         uint8_t b = data[i];
+         if (b == 0x00) {
+             handleChunk(d, onSample, onText);
+             d.len      = 0;
+             d.overflow = false;
+             continue;
+         }
+         if (d.len == sizeof d.buf) {
+             // Long text run: keep the tail, which may still hold a frame
+             size_t keep = TELEMETRY_COBS_SIZE;
+             d.text.append((const char *)d.buf, d.len - keep);
+             memmove(d.buf, d.buf + d.len - keep, keep);
+             d.len      = keep;
+             d.overflow = true;
+         }
+         d.buf[d.len++] = b;
+     }
+ }
+
+ /*──────────────────────── JSON ───────────────────────────────────────────*/
+ enum { FMT_INT = -1, FMT_BOOL = -2, FMT_MODE = -3 };
+
+ // reportAllStateJSON() key order and precision, plus the sequence number
+ static const struct { const char *key; int digits; } JSON_LAYOUT[] = {
+     { "seq", FMT_INT }, { "timeMs", FMT_INT },
+     { "flow", 3 }, { "setpt", 3 }, { "errorPct", 3 }, { "pidOut", 3 },
+     { "volt", 2 }, { "temp", 2 },
+     { "bubble", FMT_BOOL }, { "on", FMT_BOOL }, { "mode", FMT_MODE },
+     { "flowHold", FMT_BOOL }, { "flowFault", FMT_BOOL },
+     { "P", 3 }, { "I", 3 }, { "D", 3 },
+     { "pGain", 3 }, { "iGain", 3 }, { "dGain", 3 },
+     { "filteredErr", 3 }, { "currentAlpha", 3 },
+     { "pumpTx", FMT_INT }, { "pumpBytes", FMT_INT }, { "pumpStopFail", FMT_INT },
+     { "crcErr", FMT_INT }, { "shortRd", FMT_INT }, { "nack", FMT_INT },
+     { "outages", FMT_INT }, { "faults", FMT_INT }, { "outageMs", FMT_INT }, { "maxOutageMs", FMT_INT },
+     { "txDrop", FMT_INT }
+ };
+
+ std::string formatTelemetryJSON(const TelemetrySample &s)
+ {
+     std::string out = "{";
+     char buf[64];
+     for (const auto &k : JSON_LAYOUT) {
+         int i = telemetryFieldIndex(k.key);
+         if (i < 0 || !((s.fields >> i) & 1)) continue;
+         double v = s.values[i];
+         switch (k.digits) {
+             case FMT_INT:  snprintf(buf, sizeof buf, "%.0f", v); break;
+             case FMT_BOOL: snprintf(buf, sizeof buf, "%s", v != 0.0 ? "true" : "false"); break;
+             case FMT_MODE: snprintf(buf, sizeof buf, "%s", v != 0.0 ? "\"CONST\"" : "\"SIG\""); break;
+             default:       snprintf(buf, sizeof buf, "%.*f", k.digits, v); break;
+         }
+         if (out.size() > 1) out += ",";
+         out += "\"";
+         out += k.key;
+         out += "\":";
+         out += buf;
+     }
+     out += "}";
+     return out;
+ }
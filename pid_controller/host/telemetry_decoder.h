@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include "telemetry.h"
+
+/*
+ * File: telemetry_decoder.h
+ * Brief: Host-side decoder for the binary telemetry stream (telemetry.h).
+ *
+ *   Bytes are fed in any chunking. Each 0x00 ends a frame; the longest
+ *   tail before it that decodes to a CRC-valid record of the length its
+ *   field mask implies is the frame, anything earlier is text the
+ *   firmware printed between frames (debug lines) and is handed to the
+ *   text callback. Records are unpacked by walking TELEMETRY_FIELDS, so
+ *   values come back under the JSON keys.
+ */
+
+struct TelemetrySample {
+    uint8_t  version;
+    uint32_t fields;                           // mask of the fields present
+    double   values[TELEMETRY_FIELD_COUNT];    // TELEMETRY_FIELDS order, unscaled (0 if absent)
+};
+
+struct TelemetryDecoderStats {
+    uint32_t frames;          // valid records
+    uint32_t crcErrors;
+    uint32_t framingErrors;   // non-text chunk with no decodable frame
+    uint32_t seqGaps;         // records missing between two valid ones
+};
+
+struct TelemetryDecoder {
+    uint8_t  buf[512];
+    size_t   len;
+    bool     overflow;        // current chunk exceeded buf (text only)
+    bool     haveSeq;
+    uint16_t lastSeq;
+    std::string text;
+    TelemetryDecoderStats stats;
+};
+
+using TelemetrySampleFn = std::function<void(const TelemetrySample &)>;
+using TelemetryTextFn   = std::function<void(const std::string &)>;
+
+void initTelemetryDecoder(TelemetryDecoder &d);
+
+// Feeds a chunk of the stream; calls onSample per valid record
+void feedTelemetryDecoder(TelemetryDecoder &d, const uint8_t *data, size_t len,
+                          const TelemetrySampleFn &onSample,
+                          const TelemetryTextFn &onText = nullptr);
+
+// Unpacks one record (version byte first, CRC removed); false if malformed
+bool decodeTelemetryRecord(const uint8_t *record, size_t len, TelemetrySample &out);
+
+// The sample as the firmware's JSON telemetry line (same keys and precision,
+// present fields only)
+std::string formatTelemetryJSON(const TelemetrySample &s);
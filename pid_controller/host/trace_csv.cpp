@@ -0,0 +1,88 @@
+/*
+ * File: trace_csv.cpp
+ * Brief: Raw run CSV reader (see trace_csv.h).
+ */
+
+ #include "trace_csv.h"
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <string>
+
+ enum {
+     COL_TIME, COL_FLOW, COL_SETPT, COL_VOLT, COL_ON, COL_PID_OUT,
+     COL_P_GAIN, COL_I_GAIN, COL_D_GAIN, COL_FILTERED_ERR, COL_ALPHA, COL_COUNT
+ };
+ static const char *const COL_NAMES[COL_COUNT] = {
+     "timeMs", "flow", "setpt", "volt", "on", "pidOut",
+     "pGain", "iGain", "dGain", "filteredErr", "currentAlpha"
+ };
+
+ // Splits one line in place on ',' (the logs never quote fields)
+ static size_t splitFields(char *line, char **fields, size_t max)
+ {
+     size_t n = 0;
+     char *p = line;
+     while (n < max) {
+         fields[n++] = p;
+         p = strchr(p, ',');
+         if (!p) break;
+         *p++ = '\0';
+     }
+     char *end = fields[n - 1] + strcspn(fields[n - 1], "\r\n");
+     *end = '\0';
+     return n;
+ }
+
+ bool loadTraceCsv(const char *path, std::vector<TraceRow> &rows)
+ {
+     rows.clear();
+     FILE *f = fopen(path, "r");
+     if (!f) { fprintf(stderr, "[TRACE] cannot open %s\n", path); return false; }
+
+     static const size_t MAX_FIELDS = 64;
+     char  line[4096];
+     char *fields[MAX_FIELDS];
+     int   col[COL_COUNT];
+
+     if (!fgets(line, sizeof line, f)) { fclose(f); return false; }
+     size_t n = splitFields(line, fields, MAX_FIELDS);
+     for (int c = 0; c < COL_COUNT; c++) {
+         col[c] = -1;
+         for (size_t i = 0; i < n; i++)
+             if (!strcmp(fields[i], COL_NAMES[c])) col[c] = (int)i;
+         if (col[c] < 0) {
+             fprintf(stderr, "[TRACE] %s: no '%s' column\n", path, COL_NAMES[c]);
+             fclose(f);
+             return false;
+         }
+     }
+
+     bool wasOn = false;
+     while (fgets(line, sizeof line, f)) {
+         n = splitFields(line, fields, MAX_FIELDS);
+         bool complete = true;
+         for (int c = 0; c < COL_COUNT; c++) complete &= col[c] < (int)n;
+         if (!complete) continue;
+
+         bool on = !strcmp(fields[col[COL_ON]], "True");
+         if (!on) { wasOn = false; continue; }
+
+         TraceRow r;
+         r.timeMs       = (uint32_t)strtoul(fields[col[COL_TIME]], nullptr, 10);
+         r.flow         = strtof(fields[col[COL_FLOW]], nullptr);
+         r.setpoint     = strtof(fields[col[COL_SETPT]], nullptr);
+         r.volt         = strtof(fields[col[COL_VOLT]], nullptr);
+         r.pidOut       = strtof(fields[col[COL_PID_OUT]], nullptr);
+         r.pGain        = strtof(fields[col[COL_P_GAIN]], nullptr);
+         r.iGain        = strtof(fields[col[COL_I_GAIN]], nullptr);
+         r.dGain        = strtof(fields[col[COL_D_GAIN]], nullptr);
+         r.filteredErr  = strtof(fields[col[COL_FILTERED_ERR]], nullptr);
+         r.currentAlpha = strtof(fields[col[COL_ALPHA]], nullptr);
+         r.segmentStart = !wasOn;
+         rows.push_back(r);
+         wasOn = true;
+     }
+     fclose(f);
+     return true;
+ }
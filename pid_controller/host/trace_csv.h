@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+/*
+ * File: trace_csv.h
+ * Brief: Reader for the raw run CSVs the GUI records
+ *        (<run>/raw/data/raw_<run>.csv).
+ *
+ *   Columns are found by header name, so older and newer logs both load.
+ *   Only the rows with the system on are kept; `segmentStart` marks the
+ *   first row after an off → on edge, where the firmware re-initialises
+ *   the controller. Logged flow is already compensated by errorPct,
+ *   which is what the controller saw.
+ */
+
+struct TraceRow {
+    uint32_t timeMs;          // controller millis()
+    float    flow;
+    float    setpoint;
+    float    volt;
+    float    pidOut;
+    float    pGain, iGain, dGain;
+    float    filteredErr;
+    float    currentAlpha;
+    bool     segmentStart;
+};
+
+// Returns false (and prints why to stderr) if the file or a column is missing
+bool loadTraceCsv(const char *path, std::vector<TraceRow> &rows);
@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * File: work_stealing.h
+ * Brief: Runs jobs 0..count-1 on a fixed set of threads with work stealing.
+ *
+ *   Each worker starts with an equal contiguous slice and takes jobs from
+ *   its front. A worker that runs dry steals the back half of the slice of
+ *   the worker with the most jobs left, so uneven job costs (runs that
+ *   settle late, rejected parameter sets) still finish together. Slices
+ *   are guarded by per-worker mutexes held for a few instructions only.
+ */
+
+class WorkStealingPool {
+public:
+    using Job = std::function<void(uint32_t job, uint32_t worker)>;
+
+    explicit WorkStealingPool(uint32_t threads)
+        : slices_(threads ? threads : 1) {}
+
+    uint32_t threads() const { return (uint32_t)slices_.size(); }
+    uint64_t steals() const  { return steals_.load(); }
+
+    void run(uint32_t count, const Job &job)
+    {
+        uint32_t n = threads();
+        for (uint32_t w = 0; w < n; w++) {
+            slices_[w].next = (uint32_t)((uint64_t)count * w / n);
+            slices_[w].end  = (uint32_t)((uint64_t)count * (w + 1) / n);
+        }
+
+        std::vector<std::thread> pool;
+        for (uint32_t w = 1; w < n; w++) pool.emplace_back([this, w, &job] { work(w, job); });
+        work(0, job);
+        for (auto &t : pool) t.join();
+    }
+
+private:
+    struct Slice {
+        std::mutex m;
+        uint32_t   next = 0;
+        uint32_t   end  = 0;
+    };
+
+    bool takeOwn(uint32_t w, uint32_t &job)
+    {
+        std::lock_guard<std::mutex> lock(slices_[w].m);
+        if (slices_[w].next >= slices_[w].end) return false;
+        job = slices_[w].next++;
+        return true;
+    }
+
+    // Moves the back half of the fullest other slice into slice w
+    bool steal(uint32_t w)
+    {
+        for (;;) {
+            uint32_t victim = w, most = 0;
+            for (uint32_t v = 0; v < threads(); v++) {
+                if (v == w) continue;
+                std::lock_guard<std::mutex> lock(slices_[v].m);
+                uint32_t left = slices_[v].end - slices_[v].next;
+                if (left > most) { most = left; victim = v; }
+            }
+            if (most == 0) return false;
+
+            uint32_t from, to;
+            {
+                std::lock_guard<std::mutex> lock(slices_[victim].m);
+                uint32_t left = slices_[victim].end - slices_[victim].next;
+                if (left == 0) continue;              // drained meanwhile; look again
+                to   = slices_[victim].end;
+                from = to - (left + 1) / 2;
+                slices_[victim].end = from;
+            }
+            std::lock_guard<std::mutex> lock(slices_[w].m);
+            slices_[w].next = from;
+            slices_[w].end  = to;
+            steals_++;
+            return true;
+        }
+    }
+
+    void work(uint32_t w, const Job &job)
+    {
+        uint32_t j;
+        for (;;) {
+            if (takeOwn(w, j)) { job(j, w); continue; }
+            if (!steal(w)) return;
+        }
+    }
+
+    std::vector<Slice>    slices_;
+    std::atomic<uint64_t> steals_{0};
+};